@@ -1,6 +1,15 @@
 TEMPLATE = subdirs
 
-SUBDIRS += AudioWaveformToneGenerator cpputils cpp-template-utils
+SUBDIRS += AudioWaveformToneGenerator ToneBatchRenderer ToneControlServer ToneTests cpputils cpp-template-utils
 
 AudioWaveformToneGenerator.file = app/AudioWaveformToneGenerator.pro
 AudioWaveformToneGenerator.depends = cpputils cpp-template-utils
+
+ToneBatchRenderer.file = app/ToneBatchRenderer.pro
+ToneBatchRenderer.depends = cpputils cpp-template-utils
+
+ToneControlServer.file = app/ToneControlServer.pro
+ToneControlServer.depends = cpputils cpp-template-utils
+
+ToneTests.file = app/ToneTests.pro
+ToneTests.depends = cpputils cpp-template-utils
@@ -17,6 +17,9 @@ mac* | linux* | freebsd{
 	CONFIG(debug, debug|release):CONFIG *= Debug
 }
 
+# Debug builds count the heap allocations per thread and assert if the render callback allocates (see allocationcounter.h).
+CONFIG(debug, debug|release):DEFINES += AUDIO_COUNT_ALLOCATIONS
+
 contains(QT_ARCH, x86_64) {
 	ARCHITECTURE = x64
 } else {
@@ -56,17 +59,70 @@ INCLUDEPATH += \
 ###################################################
 
 HEADERS += \
-	src/audio/caudiooutputwasapi.h \
-	src/cmainwindow.h
+	src/audio/allocationcounter.h \
+	src/audio/audioformat.h \
+	src/audio/audiosamplesbuffer.h \
+	src/audio/caudiobackend.h \
+	src/audio/caudiobackendnull.h \
+	src/audio/caudiobackendwavfile.h \
+	src/audio/caudiocapture.h \
+	src/audio/caudioengine.h \
+	src/audio/ccaptureanalyzer.h \
+	src/audio/cdeviceregistry.h \
+	src/audio/cglitchmonitor.h \
+	src/audio/channelgains.h \
+	src/audio/fft.h \
+	src/audio/glitchdetector.h \
+	src/audio/mpscringbuffer.hpp \
+	src/audio/noise.h \
+	src/audio/oscillator.h \
+	src/audio/oscillatorbank.h \
+	src/audio/realtimethread.h \
+	src/audio/renderstats.h \
+	src/audio/samplewriter.h \
+	src/audio/scheduledchange.h \
+	src/audio/sequence.h \
+	src/audio/simd.h \
+	src/audio/spectrumanalyzer.h \
+	src/audio/spscringbuffer.hpp \
+	src/audio/tonekernel.h \
+	src/audio/triplebuffer.hpp \
+	src/audio/wavetable.h \
+	src/audio/wavfilewriter.h \
+	src/cmainwindow.h \
+	src/waveformenvelope.h
 
 ###################################################
 #                 SOURCES
 ###################################################
 
 SOURCES += \
-	src/audio/caudiooutputwasapi.cpp \
+	src/audio/allocationcounter.cpp \
+	src/audio/caudiobackend.cpp \
+	src/audio/caudiobackendnull.cpp \
+	src/audio/caudiobackendwavfile.cpp \
+	src/audio/caudiocapture.cpp \
+	src/audio/caudioengine.cpp \
+	src/audio/ccaptureanalyzer.cpp \
+	src/audio/cdeviceregistry.cpp \
+	src/audio/cglitchmonitor.cpp \
+	src/audio/channelgains.cpp \
+	src/audio/fft.cpp \
+	src/audio/glitchdetector.cpp \
+	src/audio/noise.cpp \
+	src/audio/oscillator.cpp \
+	src/audio/oscillatorbank.cpp \
+	src/audio/realtimethread.cpp \
+	src/audio/renderstats.cpp \
+	src/audio/samplewriter.cpp \
+	src/audio/sequence.cpp \
+	src/audio/spectrumanalyzer.cpp \
+	src/audio/tonekernel.cpp \
+	src/audio/wavetable.cpp \
+	src/audio/wavfilewriter.cpp \
 	src/cmainwindow.cpp \
-	src/main.cpp
+	src/main.cpp \
+	src/waveformenvelope.cpp
 
 ###################################################
 #                 LIBS
@@ -84,7 +140,16 @@ mac*|linux*|freebsd{
 ###################################################
 
 win*{
-	LIBS += -lole32
+	HEADERS += \
+		src/audio/caudiocapturewasapi.h \
+		src/audio/caudiooutputwasapi.h \
+		src/audio/wasapiutils.h
+	SOURCES += \
+		src/audio/caudiocapturewasapi.cpp \
+		src/audio/caudiooutputwasapi.cpp \
+		src/audio/wasapiutils.cpp
+
+	LIBS += -lole32 -lavrt
 	QMAKE_CXXFLAGS += /MP /Zi /FS /wd4251
 	QMAKE_CXXFLAGS += /std:c++latest /permissive- /Zc:__cplusplus
 	QMAKE_CXXFLAGS_WARN_ON = /W4
@@ -98,6 +163,19 @@ win*{
 	INCLUDEPATH += $${PWD}/../wil/include
 }
 
+linux*{
+	HEADERS += \
+		src/audio/alsautils.h \
+		src/audio/caudiobackendalsa.h \
+		src/audio/caudiocapturealsa.h
+	SOURCES += \
+		src/audio/alsautils.cpp \
+		src/audio/caudiobackendalsa.cpp \
+		src/audio/caudiocapturealsa.cpp
+
+	LIBS += -lasound
+}
+
 mac*{
 	LIBS += -framework AppKit
 
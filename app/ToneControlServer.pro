@@ -0,0 +1,176 @@
+###################################################
+#            Basic configuration
+###################################################
+
+TEMPLATE = app
+TARGET   = ToneControlServer
+
+CONFIG -= qt
+CONFIG += console
+
+CONFIG += strict_c++ c++2a
+
+mac* | linux* | freebsd{
+	CONFIG(release, debug|release):CONFIG *= Release optimize_full
+	CONFIG(debug, debug|release):CONFIG *= Debug
+}
+
+# Debug builds count the heap allocations per thread and assert if the render callback allocates (see allocationcounter.h).
+CONFIG(debug, debug|release):DEFINES += AUDIO_COUNT_ALLOCATIONS
+
+contains(QT_ARCH, x86_64) {
+	ARCHITECTURE = x64
+} else {
+	ARCHITECTURE = x86
+}
+
+android {
+	Release:OUTPUT_DIR=android/release
+	Debug:OUTPUT_DIR=android/debug
+
+} else:ios {
+	Release:OUTPUT_DIR=ios/release
+	Debug:OUTPUT_DIR=ios/debug
+
+} else {
+	Release:OUTPUT_DIR=release/$${ARCHITECTURE}
+	Debug:OUTPUT_DIR=debug/$${ARCHITECTURE}
+}
+
+DESTDIR  = ../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../build/$${OUTPUT_DIR}/$${TARGET}
+
+###################################################
+#               INCLUDEPATH
+###################################################
+
+INCLUDEPATH += \
+	../qtutils \
+	../cpputils \
+	../cpp-template-utils
+
+###################################################
+#                 HEADERS
+###################################################
+
+HEADERS += \
+	src/audio/allocationcounter.h \
+	src/audio/audioformat.h \
+	src/audio/audiosamplesbuffer.h \
+	src/audio/caudiobackend.h \
+	src/audio/caudiobackendnull.h \
+	src/audio/caudioengine.h \
+	src/audio/cdeviceregistry.h \
+	src/audio/cglitchmonitor.h \
+	src/audio/channelgains.h \
+	src/audio/glitchdetector.h \
+	src/audio/mpscringbuffer.hpp \
+	src/audio/noise.h \
+	src/audio/oscillator.h \
+	src/audio/oscillatorbank.h \
+	src/audio/realtimethread.h \
+	src/audio/renderstats.h \
+	src/audio/samplewriter.h \
+	src/audio/scheduledchange.h \
+	src/audio/sequence.h \
+	src/audio/simd.h \
+	src/audio/spscringbuffer.hpp \
+	src/audio/tonekernel.h \
+	src/audio/triplebuffer.hpp \
+	src/audio/wavetable.h \
+	src/controlserver/ccontrolserver.h \
+	src/controlserver/controlprotocol.h
+
+###################################################
+#                 SOURCES
+###################################################
+
+SOURCES += \
+	src/audio/allocationcounter.cpp \
+	src/audio/caudiobackend.cpp \
+	src/audio/caudiobackendnull.cpp \
+	src/audio/caudioengine.cpp \
+	src/audio/cdeviceregistry.cpp \
+	src/audio/cglitchmonitor.cpp \
+	src/audio/channelgains.cpp \
+	src/audio/glitchdetector.cpp \
+	src/audio/noise.cpp \
+	src/audio/oscillator.cpp \
+	src/audio/oscillatorbank.cpp \
+	src/audio/realtimethread.cpp \
+	src/audio/renderstats.cpp \
+	src/audio/samplewriter.cpp \
+	src/audio/sequence.cpp \
+	src/audio/tonekernel.cpp \
+	src/audio/wavetable.cpp \
+	src/controlserver/ccontrolserver.cpp \
+	src/controlserver/controlprotocol.cpp \
+	src/controlserver/main.cpp
+
+###################################################
+#                 LIBS
+###################################################
+
+
+LIBS += -L../bin/$${OUTPUT_DIR} -lcpputils
+
+mac*|linux*|freebsd{
+	PRE_TARGETDEPS += $${DESTDIR}/libcpputils.a
+}
+
+###################################################
+#    Platform-specific compiler options and libs
+###################################################
+
+win*{
+	HEADERS += \
+		src/audio/caudiooutputwasapi.h \
+		src/audio/wasapiutils.h
+	SOURCES += \
+		src/audio/caudiooutputwasapi.cpp \
+		src/audio/wasapiutils.cpp
+
+	LIBS += -lole32 -lavrt -lws2_32
+	QMAKE_CXXFLAGS += /MP /Zi /FS /wd4251
+	QMAKE_CXXFLAGS += /std:c++latest /permissive- /Zc:__cplusplus
+	QMAKE_CXXFLAGS_WARN_ON = /W4
+	DEFINES += WIN32_LEAN_AND_MEAN NOMINMAX _SCL_SECURE_NO_WARNINGS
+
+	QMAKE_LFLAGS += /DEBUG:FASTLINK
+
+	Debug:QMAKE_LFLAGS += /INCREMENTAL
+	Release:QMAKE_LFLAGS += /OPT:REF /OPT:ICF
+
+	INCLUDEPATH += $${PWD}/../wil/include
+}
+
+linux*{
+	HEADERS += \
+		src/audio/alsautils.h \
+		src/audio/caudiobackendalsa.h
+	SOURCES += \
+		src/audio/alsautils.cpp \
+		src/audio/caudiobackendalsa.cpp
+
+	LIBS += -lasound
+}
+
+mac*{
+	LIBS += -framework AppKit
+
+	#QMAKE_POST_LINK = cp -f -p $$PWD/$$DESTDIR/*.dylib $$PWD/$$DESTDIR/$${TARGET}.app/Contents/MacOS/
+}
+
+###################################################
+#      Generic stuff for Linux and Mac
+###################################################
+
+linux*|mac*|freebsd{
+	QMAKE_CXXFLAGS_WARN_ON = -Wall -Wno-c++11-extensions -Wno-local-type-template-args -Wno-deprecated-register
+
+	Release:DEFINES += NDEBUG=1
+	Debug:DEFINES += _DEBUG
+}
@@ -0,0 +1,173 @@
+###################################################
+#            Basic configuration
+###################################################
+
+TEMPLATE = app
+TARGET   = ToneTests
+
+CONFIG -= qt
+CONFIG += console
+
+CONFIG += strict_c++ c++2a
+
+mac* | linux* | freebsd{
+	CONFIG(release, debug|release):CONFIG *= Release optimize_full
+	CONFIG(debug, debug|release):CONFIG *= Debug
+}
+
+# The tests check the allocation counts, so the counting is on in every configuration.
+DEFINES += AUDIO_COUNT_ALLOCATIONS
+
+contains(QT_ARCH, x86_64) {
+	ARCHITECTURE = x64
+} else {
+	ARCHITECTURE = x86
+}
+
+android {
+	Release:OUTPUT_DIR=android/release
+	Debug:OUTPUT_DIR=android/debug
+
+} else:ios {
+	Release:OUTPUT_DIR=ios/release
+	Debug:OUTPUT_DIR=ios/debug
+
+} else {
+	Release:OUTPUT_DIR=release/$${ARCHITECTURE}
+	Debug:OUTPUT_DIR=debug/$${ARCHITECTURE}
+}
+
+DESTDIR  = ../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../build/$${OUTPUT_DIR}/$${TARGET}
+
+###################################################
+#               INCLUDEPATH
+###################################################
+
+INCLUDEPATH += \
+	../qtutils \
+	../cpputils \
+	../cpp-template-utils
+
+###################################################
+#                 HEADERS
+###################################################
+
+HEADERS += \
+	src/audio/allocationcounter.h \
+	src/audio/audioformat.h \
+	src/audio/audiosamplesbuffer.h \
+	src/audio/caudiobackend.h \
+	src/audio/caudiobackendnull.h \
+	src/audio/caudiobackendwavfile.h \
+	src/audio/caudioengine.h \
+	src/audio/cdeviceregistry.h \
+	src/audio/cglitchmonitor.h \
+	src/audio/channelgains.h \
+	src/audio/fft.h \
+	src/audio/glitchdetector.h \
+	src/audio/mpscringbuffer.hpp \
+	src/audio/noise.h \
+	src/audio/oscillator.h \
+	src/audio/oscillatorbank.h \
+	src/audio/realtimethread.h \
+	src/audio/renderstats.h \
+	src/audio/samplewriter.h \
+	src/audio/scheduledchange.h \
+	src/audio/sequence.h \
+	src/audio/simd.h \
+	src/audio/spscringbuffer.hpp \
+	src/audio/tonekernel.h \
+	src/audio/triplebuffer.hpp \
+	src/audio/wavetable.h \
+	src/audio/wavfilewriter.h \
+	src/controlserver/ccontrolserver.h \
+	src/controlserver/controlprotocol.h \
+	src/tests/testframework.h \
+	src/waveformenvelope.h
+
+###################################################
+#                 SOURCES
+###################################################
+
+SOURCES += \
+	src/audio/allocationcounter.cpp \
+	src/audio/caudiobackendnull.cpp \
+	src/audio/caudiobackendwavfile.cpp \
+	src/audio/caudioengine.cpp \
+	src/audio/cdeviceregistry.cpp \
+	src/audio/cglitchmonitor.cpp \
+	src/audio/channelgains.cpp \
+	src/audio/fft.cpp \
+	src/audio/glitchdetector.cpp \
+	src/audio/noise.cpp \
+	src/audio/oscillator.cpp \
+	src/audio/oscillatorbank.cpp \
+	src/audio/realtimethread.cpp \
+	src/audio/renderstats.cpp \
+	src/audio/samplewriter.cpp \
+	src/audio/sequence.cpp \
+	src/audio/tonekernel.cpp \
+	src/audio/wavetable.cpp \
+	src/audio/wavfilewriter.cpp \
+	src/controlserver/ccontrolserver.cpp \
+	src/controlserver/controlprotocol.cpp \
+	src/tests/audioenginetests.cpp \
+	src/tests/controlservertests.cpp \
+	src/tests/main.cpp \
+	src/tests/noisetests.cpp \
+	src/tests/oscillatorbanktests.cpp \
+	src/tests/samplewritertests.cpp \
+	src/tests/sequencetests.cpp \
+	src/tests/testframework.cpp \
+	src/tests/tonekerneltests.cpp \
+	src/tests/triplebuffertests.cpp \
+	src/tests/waveformenvelopetests.cpp \
+	src/tests/wavfilewritertests.cpp \
+	src/waveformenvelope.cpp
+
+###################################################
+#                 LIBS
+###################################################
+
+
+LIBS += -L../bin/$${OUTPUT_DIR} -lcpputils
+
+mac*|linux*|freebsd{
+	PRE_TARGETDEPS += $${DESTDIR}/libcpputils.a
+}
+
+###################################################
+#    Platform-specific compiler options and libs
+###################################################
+
+win*{
+	LIBS += -lole32 -lavrt -lws2_32
+	QMAKE_CXXFLAGS += /MP /Zi /FS /wd4251
+	QMAKE_CXXFLAGS += /std:c++latest /permissive- /Zc:__cplusplus
+	QMAKE_CXXFLAGS_WARN_ON = /W4
+	DEFINES += WIN32_LEAN_AND_MEAN NOMINMAX _SCL_SECURE_NO_WARNINGS
+
+	QMAKE_LFLAGS += /DEBUG:FASTLINK
+
+	Debug:QMAKE_LFLAGS += /INCREMENTAL
+	Release:QMAKE_LFLAGS += /OPT:REF /OPT:ICF
+}
+
+mac*{
+	LIBS += -framework AppKit
+}
+
+###################################################
+#      Generic stuff for Linux and Mac
+###################################################
+
+linux*|mac*|freebsd{
+	QMAKE_CXXFLAGS_WARN_ON = -Wall -Wno-c++11-extensions -Wno-local-type-template-args -Wno-deprecated-register
+
+	Release:DEFINES += NDEBUG=1
+	Debug:DEFINES += _DEBUG
+}
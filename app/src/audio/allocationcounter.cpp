@@ -0,0 +1,113 @@
+#include "allocationcounter.h"
+
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+static std::atomic<uint64_t> guardedAllocationCount = 0;
+
+#ifdef AUDIO_COUNT_ALLOCATIONS
+
+// Zero-initialized, so that touching it doesn't allocate.
+static thread_local uint64_t threadAllocationCount = 0;
+
+// The array and nothrow forms call these.
+void* operator new(const std::size_t size)
+{
+	++threadAllocationCount;
+	if (void* p = std::malloc(size == 0 ? 1 : size))
+		return p;
+
+	throw std::bad_alloc{};
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+	++threadAllocationCount;
+	const auto align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+	if (void* p = _aligned_malloc(size == 0 ? 1 : size, align))
+		return p;
+#else
+	// aligned_alloc() wants the size to be a multiple of the alignment.
+	if (void* p = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align))
+		return p;
+#endif
+
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+void operator delete(void* p, std::size_t, const std::align_val_t alignment) noexcept
+{
+	operator delete(p, alignment);
+}
+
+bool AllocationCounter::isEnabled() noexcept
+{
+	return true;
+}
+
+uint64_t AllocationCounter::threadAllocations() noexcept
+{
+	return threadAllocationCount;
+}
+
+#else
+
+bool AllocationCounter::isEnabled() noexcept
+{
+	return false;
+}
+
+uint64_t AllocationCounter::threadAllocations() noexcept
+{
+	return 0;
+}
+
+#endif
+
+uint64_t AllocationCounter::guardedAllocations() noexcept
+{
+	return guardedAllocationCount.load(std::memory_order_relaxed);
+}
+
+AllocationGuard::AllocationGuard(const char* scopeName, const bool armed) noexcept :
+	_scopeName{ scopeName },
+	_allocationsBefore{ AllocationCounter::threadAllocations() },
+	_bArmed{ armed }
+{
+}
+
+AllocationGuard::~AllocationGuard() noexcept
+{
+	if (!_bArmed)
+		return;
+
+	// Reporting allocates, which is fine at this point.
+	const uint64_t n = AllocationCounter::threadAllocations() - _allocationsBefore;
+	guardedAllocationCount.fetch_add(n, std::memory_order_relaxed);
+	assert_message_r(n == 0, std::string{ _scopeName } + " has made " + std::to_string(n) + " heap allocations");
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+// Counts the heap allocations made by every thread, so that the real-time paths can check that they don't allocate once warmed up.
+// Only builds with AUDIO_COUNT_ALLOCATIONS defined (the debug ones) count: they replace the global operator new and delete.
+// Elsewhere the counts stay at 0 and AllocationGuard never fires.
+namespace AllocationCounter {
+	[[nodiscard]] bool isEnabled() noexcept;
+	// The calling thread's allocations so far.
+	[[nodiscard]] uint64_t threadAllocations() noexcept;
+	// The allocations caught by armed AllocationGuards so far, on all threads; for tests to fail on.
+	[[nodiscard]] uint64_t guardedAllocations() noexcept;
+}
+
+// Asserts if the calling thread allocates between the guard's construction and destruction. A guard that isn't armed checks nothing,
+// which is what the warm-up calls of a real-time path use.
+class AllocationGuard
+{
+public:
+	explicit AllocationGuard(const char* scopeName, bool armed = true) noexcept;
+	~AllocationGuard() noexcept;
+
+	AllocationGuard(const AllocationGuard&) = delete;
+	AllocationGuard& operator=(const AllocationGuard&) = delete;
+
+private:
+	const char* const _scopeName;
+	const uint64_t _allocationsBefore;
+	const bool _bArmed;
+};
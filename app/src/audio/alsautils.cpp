@@ -0,0 +1,160 @@
+#include "alsautils.h"
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <string_view>
+
+namespace {
+
+struct PcmFormat {
+	snd_pcm_format_t alsaFormat;
+	decltype(AudioFormat::sampleFormat) sampleFormat;
+	uint16_t bitsPerSample;
+};
+
+// In the order of preference. S24_LE is not listed: ALSA keeps its 24 bits in the low end of the container, unlike WASAPI.
+constexpr auto pcmFormats = std::to_array<PcmFormat>({
+	{ SND_PCM_FORMAT_FLOAT_LE, AudioFormat::Float, 32 },
+	{ SND_PCM_FORMAT_S32_LE, AudioFormat::PCM, 32 },
+	{ SND_PCM_FORMAT_S24_3LE, AudioFormat::PCM, 24 },
+	{ SND_PCM_FORMAT_S16_LE, AudioFormat::PCM, 16 }
+});
+
+constexpr unsigned int preferredSampleRate = 48000;
+constexpr unsigned int maxChannels = 8;
+
+} // namespace
+
+std::wstring fromUtf8(const char* str)
+{
+	std::wstring result;
+	for (auto p = reinterpret_cast<const unsigned char*>(str); *p != 0; )
+	{
+		const unsigned char lead = *p++;
+		int nContinuation = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+		uint32_t codePoint = nContinuation == 0 ? lead : lead & (0x3Fu >> nContinuation);
+		for (; nContinuation > 0 && (*p & 0xC0) == 0x80; --nContinuation)
+			codePoint = (codePoint << 6) | (*p++ & 0x3Fu);
+
+		result.push_back(static_cast<wchar_t>(codePoint));
+	}
+
+	return result;
+}
+
+std::string toUtf8(const std::wstring& str)
+{
+	std::string result;
+	for (const wchar_t ch : str)
+	{
+		const auto codePoint = static_cast<uint32_t>(ch);
+		if (codePoint < 0x80)
+			result.push_back(static_cast<char>(codePoint));
+		else if (codePoint < 0x800)
+		{
+			result.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+			result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		else if (codePoint < 0x10000)
+		{
+			result.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+			result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		else
+		{
+			result.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+			result.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+			result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+	}
+
+	return result;
+}
+
+std::string alsaErrorString(const int error)
+{
+	return snd_strerror(error);
+}
+
+snd_pcm_t* openPcm(const std::wstring& deviceId, const snd_pcm_stream_t direction, const bool exclusive, const int extraFlags)
+{
+	const int flags = extraFlags | (exclusive ? SND_PCM_NO_AUTO_RESAMPLE | SND_PCM_NO_AUTO_CHANNELS | SND_PCM_NO_AUTO_FORMAT : 0);
+
+	snd_pcm_t* pcm = nullptr;
+	const int err = snd_pcm_open(&pcm, toUtf8(deviceId).c_str(), direction, flags);
+	assert_and_return_message_r(err >= 0, "snd_pcm_open error: " + alsaErrorString(err), nullptr);
+	return pcm;
+}
+
+bool chooseFormat(snd_pcm_t* pcm, snd_pcm_hw_params_t* hw, const bool exclusive, AudioFormat& format)
+{
+	int err = snd_pcm_hw_params_any(pcm, hw);
+	assert_and_return_message_r(err >= 0, "snd_pcm_hw_params_any error: " + alsaErrorString(err), false);
+
+	err = snd_pcm_hw_params_set_access(pcm, hw, SND_PCM_ACCESS_RW_INTERLEAVED);
+	assert_and_return_message_r(err >= 0, "snd_pcm_hw_params_set_access error: " + alsaErrorString(err), false);
+
+	snd_pcm_hw_params_set_rate_resample(pcm, hw, exclusive ? 0 : 1);
+
+	const auto pcmFormat = std::find_if(pcmFormats.begin(), pcmFormats.end(), [pcm, hw](const PcmFormat& f) {
+		return snd_pcm_hw_params_test_format(pcm, hw, f.alsaFormat) == 0;
+	});
+	assert_and_return_message_r(pcmFormat != pcmFormats.end(), "The device supports none of the known sample formats", false);
+
+	err = snd_pcm_hw_params_set_format(pcm, hw, pcmFormat->alsaFormat);
+	assert_and_return_message_r(err >= 0, "snd_pcm_hw_params_set_format error: " + alsaErrorString(err), false);
+
+	unsigned int nChannels = 0;
+	snd_pcm_hw_params_get_channels_max(hw, &nChannels);
+	nChannels = std::clamp(nChannels, 1u, maxChannels);
+	err = snd_pcm_hw_params_set_channels_near(pcm, hw, &nChannels);
+	assert_and_return_message_r(err >= 0, "snd_pcm_hw_params_set_channels_near error: " + alsaErrorString(err), false);
+
+	unsigned int sampleRate = preferredSampleRate;
+	err = snd_pcm_hw_params_set_rate_near(pcm, hw, &sampleRate, nullptr);
+	assert_and_return_message_r(err >= 0, "snd_pcm_hw_params_set_rate_near error: " + alsaErrorString(err), false);
+
+	format = {};
+	format.sampleFormat = pcmFormat->sampleFormat;
+	format.bitsPerSample = pcmFormat->bitsPerSample;
+	format.validBitsPerSample = pcmFormat->bitsPerSample;
+	format.sampleRate = sampleRate;
+	for (size_t c = 0; c < nChannels; ++c)
+		format.channels.emplace_back("Channel " + std::to_string(c + 1), c);
+
+	return true;
+}
+
+std::vector<AudioDeviceInfo> pcmDevices(const char* direction)
+{
+	void** hints = nullptr;
+	const int err = snd_device_name_hint(-1, "pcm", &hints);
+	assert_and_return_message_r(err >= 0, "snd_device_name_hint error: " + alsaErrorString(err), {});
+
+	std::vector<AudioDeviceInfo> devices;
+	for (void** hint = hints; *hint != nullptr; ++hint)
+	{
+		char* name = snd_device_name_get_hint(*hint, "NAME");
+		char* description = snd_device_name_get_hint(*hint, "DESC");
+		char* ioid = snd_device_name_get_hint(*hint, "IOID");
+
+		// IOID is absent for devices that support both directions.
+		if (name && (!ioid || std::string_view{ ioid } == direction))
+		{
+			std::wstring friendlyName = description ? fromUtf8(description) : fromUtf8(name);
+			std::replace(friendlyName.begin(), friendlyName.end(), L'\n', L' ');
+			devices.emplace_back(fromUtf8(name), friendlyName);
+		}
+
+		::free(name);
+		::free(description);
+		::free(ioid);
+	}
+
+	snd_device_name_free_hint(hints);
+	return devices;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "audioformat.h"
+
+#include <alsa/asoundlib.h>
+
+#include <string>
+#include <vector>
+
+// Shared by the ALSA playback and capture backends.
+
+// ALSA strings are UTF-8, device IDs are passed around as wide strings (wchar_t is UTF-32 on Linux).
+[[nodiscard]] std::wstring fromUtf8(const char* str);
+[[nodiscard]] std::string toUtf8(const std::wstring& str);
+
+[[nodiscard]] std::string alsaErrorString(int error);
+
+// The PCM devices that support the direction ("Output" or "Input").
+[[nodiscard]] std::vector<AudioDeviceInfo> pcmDevices(const char* direction);
+
+// exclusive disables the automatic rate / channel / format conversions.
+[[nodiscard]] snd_pcm_t* openPcm(const std::wstring& deviceId, snd_pcm_stream_t direction, bool exclusive, int extraFlags = 0);
+
+// Narrows the hardware configuration space down to one access mode, sample format, channel count and rate.
+bool chooseFormat(snd_pcm_t* pcm, snd_pcm_hw_params_t* hw, bool exclusive, AudioFormat& format);
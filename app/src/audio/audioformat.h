@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct ChannelInfo {
+	std::string name;
+	size_t index;
+};
+
+struct AudioFormat {
+	std::vector<ChannelInfo> channels;
+
+	uint32_t sampleRate = 0;
+	enum {PCM, Float} sampleFormat;
+	uint16_t bitsPerSample = 0;
+	// The number of significant bits in the bitsPerSample-wide container (e. g. 24-in-32), 0 if they're the same.
+	uint16_t validBitsPerSample = 0;
+};
+
+// Whether a buffer rendered for one format can be played as is in the other one. The channel names don't matter.
+inline bool sameSampleLayout(const AudioFormat& a, const AudioFormat& b) noexcept
+{
+	return a.channels.size() == b.channels.size() && a.sampleRate == b.sampleRate && a.sampleFormat == b.sampleFormat
+		&& a.bitsPerSample == b.bitsPerSample && a.validBitsPerSample == b.validBitsPerSample;
+}
+
+struct AudioDeviceInfo {
+	const std::wstring id;
+	const std::wstring friendlyName;
+};
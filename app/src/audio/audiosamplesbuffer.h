@@ -0,0 +1,96 @@
+#pragma once
+#include "spscringbuffer.hpp"
+
+#include "assert/advanced_assert.h"
+#include "container/vector2d.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Monitoring tap: the render thread pushes the interleaved frames it has just produced,
+// the consumer periodically takes the most recent window and deinterleaves it on its own thread.
+template <typename T>
+struct AudioSamplesBuffer {
+	// Preallocates the storage. Must be called before the stream starts, not on the render thread.
+	void reset(const size_t nChannels, const size_t capacityFrames)
+	{
+		_nChannels = nChannels;
+		_ring.reset(nChannels * capacityFrames);
+		_overruns = 0;
+		_droppedFrames = 0;
+	}
+
+	// Producer (render thread): a memcpy into the ring, no locks or allocations.
+	// If the consumer has fallen behind, the whole block is dropped and accounted for, and false is returned.
+	bool setData(const void* dataPtr, const size_t nFrames, const size_t nChannels) noexcept
+	{
+		assert_debug_only(nChannels == _nChannels);
+		if (_ring.push(static_cast<const T*>(dataPtr), nFrames * nChannels))
+			return true;
+
+		_overruns.fetch_add(1, std::memory_order_relaxed);
+		_droppedFrames.fetch_add(nFrames, std::memory_order_relaxed);
+		return false;
+	}
+
+	// Consumer: deinterleaves up to maxFrames of the most recent frames into out (channels x frames), discarding anything older.
+	// Returns false and leaves out untouched if no new frames have arrived since the last call.
+	// Allocates only when out or the window grow, i.e. not at all once the window size has settled.
+	bool samples(vector2D<T>& out, const size_t maxFrames)
+	{
+		if (_nChannels == 0)
+			return false;
+
+		const size_t availableFrames = _ring.available() / _nChannels;
+		if (availableFrames == 0)
+			return false;
+
+		const size_t nFrames = std::min(availableFrames, maxFrames);
+		_ring.skip((availableFrames - nFrames) * _nChannels);
+
+		_window.resize(nFrames * _nChannels);
+		_ring.pop(_window.data(), _window.size());
+
+		if (out.height() != _nChannels || out.width() != nFrames)
+			out.resize(_nChannels, nFrames);
+		for (size_t c = 0; c < _nChannels; ++c)
+		{
+			T* channel = out[c];
+			for (size_t i = 0; i < nFrames; ++i)
+				channel[i] = _window[i * _nChannels + c];
+		}
+
+		return true;
+	}
+
+	// The number of times the producer found the ring full, and the total number of frames lost to that.
+	[[nodiscard]] uint64_t overruns() const noexcept {
+		return _overruns.load(std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] uint64_t droppedFrames() const noexcept {
+		return _droppedFrames.load(std::memory_order_relaxed);
+	}
+
+	// The ring the producer writes to; valid until the next reset().
+	[[nodiscard]] const void* storage() const noexcept {
+		return _ring.data();
+	}
+
+	[[nodiscard]] size_t storageSize() const noexcept {
+		return _ring.capacity() * sizeof(T);
+	}
+
+private:
+	SpscRingBuffer<T> _ring;
+	size_t _nChannels = 0;
+
+	// Consumer-owned scratch space.
+	std::vector<T> _window;
+
+	std::atomic<uint64_t> _overruns = 0;
+	std::atomic<uint64_t> _droppedFrames = 0;
+};
@@ -0,0 +1,20 @@
+#include "caudiobackend.h"
+
+#if defined _WIN32
+#include "caudiooutputwasapi.h"
+#elif defined __linux__
+#include "caudiobackendalsa.h"
+#else
+#include "caudiobackendnull.h"
+#endif
+
+std::unique_ptr<CAudioBackend> createDefaultAudioBackend()
+{
+#if defined _WIN32
+	return std::make_unique<CAudioOutputWasapi>();
+#elif defined __linux__
+	return std::make_unique<CAudioBackendAlsa>();
+#else
+	return std::make_unique<CAudioBackendNull>();
+#endif
+}
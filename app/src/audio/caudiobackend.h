@@ -0,0 +1,82 @@
+#pragma once
+#include "audioformat.h"
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct StreamOptions {
+	// Bypass the system mixer (WASAPI exclusive mode; on ALSA - no automatic format / rate / channel conversion).
+	bool exclusive = false;
+	// Ask for the smallest period the device supports instead of the default one.
+	bool minimumPeriod = false;
+	// Run the render thread at real-time priority: MMCSS "Pro Audio" on Windows, SCHED_FIFO on Linux (needs RLIMIT_RTPRIO or CAP_SYS_NICE).
+	bool realtimePriority = true;
+	// Pin the render thread to this CPU; -1 leaves it to the scheduler.
+	int cpuAffinity = -1;
+	// Page-lock the render path's buffers and prefault the render thread's stack, so that rendering never waits for a page fault.
+	bool lockMemory = false;
+};
+
+// Achieved stream timing, valid while the stream is running.
+struct LatencyInfo {
+	uint32_t bufferFrames = 0;
+	uint32_t periodFrames = 0;
+	double bufferMs = 0.0;
+	double periodMs = 0.0;
+	// Buffer plus the latency the device / driver reports on top of it.
+	double outputLatencyMs = 0.0;
+	bool exclusive = false;
+	// Whether the render thread has got the real-time priority StreamOptions asked for.
+	bool realtimePriority = false;
+};
+
+// Platform audio output API (WASAPI, a timer-driven null device, a WAV file etc.).
+// The backend owns the render thread and pulls audio from the engine through the render callback.
+class CAudioBackend
+{
+public:
+	// Called on the backend's render thread. dst is an interleaved buffer of nFrames frames in the format returned by format().
+	using RenderCallback = std::function<void(void* dst, uint32_t nFrames)>;
+
+	virtual ~CAudioBackend() = default;
+
+	[[nodiscard]] virtual std::vector<AudioDeviceInfo> devices() const = 0;
+	[[nodiscard]] virtual AudioFormat mixFormat(const std::wstring& deviceId) const noexcept = 0;
+
+	// Selects the output device and negotiates the stream format; must be called while stopped.
+	virtual bool open(const std::wstring& deviceId, const StreamOptions& options) = 0;
+	// The stream format of the currently open device. May differ from mixFormat() in exclusive mode.
+	[[nodiscard]] virtual AudioFormat format() const noexcept = 0;
+
+	// Returns once the stream is running (true) or has failed to start (false).
+	virtual bool start(RenderCallback callback) = 0;
+	virtual void stop() = 0;
+
+	// Moves the running stream to another device without stopping the render thread. The new device is opened and primed
+	// while the old one is still playing, and starts when the old one runs out of data; the render callback carries on as is.
+	// Returns the gap between the end of the old stream and the start of the new one in ms (negative if they overlap).
+	// Returns nothing, with the old stream still playing, if the backend can't do that, the new device fails to open
+	// or takes a different format (see sameSampleLayout()); the caller then has to stop() and start() anew.
+	[[nodiscard]] virtual std::optional<double> switchDevice(const std::wstring& /*deviceId*/, const StreamOptions& /*options*/) { return {}; }
+
+	[[nodiscard]] virtual LatencyInfo latencyInfo() const noexcept = 0;
+	// How many times the device has run out of data since start(); 0 where the backend can't tell. Safe to call from the render callback.
+	[[nodiscard]] virtual uint64_t underruns() const noexcept { return 0; }
+
+	// Called on the render thread when the stream stops on an error (e. g. the device has been unplugged), right before the thread exits.
+	// The stream can be restarted with stop(), open() and start() from another thread. Must be set while stopped.
+	using StreamErrorCallback = std::function<void()>;
+	virtual void setStreamErrorCallback(StreamErrorCallback /*callback*/) {}
+
+	// Called on an arbitrary thread whenever devices are added or removed, or a device's name or mix format changes.
+	// Backends whose device list is fixed never call it. Passing an empty callback unsubscribes.
+	using DeviceChangeCallback = std::function<void()>;
+	virtual void setDeviceChangeCallback(DeviceChangeCallback /*callback*/) {}
+};
+
+// The native backend for the current platform.
+[[nodiscard]] std::unique_ptr<CAudioBackend> createDefaultAudioBackend();
@@ -0,0 +1,503 @@
+#include "caudiobackendalsa.h"
+#include "alsautils.h"
+#include "realtimethread.h"
+#include "assert/advanced_assert.h"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cerrno>
+#include <future>
+#include <optional>
+#include <string>
+
+namespace {
+
+// A device that has had no room for a whole second has stalled.
+constexpr int deviceTimeoutMs = 1000;
+
+struct PcmStream {
+	snd_pcm_t* pcm = nullptr;
+	AudioFormat format;
+	uint32_t periodFrames = 0;
+	LatencyInfo latencyInfo;
+};
+
+// Opens the device in the non-blocking mode and sets it up, ready for snd_pcm_prepare(). The device starts by itself once its buffer is full.
+std::optional<PcmStream> openStream(const std::wstring& deviceId, const StreamOptions& options)
+{
+	snd_pcm_t* pcm = openPcm(deviceId, SND_PCM_STREAM_PLAYBACK, options.exclusive, SND_PCM_NONBLOCK);
+	if (!pcm)
+		return {};
+
+	snd_pcm_hw_params_t* hw = nullptr;
+	snd_pcm_hw_params_alloca(&hw);
+
+	AudioFormat format;
+	if (!chooseFormat(pcm, hw, options.exclusive, format))
+	{
+		snd_pcm_close(pcm);
+		return {};
+	}
+
+	// Two periods of the smallest size the device allows, or four 10 ms periods by default.
+	snd_pcm_uframes_t periodFrames = format.sampleRate / 100;
+	unsigned int nPeriods = 4;
+	if (options.minimumPeriod)
+	{
+		snd_pcm_hw_params_get_period_size_min(hw, &periodFrames, nullptr);
+		nPeriods = 2;
+	}
+
+	snd_pcm_hw_params_set_period_size_near(pcm, hw, &periodFrames, nullptr);
+	snd_pcm_hw_params_set_periods_near(pcm, hw, &nPeriods, nullptr);
+
+	int err = snd_pcm_hw_params(pcm, hw);
+	if (err < 0)
+	{
+		snd_pcm_close(pcm);
+		assert_unconditional_r("snd_pcm_hw_params error: " + alsaErrorString(err));
+		return {};
+	}
+
+	snd_pcm_uframes_t bufferFrames = 0;
+	snd_pcm_hw_params_get_period_size(hw, &periodFrames, nullptr);
+	snd_pcm_hw_params_get_buffer_size(hw, &bufferFrames);
+
+	// Don't start the device until the whole buffer has been filled.
+	snd_pcm_sw_params_t* sw = nullptr;
+	snd_pcm_sw_params_alloca(&sw);
+	snd_pcm_sw_params_current(pcm, sw);
+	snd_pcm_sw_params_set_start_threshold(pcm, sw, bufferFrames);
+	snd_pcm_sw_params_set_avail_min(pcm, sw, periodFrames);
+	err = snd_pcm_sw_params(pcm, sw);
+	assert_message_r(err >= 0, "snd_pcm_sw_params error: " + alsaErrorString(err));
+
+	PcmStream stream;
+	stream.pcm = pcm;
+	stream.format = std::move(format);
+	stream.periodFrames = static_cast<uint32_t>(periodFrames);
+
+	LatencyInfo& info = stream.latencyInfo;
+	info.exclusive = options.exclusive;
+	info.bufferFrames = static_cast<uint32_t>(bufferFrames);
+	info.periodFrames = stream.periodFrames;
+	info.bufferMs = 1000.0 * info.bufferFrames / stream.format.sampleRate;
+	info.periodMs = 1000.0 * info.periodFrames / stream.format.sampleRate;
+	info.outputLatencyMs = info.bufferMs;
+
+	return stream;
+}
+
+} // namespace
+
+struct CAudioBackendAlsa::SwitchRequest {
+	PcmStream stream;
+	std::promise<std::optional<double>> result;
+};
+
+CAudioBackendAlsa::CAudioBackendAlsa() = default;
+
+CAudioBackendAlsa::~CAudioBackendAlsa()
+{
+	setDeviceChangeCallback({});
+	stop();
+	close();
+}
+
+std::vector<AudioDeviceInfo> CAudioBackendAlsa::devices() const
+{
+	return pcmDevices("Output");
+}
+
+AudioFormat CAudioBackendAlsa::mixFormat(const std::wstring& deviceId) const noexcept
+{
+	snd_pcm_t* pcm = openPcm(deviceId, SND_PCM_STREAM_PLAYBACK, false, SND_PCM_NONBLOCK);
+	if (!pcm)
+		return {};
+
+	snd_pcm_hw_params_t* hw = nullptr;
+	snd_pcm_hw_params_alloca(&hw);
+
+	AudioFormat format;
+	if (!chooseFormat(pcm, hw, false, format))
+		format = {};
+
+	snd_pcm_close(pcm);
+	return format;
+}
+
+bool CAudioBackendAlsa::open(const std::wstring& deviceId, const StreamOptions& options)
+{
+	assert_and_return_r(!_thread.joinable(), false);
+	close();
+
+	auto stream = openStream(deviceId, options);
+	if (!stream)
+		return false;
+
+	_pcm = stream->pcm;
+	_format = std::move(stream->format);
+	_periodFrames = stream->periodFrames;
+	_options = options;
+
+	std::lock_guard lock{ _latencyInfoMutex };
+	_latencyInfo = stream->latencyInfo;
+
+	return true;
+}
+
+AudioFormat CAudioBackendAlsa::format() const noexcept
+{
+	return _format;
+}
+
+bool CAudioBackendAlsa::start(RenderCallback callback)
+{
+	assert_and_return_r(callback, false);
+	assert_and_return_r(_pcm, false);
+	if (_thread.joinable())
+		return true;
+
+	const int err = snd_pcm_prepare(_pcm);
+	assert_and_return_message_r(err >= 0, "snd_pcm_prepare error: " + alsaErrorString(err), false);
+
+	_stopEventFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	assert_and_return_message_r(_stopEventFd >= 0, "eventfd failed", false);
+
+	{
+		std::lock_guard lock{ _switchMutex };
+		_bPlaybackThreadRunning = true;
+	}
+
+	_bTerminateThread = false;
+	_underruns = 0;
+	// Returns once the thread has been promoted, so that latencyInfo() tells whether it has been.
+	std::promise<void> started;
+	auto startedFuture = started.get_future();
+	_thread = std::thread(&CAudioBackendAlsa::playbackThread, this, std::move(callback), std::move(started));
+	startedFuture.wait();
+	return true;
+}
+
+void CAudioBackendAlsa::stop()
+{
+	if (!_thread.joinable())
+		return;
+
+	// The playback thread polls this descriptor alongside the device ones, so it exits right away even if the device has stalled.
+	_bTerminateThread = true;
+	::eventfd_write(_stopEventFd, 1);
+	_thread.join();
+
+	::close(_stopEventFd);
+	_stopEventFd = -1;
+	snd_pcm_drop(_pcm);
+}
+
+void CAudioBackendAlsa::setStreamErrorCallback(StreamErrorCallback callback)
+{
+	assert_and_return_r(!_thread.joinable(), );
+	_streamErrorCallback = std::move(callback);
+}
+
+std::optional<double> CAudioBackendAlsa::switchDevice(const std::wstring& deviceId, const StreamOptions& options)
+{
+	assert_and_return_r(_thread.joinable(), {});
+
+	auto request = std::make_unique<SwitchRequest>();
+	{
+		auto stream = openStream(deviceId, options);
+		if (!stream)
+			return {};
+
+		request->stream = std::move(*stream);
+	}
+
+	snd_pcm_t* pcm = request->stream.pcm;
+	// The render callback keeps producing the current format. Channel names are the same for every device.
+	if (!sameSampleLayout(request->stream.format, _format))
+	{
+		snd_pcm_close(pcm);
+		return {};
+	}
+
+	const int err = snd_pcm_prepare(pcm);
+	if (err < 0)
+	{
+		snd_pcm_close(pcm);
+		assert_unconditional_r("snd_pcm_prepare error: " + alsaErrorString(err));
+		return {};
+	}
+
+	auto result = request->result.get_future();
+	{
+		std::lock_guard lock{ _switchMutex };
+		if (!_bPlaybackThreadRunning)
+		{
+			snd_pcm_close(pcm);
+			return {};
+		}
+
+		// Picked up by the playback thread between two periods.
+		_switchRequest = std::move(request);
+		_bSwitchPending = true;
+	}
+
+	return result.get();
+}
+
+LatencyInfo CAudioBackendAlsa::latencyInfo() const noexcept
+{
+	std::lock_guard lock{ _latencyInfoMutex };
+	LatencyInfo info = _latencyInfo;
+	info.realtimePriority = _bRealtimeThread;
+	return info;
+}
+
+uint64_t CAudioBackendAlsa::underruns() const noexcept
+{
+	return _underruns.load(std::memory_order_relaxed);
+}
+
+void CAudioBackendAlsa::playbackThread(RenderCallback callback, std::promise<void> started)
+{
+	{
+		const RealtimeThreadScope realtime{ _options };
+		_bRealtimeThread = realtime.isRealtime();
+		started.set_value();
+
+		renderLoop(callback);
+	}
+
+	{
+		// Stopped or failed: a switchDevice() call must not be left waiting for this thread.
+		std::lock_guard lock{ _switchMutex };
+		_bPlaybackThreadRunning = false;
+		if (_switchRequest)
+		{
+			snd_pcm_close(_switchRequest->stream.pcm);
+			_switchRequest->result.set_value({});
+			_switchRequest.reset();
+		}
+	}
+
+	if (!_bTerminateThread && _streamErrorCallback)
+		_streamErrorCallback();
+}
+
+bool CAudioBackendAlsa::waitForDevice() const
+{
+	std::array<pollfd, 16> fds;
+	fds[0] = { _stopEventFd, POLLIN, 0 };
+	const int nPcmFds = snd_pcm_poll_descriptors(_pcm, fds.data() + 1, static_cast<unsigned int>(fds.size() - 1));
+	assert_and_return_message_r(nPcmFds > 0, "snd_pcm_poll_descriptors error: " + alsaErrorString(nPcmFds), false);
+
+	for (;;)
+	{
+		const int result = ::poll(fds.data(), static_cast<nfds_t>(nPcmFds + 1), deviceTimeoutMs);
+		if (result < 0 && errno == EINTR)
+			continue;
+
+		assert_and_return_message_r(result != 0, "The device has stopped responding", false);
+		assert_and_return_message_r(result > 0, "poll() failed", false);
+		if ((fds[0].revents & POLLIN) != 0)
+			return false;
+
+		// Plugins such as dmix have to translate the raw descriptor events.
+		unsigned short revents = 0;
+		snd_pcm_poll_descriptors_revents(_pcm, fds.data() + 1, static_cast<unsigned int>(nPcmFds), &revents);
+		// An error condition is left for the next snd_pcm_writei() to report and recover from.
+		if ((revents & (POLLOUT | POLLERR)) != 0)
+			return true;
+	}
+}
+
+void CAudioBackendAlsa::renderLoop(const RenderCallback& callback)
+{
+	const size_t frameSize = _format.channels.size() * _format.bitsPerSample / 8;
+	std::vector<uint8_t> buffer(_periodFrames * frameSize);
+
+	bool bLatencyMeasured = false;
+	while (!_bTerminateThread)
+	{
+		if (_bSwitchPending.exchange(false))
+		{
+			std::unique_ptr<SwitchRequest> request;
+			{
+				std::lock_guard lock{ _switchMutex };
+				request = std::move(_switchRequest);
+			}
+
+			if (request)
+			{
+				const auto gapMs = handOver(*request, callback, buffer);
+				if (gapMs)
+					bLatencyMeasured = false;
+
+				request->result.set_value(gapMs);
+			}
+		}
+
+		callback(buffer.data(), _periodFrames);
+
+		// Waiting for room for the period paces this loop.
+		const uint8_t* data = buffer.data();
+		for (snd_pcm_uframes_t framesLeft = _periodFrames; framesLeft > 0 && !_bTerminateThread; )
+		{
+			snd_pcm_sframes_t n = snd_pcm_writei(_pcm, data, framesLeft);
+			if (n == -EAGAIN)
+			{
+				if (!waitForDevice())
+					return;
+
+				continue;
+			}
+			else if (n < 0)
+			{
+				// Underrun or resume after suspend.
+				if (n == -EPIPE)
+					_underruns.fetch_add(1, std::memory_order_relaxed);
+
+				n = snd_pcm_recover(_pcm, static_cast<int>(n), 1);
+				assert_and_return_message_r(n >= 0, "snd_pcm_writei error: " + alsaErrorString(static_cast<int>(n)), );
+				continue;
+			}
+
+			data += static_cast<size_t>(n) * frameSize;
+			framesLeft -= static_cast<snd_pcm_uframes_t>(n);
+		}
+
+		// The delay of a full buffer includes the FIFO and codec latency that the driver knows about.
+		snd_pcm_sframes_t delay = 0;
+		if (!bLatencyMeasured && snd_pcm_state(_pcm) == SND_PCM_STATE_RUNNING && snd_pcm_delay(_pcm, &delay) == 0)
+		{
+			bLatencyMeasured = true;
+
+			std::lock_guard lock{ _latencyInfoMutex };
+			_latencyInfo.outputLatencyMs = std::max(_latencyInfo.bufferMs, 1000.0 * static_cast<double>(delay) / _format.sampleRate);
+		}
+	}
+}
+
+std::optional<double> CAudioBackendAlsa::handOver(SwitchRequest& request, const RenderCallback& callback, std::vector<uint8_t>& buffer)
+{
+	using Clock = std::chrono::steady_clock;
+
+	PcmStream& next = request.stream;
+	const size_t frameSize = _format.channels.size() * _format.bitsPerSample / 8;
+	buffer.resize(next.periodFrames * frameSize);
+
+	// Fill the new device while the old one is still playing, leaving one period free so that it doesn't start by itself.
+	snd_pcm_sframes_t avail = 0;
+	while ((avail = snd_pcm_avail(next.pcm)) >= 2 * static_cast<snd_pcm_sframes_t>(next.periodFrames))
+	{
+		callback(buffer.data(), next.periodFrames);
+		avail = snd_pcm_writei(next.pcm, buffer.data(), next.periodFrames);
+		if (avail < 0)
+			break;
+	}
+
+	if (avail < 0)
+	{
+		snd_pcm_close(next.pcm);
+		buffer.resize(_periodFrames * frameSize);
+		assert_unconditional_r("Failed to prime the new device: " + alsaErrorString(static_cast<int>(avail)));
+		return {};
+	}
+
+	// Let the old device play everything it has queued. One that has been unplugged has nothing left.
+	snd_pcm_sframes_t delay = 0;
+	if (snd_pcm_delay(_pcm, &delay) < 0)
+		delay = 0;
+
+	const auto currentStreamEnd = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{ static_cast<double>(delay) / _format.sampleRate });
+	std::this_thread::sleep_until(currentStreamEnd);
+
+	const int err = snd_pcm_start(next.pcm);
+	const auto nextStreamStart = Clock::now();
+	if (err < 0)
+	{
+		// Stay on the old device, it restarts once its buffer is full again.
+		snd_pcm_close(next.pcm);
+		buffer.resize(_periodFrames * frameSize);
+		assert_unconditional_r("snd_pcm_start error: " + alsaErrorString(err));
+		return {};
+	}
+
+	snd_pcm_drop(_pcm);
+	snd_pcm_close(_pcm);
+	_pcm = next.pcm;
+	_periodFrames = next.periodFrames;
+	{
+		std::lock_guard lock{ _latencyInfoMutex };
+		_latencyInfo = next.latencyInfo;
+	}
+
+	return std::chrono::duration<double, std::milli>{ nextStreamStart - currentStreamEnd }.count();
+}
+
+void CAudioBackendAlsa::setDeviceChangeCallback(DeviceChangeCallback callback)
+{
+	if (_hotplugThread.joinable())
+	{
+		_bTerminateHotplugThread = true;
+		_hotplugThread.join();
+	}
+
+	if (!callback)
+		return;
+
+	_bTerminateHotplugThread = false;
+	_hotplugThread = std::thread(&CAudioBackendAlsa::hotplugThread, this, std::move(callback));
+}
+
+void CAudioBackendAlsa::hotplugThread(DeviceChangeCallback callback)
+{
+	const int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	assert_and_return_message_r(fd >= 0, "inotify_init1 failed", );
+
+	if (::inotify_add_watch(fd, "/dev/snd", IN_CREATE | IN_DELETE) < 0)
+	{
+		::close(fd);
+		assert_unconditional_r("inotify_add_watch(/dev/snd) failed");
+		return;
+	}
+
+	const auto drainEvents = [fd] {
+		alignas(inotify_event) char buffer[4096];
+		bool any = false;
+		while (::read(fd, buffer, sizeof(buffer)) > 0)
+			any = true;
+		return any;
+	};
+
+	pollfd pfd{ fd, POLLIN, 0 };
+	while (!_bTerminateHotplugThread)
+	{
+		// The timeout bounds how long setDeviceChangeCallback() / the destructor can wait for this thread.
+		if (::poll(&pfd, 1, 250) <= 0 || !drainEvents())
+			continue;
+
+		// A card brings up a burst of device nodes; report them all as one change.
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		drainEvents();
+		callback();
+	}
+
+	::close(fd);
+}
+
+void CAudioBackendAlsa::close() noexcept
+{
+	if (!_pcm)
+		return;
+
+	snd_pcm_close(_pcm);
+	_pcm = nullptr;
+}
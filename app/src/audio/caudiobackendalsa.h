@@ -0,0 +1,84 @@
+#pragma once
+#include "caudiobackend.h"
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef struct _snd_pcm snd_pcm_t;
+
+// ALSA playback from a dedicated thread. The writes are non-blocking and the thread polls the device, so that stop() never waits on it.
+// Exclusive mode disables the automatic rate / channel / format conversions so that "hw:" devices are driven directly.
+class CAudioBackendAlsa final : public CAudioBackend
+{
+public:
+	// Defined where SwitchRequest is complete, std::unique_ptr needs it.
+	CAudioBackendAlsa();
+	~CAudioBackendAlsa() override;
+
+	[[nodiscard]] std::vector<AudioDeviceInfo> devices() const override;
+	[[nodiscard]] AudioFormat mixFormat(const std::wstring& deviceId) const noexcept override;
+
+	bool open(const std::wstring& deviceId, const StreamOptions& options) override;
+	[[nodiscard]] AudioFormat format() const noexcept override;
+
+	bool start(RenderCallback callback) override;
+	void stop() override;
+
+	// The new device starts the moment the old one has played out its buffer.
+	[[nodiscard]] std::optional<double> switchDevice(const std::wstring& deviceId, const StreamOptions& options) override;
+
+	void setStreamErrorCallback(StreamErrorCallback callback) override;
+
+	[[nodiscard]] LatencyInfo latencyInfo() const noexcept override;
+	// XRUNs reported by snd_pcm_writei().
+	[[nodiscard]] uint64_t underruns() const noexcept override;
+
+	// Watches /dev/snd for sound card hotplug.
+	void setDeviceChangeCallback(DeviceChangeCallback callback) override;
+
+private:
+	struct SwitchRequest;
+
+	void playbackThread(RenderCallback callback, std::promise<void> started);
+	void renderLoop(const RenderCallback& callback);
+	// Waits until the device has room for more frames. False if stop() has been called or the device has failed or stalled.
+	[[nodiscard]] bool waitForDevice() const;
+	// Playback thread: moves the output over to the requested device, see switchDevice().
+	std::optional<double> handOver(SwitchRequest& request, const RenderCallback& callback, std::vector<uint8_t>& buffer);
+	void hotplugThread(DeviceChangeCallback callback);
+	void close() noexcept;
+
+private:
+	snd_pcm_t* _pcm = nullptr;
+	AudioFormat _format;
+	uint32_t _periodFrames = 0;
+	StreamOptions _options;
+
+	LatencyInfo _latencyInfo;
+	mutable std::mutex _latencyInfoMutex;
+
+	StreamErrorCallback _streamErrorCallback;
+
+	std::thread _thread;
+	std::atomic_bool _bTerminateThread = false;
+	std::atomic_bool _bRealtimeThread = false;
+	std::atomic<uint64_t> _underruns = 0;
+	// Wakes the playback thread up from waiting for the device.
+	int _stopEventFd = -1;
+
+	// Hands a new device over to the playback thread, see switchDevice().
+	std::unique_ptr<SwitchRequest> _switchRequest;
+	std::atomic_bool _bSwitchPending = false;
+	// False once the playback thread has exited, so that nobody waits for it to pick a request up.
+	bool _bPlaybackThreadRunning = false;
+	std::mutex _switchMutex;
+
+	std::thread _hotplugThread;
+	std::atomic_bool _bTerminateHotplugThread = false;
+};
@@ -0,0 +1,103 @@
+#include "caudiobackendnull.h"
+#include "realtimethread.h"
+#include "assert/advanced_assert.h"
+
+#include <chrono>
+#include <string>
+
+static constexpr const wchar_t* nullDeviceId = L"null";
+
+CAudioBackendNull::CAudioBackendNull(const uint32_t sampleRate, const size_t nChannels, const uint32_t periodFrames) :
+	_periodFrames{ periodFrames }
+{
+	_format.sampleRate = sampleRate;
+	_format.sampleFormat = AudioFormat::Float;
+	_format.bitsPerSample = 32;
+	for (size_t c = 0; c < nChannels; ++c)
+		_format.channels.emplace_back("Channel " + std::to_string(c + 1), c);
+}
+
+CAudioBackendNull::~CAudioBackendNull()
+{
+	stop();
+}
+
+std::vector<AudioDeviceInfo> CAudioBackendNull::devices() const
+{
+	std::vector<AudioDeviceInfo> devices;
+	devices.emplace_back(nullDeviceId, L"Null output (timer-driven)");
+	return devices;
+}
+
+AudioFormat CAudioBackendNull::mixFormat(const std::wstring& deviceId) const noexcept
+{
+	assert_and_return_r(deviceId == nullDeviceId, {});
+	return _format;
+}
+
+bool CAudioBackendNull::open(const std::wstring& deviceId, const StreamOptions& options)
+{
+	assert_and_return_r(!_thread.joinable(), false);
+	_options = options;
+	return deviceId == nullDeviceId;
+}
+
+AudioFormat CAudioBackendNull::format() const noexcept
+{
+	return _format;
+}
+
+bool CAudioBackendNull::start(RenderCallback callback)
+{
+	assert_and_return_r(callback, false);
+	if (_thread.joinable())
+		return true;
+
+	_bTerminateThread = false;
+	// Returns once the thread has been promoted, so that latencyInfo() tells whether it has been.
+	std::promise<void> started;
+	auto startedFuture = started.get_future();
+	_thread = std::thread(&CAudioBackendNull::renderThread, this, std::move(callback), std::move(started));
+	startedFuture.wait();
+	return true;
+}
+
+void CAudioBackendNull::stop()
+{
+	if (!_thread.joinable())
+		return;
+
+	_bTerminateThread = true;
+	_thread.join();
+}
+
+void CAudioBackendNull::renderThread(RenderCallback callback, std::promise<void> started)
+{
+	const RealtimeThreadScope realtime{ _options };
+	_bRealtimeThread = realtime.isRealtime();
+	started.set_value();
+
+	std::vector<float> buffer(static_cast<size_t>(_periodFrames) * _format.channels.size());
+
+	using Clock = std::chrono::steady_clock;
+	const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{ static_cast<double>(_periodFrames) / _format.sampleRate });
+
+	// Schedule against absolute deadlines so that the callback cost doesn't accumulate into clock drift.
+	auto deadline = Clock::now();
+	while (!_bTerminateThread)
+	{
+		callback(buffer.data(), _periodFrames);
+
+		deadline += period;
+		std::this_thread::sleep_until(deadline);
+	}
+}
+
+LatencyInfo CAudioBackendNull::latencyInfo() const noexcept
+{
+	LatencyInfo info;
+	info.bufferFrames = info.periodFrames = _periodFrames;
+	info.bufferMs = info.periodMs = info.outputLatencyMs = 1000.0 * _periodFrames / _format.sampleRate;
+	info.realtimePriority = _bRealtimeThread;
+	return info;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "caudiobackend.h"
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+// A device-less backend that drives the render callback from a high-resolution timer at the nominal sample rate.
+// Used for profiling the render path and for running headless where no sound card is available.
+class CAudioBackendNull final : public CAudioBackend
+{
+public:
+	explicit CAudioBackendNull(uint32_t sampleRate = 48000, size_t nChannels = 2, uint32_t periodFrames = 480);
+	~CAudioBackendNull() override;
+
+	[[nodiscard]] std::vector<AudioDeviceInfo> devices() const override;
+	[[nodiscard]] AudioFormat mixFormat(const std::wstring& deviceId) const noexcept override;
+
+	bool open(const std::wstring& deviceId, const StreamOptions& options) override;
+	[[nodiscard]] AudioFormat format() const noexcept override;
+
+	bool start(RenderCallback callback) override;
+	void stop() override;
+
+	[[nodiscard]] LatencyInfo latencyInfo() const noexcept override;
+
+private:
+	void renderThread(RenderCallback callback, std::promise<void> started);
+
+private:
+	AudioFormat _format;
+	const uint32_t _periodFrames;
+	StreamOptions _options;
+
+	std::thread _thread;
+	std::atomic_bool _bTerminateThread = false;
+	std::atomic_bool _bRealtimeThread = false;
+};
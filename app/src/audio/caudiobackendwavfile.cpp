@@ -0,0 +1,110 @@
+#include "caudiobackendwavfile.h"
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <string>
+
+static constexpr const wchar_t* fileDeviceId = L"wavfile";
+static constexpr uint32_t periodFrames = 4096;
+
+CAudioBackendWavFile::CAudioBackendWavFile(std::string filePath, const uint32_t sampleRate, const size_t nChannels, const uint64_t frameLimit) :
+	_filePath{ std::move(filePath) },
+	_frameLimit{ frameLimit }
+{
+	_format.sampleRate = sampleRate;
+	_format.sampleFormat = AudioFormat::Float;
+	_format.bitsPerSample = 32;
+	for (size_t c = 0; c < nChannels; ++c)
+		_format.channels.emplace_back("Channel " + std::to_string(c + 1), c);
+}
+
+CAudioBackendWavFile::~CAudioBackendWavFile()
+{
+	stop();
+}
+
+std::vector<AudioDeviceInfo> CAudioBackendWavFile::devices() const
+{
+	std::vector<AudioDeviceInfo> devices;
+	devices.emplace_back(fileDeviceId, L"WAV file");
+	return devices;
+}
+
+AudioFormat CAudioBackendWavFile::mixFormat(const std::wstring& deviceId) const noexcept
+{
+	assert_and_return_r(deviceId == fileDeviceId, {});
+	return _format;
+}
+
+bool CAudioBackendWavFile::open(const std::wstring& deviceId, const StreamOptions& /*options*/)
+{
+	assert_and_return_r(!_thread.joinable(), false);
+	return deviceId == fileDeviceId;
+}
+
+AudioFormat CAudioBackendWavFile::format() const noexcept
+{
+	return _format;
+}
+
+bool CAudioBackendWavFile::start(RenderCallback callback)
+{
+	assert_and_return_r(callback, false);
+	if (_thread.joinable())
+		return true;
+
+	assert_and_return_r(_writer.open(_filePath, _format), false);
+
+	_bTerminateThread = false;
+	_thread = std::thread(&CAudioBackendWavFile::renderThread, this, std::move(callback));
+	return true;
+}
+
+void CAudioBackendWavFile::stop()
+{
+	if (!_thread.joinable())
+		return;
+
+	_bTerminateThread = true;
+	_thread.join();
+	assert_r(_writer.close());
+}
+
+LatencyInfo CAudioBackendWavFile::latencyInfo() const noexcept
+{
+	// Not a real-time stream
+	LatencyInfo info;
+	info.bufferFrames = info.periodFrames = periodFrames;
+	return info;
+}
+
+void CAudioBackendWavFile::waitUntilFinished()
+{
+	assert_and_return_r(_frameLimit > 0, );
+	if (!_thread.joinable())
+		return;
+
+	_thread.join();
+	assert_r(_writer.close());
+}
+
+void CAudioBackendWavFile::renderThread(RenderCallback callback)
+{
+	std::vector<float> buffer(static_cast<size_t>(periodFrames) * _format.channels.size());
+
+	while (!_bTerminateThread)
+	{
+		uint32_t nFrames = periodFrames;
+		if (_frameLimit > 0)
+		{
+			const uint64_t remaining = _frameLimit - _writer.framesWritten();
+			if (remaining == 0)
+				break;
+
+			nFrames = static_cast<uint32_t>(std::min<uint64_t>(nFrames, remaining));
+		}
+
+		callback(buffer.data(), nFrames);
+		assert_and_return_r(_writer.write(buffer.data(), nFrames), );
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "caudiobackend.h"
+#include "wavfilewriter.h"
+
+#include <atomic>
+#include <thread>
+
+// Renders into a WAV file instead of a device, as fast as the render callback allows.
+// Runs until stopped or until frameLimit frames have been written (0 means no limit).
+class CAudioBackendWavFile final : public CAudioBackend
+{
+public:
+	CAudioBackendWavFile(std::string filePath, uint32_t sampleRate = 48000, size_t nChannels = 2, uint64_t frameLimit = 0);
+	~CAudioBackendWavFile() override;
+
+	[[nodiscard]] std::vector<AudioDeviceInfo> devices() const override;
+	[[nodiscard]] AudioFormat mixFormat(const std::wstring& deviceId) const noexcept override;
+
+	bool open(const std::wstring& deviceId, const StreamOptions& options) override;
+	[[nodiscard]] AudioFormat format() const noexcept override;
+
+	bool start(RenderCallback callback) override;
+	void stop() override;
+
+	[[nodiscard]] LatencyInfo latencyInfo() const noexcept override;
+
+	// Blocks until frameLimit frames have been rendered, then finalizes the file.
+	void waitUntilFinished();
+
+private:
+	void renderThread(RenderCallback callback);
+
+private:
+	const std::string _filePath;
+	AudioFormat _format;
+	const uint64_t _frameLimit;
+
+	WavFileWriter _writer;
+
+	std::thread _thread;
+	std::atomic_bool _bTerminateThread = false;
+};
@@ -0,0 +1,64 @@
+#include "caudiocapture.h"
+#include "samplewriter.h"
+
+#include <cstring>
+
+#if defined _WIN32
+#include "caudiocapturewasapi.h"
+#elif defined __linux__
+#include "caudiocapturealsa.h"
+#endif
+
+template <typename Integer>
+static void readIntegerSamples(const uint8_t* src, float* dst, const size_t nSamples, const float scale) noexcept
+{
+	for (size_t i = 0; i < nSamples; ++i)
+	{
+		Integer sample;
+		std::memcpy(&sample, src + i * sizeof(Integer), sizeof(Integer));
+		dst[i] = static_cast<float>(sample) * scale;
+	}
+}
+
+bool readSamples(const void* src, const AudioFormat& format, float* dst, const size_t nSamples) noexcept
+{
+	const auto* in = static_cast<const uint8_t*>(src);
+
+	switch (SampleWriter::sampleType(format))
+	{
+	case SampleWriter::SampleType::Float32:
+		std::memcpy(dst, in, nSamples * sizeof(float));
+		return true;
+	case SampleWriter::SampleType::Int16:
+		readIntegerSamples<int16_t>(in, dst, nSamples, 1.0f / 32768.0f);
+		return true;
+	case SampleWriter::SampleType::Int24:
+		// Packed little-endian 3-byte samples, sign-extended by placing them in the top of an int32.
+		for (size_t i = 0; i < nSamples; ++i)
+		{
+			const uint8_t* p = in + i * 3;
+			const auto sample = static_cast<int32_t>((uint32_t{ p[0] } << 8) | (uint32_t{ p[1] } << 16) | (uint32_t{ p[2] } << 24));
+			dst[i] = static_cast<float>(sample) * (1.0f / 2147483648.0f);
+		}
+		return true;
+	case SampleWriter::SampleType::Int24In32: // Left-justified, so it reads the same as Int32.
+	case SampleWriter::SampleType::Int32:
+		readIntegerSamples<int32_t>(in, dst, nSamples, 1.0f / 2147483648.0f);
+		return true;
+	case SampleWriter::SampleType::Unsupported:
+		break;
+	}
+
+	return false;
+}
+
+std::unique_ptr<CAudioCapture> createDefaultAudioCapture()
+{
+#if defined _WIN32
+	return std::make_unique<CAudioCaptureWasapi>();
+#elif defined __linux__
+	return std::make_unique<CAudioCaptureAlsa>();
+#else
+	return {};
+#endif
+}
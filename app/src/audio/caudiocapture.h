@@ -0,0 +1,37 @@
+#pragma once
+#include "audioformat.h"
+
+#include <functional>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Platform audio input API: an input device, or the loopback of an output device where the platform has one (WASAPI).
+// The backend owns the capture thread and hands every packet it gets from the device to the capture callback.
+class CAudioCapture
+{
+public:
+	// Called on the capture thread with nFrames interleaved float frames in the channel layout and rate of format().
+	using CaptureCallback = std::function<void(const float* frames, uint32_t nFrames)>;
+
+	virtual ~CAudioCapture() = default;
+
+	[[nodiscard]] virtual std::vector<AudioDeviceInfo> devices() const = 0;
+
+	// Opens the device in its shared / default format and starts capturing. Returns once the stream is running (true) or has failed to start.
+	virtual bool start(const std::wstring& deviceId, CaptureCallback callback) = 0;
+	virtual void stop() = 0;
+
+	// The format of the running stream, as delivered by the device (before the conversion to float).
+	[[nodiscard]] virtual AudioFormat format() const noexcept = 0;
+	// How many times the device has had to drop input because the capture thread hasn't read it in time, since start().
+	[[nodiscard]] virtual uint64_t overruns() const noexcept { return 0; }
+};
+
+// Converts nSamples interleaved samples in one of the formats SampleWriter knows to float. False, with nothing written, for the others.
+bool readSamples(const void* src, const AudioFormat& format, float* dst, size_t nSamples) noexcept;
+
+// The native capture backend for the current platform, nothing if there is none.
+[[nodiscard]] std::unique_ptr<CAudioCapture> createDefaultAudioCapture();
@@ -0,0 +1,180 @@
+#include "caudiocapturealsa.h"
+#include "alsautils.h"
+#include "assert/advanced_assert.h"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+
+// A device that hasn't delivered anything for a whole second has stalled.
+static constexpr int deviceTimeoutMs = 1000;
+static constexpr unsigned int periodsPerBuffer = 8;
+
+CAudioCaptureAlsa::~CAudioCaptureAlsa()
+{
+	stop();
+}
+
+std::vector<AudioDeviceInfo> CAudioCaptureAlsa::devices() const
+{
+	return pcmDevices("Input");
+}
+
+bool CAudioCaptureAlsa::start(const std::wstring& deviceId, CaptureCallback callback)
+{
+	assert_and_return_r(callback, false);
+	assert_and_return_r(!_thread.joinable(), false);
+
+	_pcm = openPcm(deviceId, SND_PCM_STREAM_CAPTURE, false, SND_PCM_NONBLOCK);
+	if (!_pcm)
+		return false;
+
+	snd_pcm_hw_params_t* hw = nullptr;
+	snd_pcm_hw_params_alloca(&hw);
+	if (!chooseFormat(_pcm, hw, false, _format))
+	{
+		close();
+		return false;
+	}
+
+	// 10 ms periods; the long buffer gives the capture thread plenty of slack.
+	snd_pcm_uframes_t periodFrames = _format.sampleRate / 100;
+	unsigned int nPeriods = periodsPerBuffer;
+	snd_pcm_hw_params_set_period_size_near(_pcm, hw, &periodFrames, nullptr);
+	snd_pcm_hw_params_set_periods_near(_pcm, hw, &nPeriods, nullptr);
+
+	int err = snd_pcm_hw_params(_pcm, hw);
+	if (err < 0)
+	{
+		close();
+		assert_unconditional_r("snd_pcm_hw_params error: " + alsaErrorString(err));
+		return false;
+	}
+
+	snd_pcm_hw_params_get_period_size(hw, &periodFrames, nullptr);
+	_periodFrames = static_cast<uint32_t>(periodFrames);
+
+	err = snd_pcm_prepare(_pcm);
+	if (err >= 0)
+		err = snd_pcm_start(_pcm);
+
+	if (err < 0)
+	{
+		close();
+		assert_unconditional_r("Failed to start capturing: " + alsaErrorString(err));
+		return false;
+	}
+
+	_stopEventFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (_stopEventFd < 0)
+	{
+		close();
+		assert_unconditional_r("eventfd failed");
+		return false;
+	}
+
+	_bTerminateThread = false;
+	_overruns = 0;
+	_thread = std::thread(&CAudioCaptureAlsa::captureThread, this, std::move(callback));
+	return true;
+}
+
+void CAudioCaptureAlsa::stop()
+{
+	if (!_thread.joinable())
+		return;
+
+	_bTerminateThread = true;
+	::eventfd_write(_stopEventFd, 1);
+	_thread.join();
+
+	::close(_stopEventFd);
+	_stopEventFd = -1;
+	snd_pcm_drop(_pcm);
+	close();
+}
+
+AudioFormat CAudioCaptureAlsa::format() const noexcept
+{
+	return _format;
+}
+
+uint64_t CAudioCaptureAlsa::overruns() const noexcept
+{
+	return _overruns.load(std::memory_order_relaxed);
+}
+
+void CAudioCaptureAlsa::captureThread(CaptureCallback callback)
+{
+	const size_t nChannels = _format.channels.size();
+	const size_t frameSize = nChannels * _format.bitsPerSample / 8;
+	std::vector<uint8_t> buffer(_periodFrames * frameSize);
+	std::vector<float> frames(_periodFrames * nChannels);
+
+	while (!_bTerminateThread)
+	{
+		snd_pcm_sframes_t n = snd_pcm_readi(_pcm, buffer.data(), _periodFrames);
+		if (n == -EAGAIN)
+		{
+			if (!waitForDevice())
+				return;
+
+			continue;
+		}
+		else if (n < 0)
+		{
+			// Overrun or resume after suspend. A capture stream has to be restarted explicitly.
+			if (n == -EPIPE)
+				_overruns.fetch_add(1, std::memory_order_relaxed);
+
+			int err = snd_pcm_recover(_pcm, static_cast<int>(n), 1);
+			if (err >= 0)
+				err = snd_pcm_start(_pcm);
+
+			assert_and_return_message_r(err >= 0, "snd_pcm_readi error: " + alsaErrorString(static_cast<int>(n)), );
+			continue;
+		}
+
+		const auto nFrames = static_cast<uint32_t>(n);
+		if (readSamples(buffer.data(), _format, frames.data(), nFrames * nChannels))
+			callback(frames.data(), nFrames);
+	}
+}
+
+bool CAudioCaptureAlsa::waitForDevice() const
+{
+	std::array<pollfd, 16> fds;
+	fds[0] = { _stopEventFd, POLLIN, 0 };
+	const int nPcmFds = snd_pcm_poll_descriptors(_pcm, fds.data() + 1, static_cast<unsigned int>(fds.size() - 1));
+	assert_and_return_message_r(nPcmFds > 0, "snd_pcm_poll_descriptors error: " + alsaErrorString(nPcmFds), false);
+
+	for (;;)
+	{
+		const int result = ::poll(fds.data(), static_cast<nfds_t>(nPcmFds + 1), deviceTimeoutMs);
+		if (result < 0 && errno == EINTR)
+			continue;
+
+		assert_and_return_message_r(result != 0, "The capture device has stopped responding", false);
+		assert_and_return_message_r(result > 0, "poll() failed", false);
+		if ((fds[0].revents & POLLIN) != 0)
+			return false;
+
+		unsigned short revents = 0;
+		snd_pcm_poll_descriptors_revents(_pcm, fds.data() + 1, static_cast<unsigned int>(nPcmFds), &revents);
+		// An error condition is left for the next snd_pcm_readi() to report and recover from.
+		if ((revents & (POLLIN | POLLERR)) != 0)
+			return true;
+	}
+}
+
+void CAudioCaptureAlsa::close() noexcept
+{
+	if (!_pcm)
+		return;
+
+	snd_pcm_close(_pcm);
+	_pcm = nullptr;
+}
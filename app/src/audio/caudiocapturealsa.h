@@ -0,0 +1,45 @@
+#pragma once
+#include "caudiocapture.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef struct _snd_pcm snd_pcm_t;
+
+// ALSA capture from a dedicated thread, read and polled the same way CAudioBackendAlsa writes, so that stop() never waits on the device.
+// There's no loopback in ALSA itself: to analyse the output, capture the monitor source of a PulseAudio / PipeWire sink
+// or an snd-aloop device.
+class CAudioCaptureAlsa final : public CAudioCapture
+{
+public:
+	~CAudioCaptureAlsa() override;
+
+	[[nodiscard]] std::vector<AudioDeviceInfo> devices() const override;
+
+	bool start(const std::wstring& deviceId, CaptureCallback callback) override;
+	void stop() override;
+
+	[[nodiscard]] AudioFormat format() const noexcept override;
+	// XRUNs reported by snd_pcm_readi().
+	[[nodiscard]] uint64_t overruns() const noexcept override;
+
+private:
+	void captureThread(CaptureCallback callback);
+	// Waits until the device has a period of input. False if stop() has been called or the device has failed or stalled.
+	[[nodiscard]] bool waitForDevice() const;
+	void close() noexcept;
+
+private:
+	snd_pcm_t* _pcm = nullptr;
+	AudioFormat _format;
+	uint32_t _periodFrames = 0;
+
+	std::thread _thread;
+	std::atomic_bool _bTerminateThread = false;
+	std::atomic<uint64_t> _overruns = 0;
+	// Wakes the capture thread up from waiting for the device.
+	int _stopEventFd = -1;
+};
@@ -0,0 +1,167 @@
+#include "caudiocapturewasapi.h"
+#include "wasapiutils.h"
+
+#include "assert/advanced_assert.h"
+#include "system/win_utils.hpp"
+
+#include <wil/resource.h>
+
+#include <audioclient.h>
+#include <mmdeviceapi.h>
+#include <Windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string_view>
+
+using namespace wil;
+
+// Prepended to the ID of an output device to capture its loopback.
+static constexpr std::wstring_view loopbackPrefix = L"loopback:";
+static constexpr auto pollInterval = std::chrono::milliseconds{ 10 };
+// Several poll intervals, plus the 15.6 ms that a sleep may take on Windows.
+static constexpr REFERENCE_TIME bufferDuration = 1'000'000; // 100 ms
+
+CAudioCaptureWasapi::~CAudioCaptureWasapi()
+{
+	stop();
+}
+
+std::vector<AudioDeviceInfo> CAudioCaptureWasapi::devices() const
+{
+	auto devices = audioEndpoints(eCapture);
+	for (const auto& output : audioEndpoints(eRender))
+		devices.emplace_back(std::wstring{ loopbackPrefix } + output.id, output.friendlyName + L" (loopback)");
+
+	return devices;
+}
+
+bool CAudioCaptureWasapi::start(const std::wstring& deviceId, CaptureCallback callback)
+{
+	assert_and_return_r(callback, false);
+	assert_and_return_r(!_thread.joinable(), false);
+
+	_bTerminateThread = false;
+	_overruns = 0;
+
+	std::promise<bool> started;
+	auto startupResult = started.get_future();
+	_thread = std::thread(&CAudioCaptureWasapi::captureThread, this, deviceId, std::move(callback), std::move(started));
+
+	if (!startupResult.get())
+	{
+		_thread.join();
+		return false;
+	}
+
+	return true;
+}
+
+void CAudioCaptureWasapi::stop()
+{
+	if (!_thread.joinable())
+		return;
+
+	_bTerminateThread = true;
+	_thread.join();
+}
+
+AudioFormat CAudioCaptureWasapi::format() const noexcept
+{
+	return _format;
+}
+
+uint64_t CAudioCaptureWasapi::overruns() const noexcept
+{
+	return _overruns.load(std::memory_order_relaxed);
+}
+
+void CAudioCaptureWasapi::captureThread(std::wstring deviceId, CaptureCallback callback, std::promise<bool> started)
+{
+	bool bStartupReported = false;
+	auto reportFailure = wil::scope_exit([&] {
+		if (!bStartupReported)
+			started.set_value(false);
+	});
+
+	CO_INIT_HELPER(COINIT_MULTITHREADED);
+
+	const bool loopback = deviceId.starts_with(loopbackPrefix);
+	if (loopback)
+		deviceId.erase(0, loopbackPrefix.size());
+
+	const auto pAudioClient = activateAudioClient(findDevice(deviceId).get());
+	assert_and_return_r(pAudioClient, );
+
+	unique_cotaskmem_ptr<WAVEFORMATEX> pMixFormat;
+	HRESULT hr = pAudioClient->GetMixFormat(out_param(pMixFormat));
+	assert_and_return_message_r(SUCCEEDED(hr) && pMixFormat, "IAudioClient.GetMixFormat error: " + ErrorStringFromHRESULT(hr), );
+
+	_format = toAudioFormat(*pMixFormat);
+	assert_and_return_r(!_format.channels.empty(), );
+
+	hr = pAudioClient->Initialize(
+		AUDCLNT_SHAREMODE_SHARED,
+		loopback ? AUDCLNT_STREAMFLAGS_LOOPBACK : 0,
+		bufferDuration,
+		0,
+		pMixFormat.get(),
+		nullptr);
+	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.Initialize error: " + ErrorStringFromHRESULT(hr), );
+
+	UINT32 bufferFrames = 0;
+	hr = pAudioClient->GetBufferSize(&bufferFrames);
+	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.GetBufferSize error: " + ErrorStringFromHRESULT(hr), );
+
+	com_ptr_nothrow<IAudioCaptureClient> pCaptureClient;
+	hr = pAudioClient->GetService(
+		__uuidof(IAudioCaptureClient),
+		(void**)&pCaptureClient);
+	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.GetService error: " + ErrorStringFromHRESULT(hr), );
+
+	const size_t nChannels = _format.channels.size();
+	std::vector<float> frames(bufferFrames * nChannels);
+
+	hr = pAudioClient->Start();
+	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.Start error: " + ErrorStringFromHRESULT(hr), );
+	auto stopStream = wil::scope_exit([&pAudioClient] {
+		pAudioClient->Stop();
+	});
+
+	bStartupReported = true;
+	started.set_value(true);
+
+	while (!_bTerminateThread)
+	{
+		std::this_thread::sleep_for(pollInterval);
+
+		// Fails with AUDCLNT_E_DEVICE_INVALIDATED if the device is gone.
+		UINT32 packetFrames = 0;
+		while (SUCCEEDED(hr = pCaptureClient->GetNextPacketSize(&packetFrames)) && packetFrames > 0)
+		{
+			BYTE* pData = nullptr;
+			UINT32 nFrames = 0;
+			DWORD flags = 0;
+			hr = pCaptureClient->GetBuffer(&pData, &nFrames, &flags, nullptr, nullptr);
+			assert_and_return_message_r(SUCCEEDED(hr), "IAudioCaptureClient.GetBuffer error: " + ErrorStringFromHRESULT(hr), );
+
+			if ((flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) != 0)
+				_overruns.fetch_add(1, std::memory_order_relaxed);
+
+			const UINT32 nCopied = std::min(nFrames, bufferFrames);
+			bool bValid = true;
+			if ((flags & AUDCLNT_BUFFERFLAGS_SILENT) != 0)
+				std::fill_n(frames.data(), nCopied * nChannels, 0.0f);
+			else
+				bValid = readSamples(pData, _format, frames.data(), nCopied * nChannels);
+
+			hr = pCaptureClient->ReleaseBuffer(nFrames);
+			assert_and_return_message_r(SUCCEEDED(hr), "IAudioCaptureClient.ReleaseBuffer error: " + ErrorStringFromHRESULT(hr), );
+
+			if (bValid)
+				callback(frames.data(), nCopied);
+		}
+
+		assert_and_return_message_r(SUCCEEDED(hr), "IAudioCaptureClient.GetNextPacketSize error: " + ErrorStringFromHRESULT(hr), );
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "caudiocapture.h"
+
+#include <atomic>
+#include <future>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// WASAPI capture in shared mode, from an input device or from the loopback of an output device: devices() lists every
+// output device a second time, as "<name> (loopback)", which captures exactly what is being played to it.
+// The capture thread polls the device every few ms rather than waiting on its event, which loopback streams don't signal before Windows 10 1703.
+class CAudioCaptureWasapi final : public CAudioCapture
+{
+public:
+	~CAudioCaptureWasapi() override;
+
+	[[nodiscard]] std::vector<AudioDeviceInfo> devices() const override;
+
+	bool start(const std::wstring& deviceId, CaptureCallback callback) override;
+	void stop() override;
+
+	[[nodiscard]] AudioFormat format() const noexcept override;
+	// Packets flagged as discontinuous by the audio engine.
+	[[nodiscard]] uint64_t overruns() const noexcept override;
+
+private:
+	void captureThread(std::wstring deviceId, CaptureCallback callback, std::promise<bool> started);
+
+private:
+	// Set by the capture thread before it reports the startup outcome.
+	AudioFormat _format;
+
+	std::thread _thread;
+	std::atomic_bool _bTerminateThread = false;
+	std::atomic<uint64_t> _overruns = 0;
+};
@@ -0,0 +1,677 @@
+#include "caudioengine.h"
+#include "allocationcounter.h"
+
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <stdint.h>
+#include <thread>
+
+static constexpr size_t scratchFrames = 1024;
+// Seconds' worth of callbacks at the shortest periods.
+static constexpr size_t renderRecordsCapacity = 8192;
+static constexpr size_t scheduledChangesCapacity = 4096;
+// The part of it scheduleChanges() can't take, so that the setters still work with a full schedule.
+static constexpr size_t immediateChangesReserve = 256;
+// The first callbacks may still touch lazily initialized state; after that, a heap allocation in the callback is a bug.
+static constexpr uint64_t warmUpCallbacks = 2;
+
+CAudioEngine::CAudioEngine(std::unique_ptr<CAudioBackend> backend) :
+	_backend{ std::move(backend) }
+{
+	assert_r(_backend);
+	_renderRecords.reset(renderRecordsCapacity);
+	_scheduledChanges.reset(scheduledChangesCapacity);
+	_pendingChanges.reserve(_scheduledChanges.capacity());
+	_appliedChanges.reset(scheduledChangesCapacity);
+	// The render thread isn't running yet.
+	_generator = &_signal.params();
+	_backend->setStreamErrorCallback([this] {
+		if (_playbackErrorCallback)
+			_playbackErrorCallback();
+	});
+}
+
+CAudioEngine::~CAudioEngine()
+{
+	stopPlayback();
+}
+
+void CAudioEngine::setFrequency(float hz)
+{
+	queueChange(ScheduledChange::Frequency, hz);
+}
+
+void CAudioEngine::setGain(float gain)
+{
+	queueChange(ScheduledChange::Gain, gain);
+}
+
+void CAudioEngine::setChannelIndex(size_t channelIndex)
+{
+	queueChange(ScheduledChange::Channel, static_cast<double>(channelIndex));
+}
+
+void CAudioEngine::setWaveform(const Waveform waveform, const float pulseWidth)
+{
+	const std::array<ScheduledChange, 2> changes {{
+		{ 0, static_cast<double>(waveform), ScheduledChange::Waveform, 0 },
+		{ 0, pulseWidth, ScheduledChange::PulseWidth, 0 }
+	}};
+	queueChanges(changes.data(), changes.size());
+}
+
+void CAudioEngine::startSweep(const SweepParams& sweep)
+{
+	_signal.startSweep(sweep);
+	queueChange(ScheduledChange::Generator);
+}
+
+void CAudioEngine::setOscillators(const std::vector<OscillatorBank::Oscillator>& oscillators)
+{
+	_signal.setOscillators(std::make_shared<OscillatorBank>(oscillators));
+	queueChange(ScheduledChange::Generator);
+}
+
+void CAudioEngine::startNoise(const NoiseParams& noise, const bool allChannels)
+{
+	_signal.startNoise(noise, allChannels);
+	queueChange(ScheduledChange::Generator);
+}
+
+void CAudioEngine::startSequence(std::shared_ptr<Sequence> sequence)
+{
+	assert_and_return_r(sequence, );
+	_signal.startSequence(std::move(sequence));
+	queueChange(ScheduledChange::Generator);
+}
+
+bool CAudioEngine::scheduleChanges(const ScheduledChange* changes, const size_t n)
+{
+	// The wavetables are built on the calling thread if this is the first time the waveform is used.
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (changes[i].parameter == ScheduledChange::Waveform && static_cast<Waveform>(changes[i].value) != Waveform::Sine)
+			(void)Wavetable::get(static_cast<Waveform>(changes[i].value));
+	}
+
+	if (!pushChanges(changes, n, _scheduledChanges.capacity() - immediateChangesReserve))
+		return false;
+
+	applyChangesIfStopped();
+	return true;
+}
+
+size_t CAudioEngine::schedulableChanges() const noexcept
+{
+	const size_t capacity = _scheduledChanges.capacity() - immediateChangesReserve;
+	return capacity - std::min(_nChangesInFlight.load(std::memory_order_acquire), capacity);
+}
+
+size_t CAudioEngine::appliedChanges(AppliedChange* changes, const size_t maxCount) noexcept
+{
+	return _appliedChanges.pop(changes, maxCount);
+}
+
+uint64_t CAudioEngine::playbackPosition() const noexcept
+{
+	return _playbackPosition.load(std::memory_order_relaxed);
+}
+
+void CAudioEngine::setDitherEnabled(bool enabled)
+{
+	_bDither = enabled;
+}
+
+void CAudioEngine::setGainRamp(const RampShape shape, const double seconds)
+{
+	assert_and_return_r(seconds >= 0.0, );
+	_rampShape = shape;
+	_rampSeconds = seconds;
+}
+
+void CAudioEngine::setGlitchDetection(const bool enabled, std::string logFilePath, std::function<void(const GlitchEvent&)> callback)
+{
+	_bGlitchDetection = enabled;
+	_glitchLogFilePath = std::move(logFilePath);
+	_glitchCallback = std::move(callback);
+}
+
+uint64_t CAudioEngine::glitchCount() const noexcept
+{
+	return _glitchMonitor.events();
+}
+
+void CAudioEngine::setStreamOptions(const StreamOptions& options)
+{
+	_streamOptions = options;
+}
+
+bool CAudioEngine::playTone(const std::wstring& deviceId)
+{
+	if (_bPlaybackStarted)
+		return true;
+
+	if (!openDevice(deviceId))
+		return false;
+
+	_oscillator.resetPhase();
+	_noise.prepare(_format.sampleRate, _format.channels.size());
+	// Forces a pending sweep, noise sequence or step sequence to be (re)started from the beginning. The render thread isn't running yet, so reading the params here is safe.
+	_generator = &_signal.params();
+	_currentSweepId = _generator->sweepId - 1;
+	_currentNoiseId = _generator->noiseId - 1;
+	_currentSequenceId = _generator->sequenceId - 1;
+	if (const auto& bank = _generator->bank)
+		bank->resetPhases();
+
+	_samplesPlayedSoFar = 0;
+	_playbackPosition = 0;
+	_renderCallbacks = 0;
+	_deadlineMisses = 0;
+	return startRendering();
+}
+
+void CAudioEngine::stopPlayback()
+{
+	if (!_bPlaybackStarted)
+		return;
+
+	fadeOut();
+	stopStream();
+
+	// The next playTone() counts the frames from 0 again. The render thread is stopped, so this thread is the consumer now.
+	do
+		receiveChanges();
+	while (applyChanges(UINT64_MAX, 0));
+
+	_samplesPlayedSoFar = 0;
+	_playbackPosition = 0;
+}
+
+void CAudioEngine::fadeOut()
+{
+	using Clock = std::chrono::steady_clock;
+	const std::chrono::duration<double> latency{ _backend->latencyInfo().outputLatencyMs / 1000.0 };
+	// The render thread may have stopped being called, e. g. at the end of a file.
+	const auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{ _rampSeconds } + 2 * latency + std::chrono::milliseconds{ 50 });
+
+	_bFadeOutRequested = true;
+	while (!_bFadedOut.load(std::memory_order_acquire) && Clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+
+	// The buffered frames ahead of the silence have to play out too.
+	if (_bFadedOut)
+		std::this_thread::sleep_for(latency);
+}
+
+void CAudioEngine::stopStream()
+{
+	using Clock = std::chrono::steady_clock;
+	const auto stopTime = Clock::now();
+	_backend->stop();
+	_lastStopLatencyMs = std::chrono::duration<double, std::milli>{ Clock::now() - stopTime }.count();
+
+	// Analyses the rest of the frames the render thread has pushed.
+	_glitchMonitor.stop();
+
+	_bPlaybackStarted = false;
+}
+
+bool CAudioEngine::isPlaying() const noexcept
+{
+	return _bPlaybackStarted;
+}
+
+double CAudioEngine::lastStopLatencyMs() const noexcept
+{
+	return _lastStopLatencyMs;
+}
+
+void CAudioEngine::setPlaybackErrorCallback(std::function<void()> callback)
+{
+	assert_and_return_r(!_bPlaybackStarted, );
+	_playbackErrorCallback = std::move(callback);
+}
+
+bool CAudioEngine::recoverPlayback()
+{
+	assert_and_return_r(_bPlaybackStarted, false);
+	return restartStream(_deviceId);
+}
+
+std::optional<double> CAudioEngine::switchDevice(const std::wstring& deviceId)
+{
+	assert_and_return_r(_bPlaybackStarted, {});
+
+	if (const auto gapMs = _backend->switchDevice(deviceId, _streamOptions))
+	{
+		_deviceId = deviceId;
+		return gapMs;
+	}
+
+	using Clock = std::chrono::steady_clock;
+	const auto stopTime = Clock::now();
+	if (!restartStream(deviceId))
+		return {};
+
+	return std::chrono::duration<double, std::milli>{ Clock::now() - stopTime }.count();
+}
+
+bool CAudioEngine::restartStream(const std::wstring& deviceId)
+{
+	stopStream();
+
+	const AudioFormat previousFormat = _format;
+	if (!openDevice(deviceId))
+		return false;
+
+	// The noise filters depend on the rate, the streams - on the channel count. Everything else carries on where it was.
+	if (_format.sampleRate != previousFormat.sampleRate || _format.channels.size() != previousFormat.channels.size())
+		_noise.prepare(_format.sampleRate, _format.channels.size());
+
+	return startRendering();
+}
+
+bool CAudioEngine::openDevice(const std::wstring& deviceId)
+{
+	assert_and_return_r(_backend->open(deviceId, _streamOptions), false);
+	_format = _backend->format();
+	// The buffers below are about to be reallocated.
+	_lockedBuffers.clear();
+	_bMemoryLocked = false;
+	_deviceId = deviceId;
+
+	_sampleWriter = SampleWriter{ _format, _bDither };
+	assert_and_return_message_r(_sampleWriter.isValid(), "Unsupported sample format: " + std::to_string(_format.bitsPerSample) + " bits", false);
+	_scratch.resize(scratchFrames * _format.channels.size());
+
+	// Enough room for the consumer to fall behind by half a second.
+	_currentSamplesBuffer.reset(_format.channels.size(), _format.sampleRate / 2);
+
+	_oscillator.setSampleRate(_format.sampleRate);
+	// Fades in from silence every time the stream (re)starts.
+	_gains.prepare(_format.channels.size(), _format.sampleRate, _rampShape, _rampSeconds);
+	_gains.setGain(_tone.gain);
+
+	if (_streamOptions.lockMemory)
+		lockBuffers();
+
+	return true;
+}
+
+bool CAudioEngine::startRendering()
+{
+	// The render thread isn't running yet.
+	_lastCallbackTime = {};
+	_lastUnderruns = 0;
+	_bFadeOutRequested = false;
+	_bFadedOut = false;
+	_bFadingOut = false;
+
+	if (_bGlitchDetection)
+		_glitchMonitor.start(_format.channels.size(), _format.sampleRate, _glitchLogFilePath, _glitchCallback);
+
+	_bPlaybackStarted = _backend->start([this](void* dst, uint32_t nFrames) {
+		render(dst, nFrames);
+	});
+
+	return _bPlaybackStarted;
+}
+
+void CAudioEngine::lockBuffers()
+{
+	// The engine itself holds the oscillator, noise and sample writer state.
+	_lockedBuffers.emplace_back(this, sizeof(*this));
+	_lockedBuffers.emplace_back(_scratch.data(), _scratch.size() * sizeof(float));
+	_lockedBuffers.emplace_back(_currentSamplesBuffer.storage(), _currentSamplesBuffer.storageSize());
+	_lockedBuffers.emplace_back(_renderRecords.data(), _renderRecords.capacity() * sizeof(RenderCallbackRecord));
+	_lockedBuffers.emplace_back(_scheduledChanges.data(), _scheduledChanges.storageSize());
+	_lockedBuffers.emplace_back(_pendingChanges.data(), _pendingChanges.capacity() * sizeof(PendingChange));
+	_lockedBuffers.emplace_back(_appliedChanges.data(), _appliedChanges.capacity() * sizeof(AppliedChange));
+
+	_bMemoryLocked = std::all_of(_lockedBuffers.cbegin(), _lockedBuffers.cend(), [](const LockedMemory& lock) { return lock.isLocked(); });
+}
+
+LatencyInfo CAudioEngine::latencyInfo() const noexcept
+{
+	return _backend->latencyInfo();
+}
+
+AudioFormat CAudioEngine::mixFormat(const std::wstring& deviceId)
+{
+	return _deviceRegistry.mixFormat(deviceId);
+}
+
+std::vector<AudioDeviceInfo> CAudioEngine::devices()
+{
+	return _deviceRegistry.devices();
+}
+
+std::optional<AudioDeviceInfo> CAudioEngine::device(const std::wstring& deviceId)
+{
+	return _deviceRegistry.device(deviceId);
+}
+
+void CAudioEngine::setDeviceChangeCallback(std::function<void()> callback)
+{
+	_deviceRegistry.setChangeCallback(std::move(callback));
+}
+
+const AudioFormat& CAudioEngine::format() const noexcept
+{
+	return _format;
+}
+
+bool CAudioEngine::currentSamplesBuffer(vector2D<float>& samples, const size_t maxFrames)
+{
+	return _currentSamplesBuffer.samples(samples, maxFrames);
+}
+
+uint64_t CAudioEngine::monitorOverruns() const noexcept
+{
+	return _currentSamplesBuffer.overruns();
+}
+
+uint64_t CAudioEngine::monitorDroppedFrames() const noexcept
+{
+	return _currentSamplesBuffer.droppedFrames();
+}
+
+uint64_t CAudioEngine::renderCallbacks() const noexcept
+{
+	return _renderCallbacks.load(std::memory_order_relaxed);
+}
+
+uint64_t CAudioEngine::deadlineMisses() const noexcept
+{
+	return _deadlineMisses.load(std::memory_order_relaxed);
+}
+
+bool CAudioEngine::isMemoryLocked() const noexcept
+{
+	return _bMemoryLocked;
+}
+
+uint64_t CAudioEngine::underruns() const noexcept
+{
+	return _backend->underruns();
+}
+
+void CAudioEngine::collectRenderStats(RenderStats& stats)
+{
+	std::array<RenderCallbackRecord, 256> records;
+	while (const size_t n = _renderRecords.pop(records.data(), records.size()))
+	{
+		for (size_t i = 0; i < n; ++i)
+			stats.add(records[i]);
+	}
+
+	stats.addDroppedRecords(_droppedRenderRecords.exchange(0, std::memory_order_relaxed));
+}
+
+void CAudioEngine::render(void* dst, const uint32_t nFrames) noexcept
+{
+	const AllocationGuard allocationGuard{ "The render callback", _renderCallbacks.load(std::memory_order_relaxed) >= warmUpCallbacks };
+
+	using Clock = std::chrono::steady_clock;
+	using Nanoseconds = std::chrono::nanoseconds;
+	const auto start = Clock::now();
+	const auto audioDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{ static_cast<double>(nFrames) / _format.sampleRate });
+
+	RenderCallbackRecord record;
+	record.timestampNs = std::chrono::duration_cast<Nanoseconds>(start.time_since_epoch()).count();
+	record.budgetNs = static_cast<uint32_t>(std::chrono::duration_cast<Nanoseconds>(audioDuration).count());
+	record.frames = nFrames;
+
+	if (_lastCallbackTime != Clock::time_point{})
+	{
+		const auto jitter = start - (_lastCallbackTime + _lastCallbackAudio);
+		record.wakeupJitterNs = static_cast<int32_t>(std::clamp<int64_t>(std::chrono::duration_cast<Nanoseconds>(jitter).count(), INT32_MIN, INT32_MAX));
+
+		// The device can only wait for this callback for as long as the previous one's frames play, give or take the wakeup jitter.
+		if (jitter > _lastCallbackAudio / 2)
+		{
+			record.flags |= RenderCallbackRecord::DeadlineMiss;
+			_deadlineMisses.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	_lastCallbackTime = start;
+	_lastCallbackAudio = audioDuration;
+	_renderCallbacks.fetch_add(1, std::memory_order_relaxed);
+
+	if (const uint64_t underruns = _backend->underruns(); underruns != _lastUnderruns)
+	{
+		_lastUnderruns = underruns;
+		record.flags |= RenderCallbackRecord::Underrun;
+	}
+
+	receiveChanges();
+	if (!_bFadingOut && _bFadeOutRequested.load(std::memory_order_relaxed))
+	{
+		_bFadingOut = true;
+		_gains.setGain(0.0f);
+	}
+
+	// The block is split at every change.
+	bool bSignalChanged = false;
+	bool bMonitored = true;
+	for (uint32_t offset = 0; offset < nFrames;)
+	{
+		const uint64_t position = _samplesPlayedSoFar + offset;
+		const auto offsetDuration = std::chrono::duration_cast<Nanoseconds>(std::chrono::duration<double>{ static_cast<double>(offset) / _format.sampleRate });
+		if (applyChanges(position, record.timestampNs + offsetDuration.count()))
+			bSignalChanged = true;
+
+		uint32_t n = nFrames - offset;
+		if (!_pendingChanges.empty() && _pendingChanges.front().change.frame < position + n)
+			n = static_cast<uint32_t>(_pendingChanges.front().change.frame - position);
+
+		bMonitored &= renderFrames(dst, offset, n, bSignalChanged);
+		bSignalChanged = false;
+		offset += n;
+	}
+
+	_samplesPlayedSoFar += nFrames;
+	_playbackPosition.store(_samplesPlayedSoFar, std::memory_order_relaxed);
+	if (_bFadingOut && !_gains.isRamping())
+		_bFadedOut.store(true, std::memory_order_release);
+
+	if (!bMonitored)
+		record.flags |= RenderCallbackRecord::MonitorOverrun;
+
+	record.durationNs = static_cast<uint32_t>(std::chrono::duration_cast<Nanoseconds>(Clock::now() - start).count());
+	if (!_renderRecords.push(&record, 1))
+		_droppedRenderRecords.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool CAudioEngine::renderFrames(void* dst, const uint32_t offset, const uint32_t nFrames, const bool bSignalChanged) noexcept
+{
+	const size_t nChannels = _format.channels.size();
+	const uint64_t position = _samplesPlayedSoFar + offset;
+	const bool bGlitchDetection = _glitchMonitor.isRunning();
+
+	if (_sampleWriter.isFloat32())
+	{
+		float* out = static_cast<float*>(dst) + offset * nChannels;
+		renderSignal(out, nFrames);
+		if (bGlitchDetection)
+			_glitchMonitor.push(out, nFrames, position, bSignalChanged);
+		return _currentSamplesBuffer.setData(out, nFrames, nChannels);
+	}
+
+	const size_t frameSize = nChannels * _sampleWriter.bytesPerSample();
+	auto* out = static_cast<uint8_t*>(dst) + offset * frameSize;
+	bool bMonitored = true;
+	for (size_t chunkOffset = 0; chunkOffset < nFrames; chunkOffset += scratchFrames)
+	{
+		const size_t n = std::min<size_t>(scratchFrames, nFrames - chunkOffset);
+		renderSignal(_scratch.data(), n);
+		bMonitored &= _currentSamplesBuffer.setData(_scratch.data(), n, nChannels);
+		if (bGlitchDetection)
+			_glitchMonitor.push(_scratch.data(), n, position + chunkOffset, bSignalChanged && chunkOffset == 0);
+		_sampleWriter.write(out + chunkOffset * frameSize, _scratch.data(), n * nChannels);
+	}
+
+	return bMonitored;
+}
+
+void CAudioEngine::queueChange(const ScheduledChange::Parameter parameter, const double value)
+{
+	const ScheduledChange change{ 0, value, parameter, 0 };
+	queueChanges(&change, 1);
+}
+
+void CAudioEngine::queueChanges(const ScheduledChange* changes, const size_t n)
+{
+	assert_message_r(pushChanges(changes, n, _scheduledChanges.capacity()), "The parameter change queue is full");
+	applyChangesIfStopped();
+}
+
+void CAudioEngine::applyChangesIfStopped() noexcept
+{
+	// Same as in stopPlayback(), this thread is the consumer while the render thread is stopped. The changes scheduled for a later
+	// frame stay pending until the playback starts.
+	if (!_bPlaybackStarted)
+	{
+		receiveChanges();
+		(void)applyChanges(0, 0);
+	}
+}
+
+bool CAudioEngine::pushChanges(const ScheduledChange* changes, const size_t n, const size_t maxInFlight) noexcept
+{
+	size_t nInFlight = _nChangesInFlight.load(std::memory_order_acquire);
+	do
+	{
+		if (nInFlight + n > maxInFlight)
+			return false;
+	} while (!_nChangesInFlight.compare_exchange_weak(nInFlight, nInFlight + n, std::memory_order_acq_rel, std::memory_order_acquire));
+
+	// The reservation guarantees the room: the queue holds as many changes as _nChangesInFlight can count.
+	if (_scheduledChanges.push(changes, n))
+		return true;
+
+	assert_unconditional_r("The parameter change queue is out of sync with its reservations");
+	_nChangesInFlight.fetch_sub(n, std::memory_order_release);
+	return false;
+}
+
+bool CAudioEngine::isDueLater(const PendingChange& l, const PendingChange& r) noexcept
+{
+	return l.change.frame != r.change.frame ? l.change.frame > r.change.frame : l.order > r.order;
+}
+
+void CAudioEngine::receiveChanges() noexcept
+{
+	ScheduledChange change;
+	while (_scheduledChanges.pop(&change, 1) == 1)
+	{
+		// Within the reserved capacity, see pushChanges().
+		_pendingChanges.push_back({ change, _nChangesReceived++ });
+		std::push_heap(_pendingChanges.begin(), _pendingChanges.end(), isDueLater);
+	}
+}
+
+bool CAudioEngine::applyChanges(const uint64_t position, const int64_t timestampNs) noexcept
+{
+	size_t nApplied = 0;
+	for (; !_pendingChanges.empty() && _pendingChanges.front().change.frame <= position; ++nApplied)
+	{
+		std::pop_heap(_pendingChanges.begin(), _pendingChanges.end(), isDueLater);
+		const ScheduledChange change = _pendingChanges.back().change;
+		_pendingChanges.pop_back();
+		switch (change.parameter)
+		{
+		case ScheduledChange::Frequency:
+			_tone.hz = static_cast<float>(change.value);
+			_tone.mode = SignalParams::Tone;
+			break;
+		case ScheduledChange::Gain:
+			_tone.gain = static_cast<float>(change.value);
+			if (!_bFadingOut)
+				_gains.setGain(_tone.gain);
+			break;
+		case ScheduledChange::Channel:
+		{
+			const size_t previousChannel = _tone.channelIndex;
+			_tone.channelIndex = static_cast<size_t>(change.value);
+			// The modes that render on the selected channel only.
+			const bool bSingleChannel = _tone.mode == SignalParams::Tone || _tone.mode == SignalParams::Sweep
+				|| (_tone.mode == SignalParams::Noise && !_generator->noiseOnAllChannels);
+			if (bSingleChannel)
+				_gains.crossfade(previousChannel, _tone.channelIndex, _bFadingOut ? 0.0f : _tone.gain);
+			break;
+		}
+		case ScheduledChange::Waveform:
+			_tone.waveform = static_cast<Waveform>(change.value);
+			break;
+		case ScheduledChange::PulseWidth:
+			_tone.pulseWidth = static_cast<float>(change.value);
+			break;
+		case ScheduledChange::Generator:
+			// Published before the change was queued.
+			_generator = &_signal.params();
+			_tone.mode = _generator->mode;
+			break;
+		}
+
+		if (timestampNs != 0 && change.id != 0)
+		{
+			const AppliedChange applied{ change.id, change.frame, position, timestampNs };
+			// Dropped if nobody is collecting them.
+			(void)_appliedChanges.push(&applied, 1);
+		}
+	}
+
+	if (nApplied > 0)
+		_nChangesInFlight.fetch_sub(nApplied, std::memory_order_release);
+	return nApplied > 0;
+}
+
+void CAudioEngine::renderSignal(float* buffer, const size_t nFrames) noexcept
+{
+	const size_t nChannels = _format.channels.size();
+	const SignalParams& generator = *_generator;
+
+	if (_tone.mode == SignalParams::Noise)
+	{
+		if (generator.noiseId != _currentNoiseId)
+		{
+			_currentNoiseId = generator.noiseId;
+			_noise.setParams(generator.noise);
+		}
+
+		_noise.render(buffer, nFrames, nChannels, generator.noiseOnAllChannels ? NoiseGenerator::allChannels : _tone.channelIndex);
+	}
+	else if (_tone.mode == SignalParams::Bank && generator.bank)
+		generator.bank->render(buffer, nFrames, nChannels, _format.sampleRate);
+	else if (_tone.mode == SignalParams::Sequence && generator.sequence)
+	{
+		if (generator.sequenceId != _currentSequenceId)
+		{
+			_currentSequenceId = generator.sequenceId;
+			generator.sequence->rewind();
+		}
+
+		// The sequence drives the oscillator and the noise generator itself.
+		generator.sequence->render(buffer, nFrames, nChannels, _format.sampleRate, _oscillator, _noise);
+	}
+	else if (_tone.mode == SignalParams::Sweep)
+	{
+		if (generator.sweepId != _currentSweepId)
+		{
+			_currentSweepId = generator.sweepId;
+			_oscillator.startSweep(generator.sweep);
+		}
+
+		_oscillator.renderSweep(buffer, nFrames, nChannels, _tone.channelIndex);
+	}
+	else
+		_oscillator.renderTone(buffer, nFrames, nChannels, _tone.channelIndex, _tone.hz, _tone.waveform, _tone.pulseWidth);
+
+	_gains.apply(buffer, nFrames);
+}
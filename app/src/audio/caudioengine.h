@@ -0,0 +1,324 @@
+#pragma once
+#include "audiosamplesbuffer.h"
+#include "caudiobackend.h"
+#include "cdeviceregistry.h"
+#include "channelgains.h"
+#include "cglitchmonitor.h"
+#include "mpscringbuffer.hpp"
+#include "noise.h"
+#include "oscillator.h"
+#include "oscillatorbank.h"
+#include "realtimethread.h"
+#include "renderstats.h"
+#include "samplewriter.h"
+#include "scheduledchange.h"
+#include "sequence.h"
+#include "spscringbuffer.hpp"
+#include "triplebuffer.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Owns the signal generator state and feeds it to whichever CAudioBackend it has been given.
+class CAudioEngine final
+{
+public:
+	explicit CAudioEngine(std::unique_ptr<CAudioBackend> backend);
+	~CAudioEngine();
+
+	// Frequency, gain, channel and waveform changes are queued for the render thread (see scheduleChanges()) to take effect
+	// at the start of its next callback, in the order they were made. While stopped, they take effect right away on the calling thread,
+	// which must be the one that calls playTone() and stopPlayback().
+
+	// Switches to a constant tone of the given frequency.
+	void setFrequency(float hz);
+	// Linear gain of the output, 1 is full scale. Reached through a gain ramp (see setGainRamp()).
+	void setGain(float gain);
+	// A tone, sweep or noise moved to another channel is crossfaded over a gain ramp.
+	void setChannelIndex(size_t channelIndex);
+	// The waveform of the constant tone; sweeps and oscillator banks are always sine. pulseWidth is the Pulse duty cycle.
+	// Builds the waveform's wavetables on the calling thread if this is the first time it's used.
+	void setWaveform(Waveform waveform, float pulseWidth = 0.5f);
+	// Starts (or restarts) a frequency sweep; it keeps running until the next setFrequency() call.
+	void startSweep(const SweepParams& sweep);
+	// Plays any number of simultaneous tones on any channels (see OscillatorBank) until the next setFrequency() or startSweep() call.
+	void setOscillators(const std::vector<OscillatorBank::Oscillator>& oscillators);
+	// Noise on the selected channel, or an independent stream on every channel. Restarts the sequence from the seed.
+	void startNoise(const NoiseParams& noise, bool allChannels = false);
+	// Plays the sequence from its first step; once it's finished, silence until the next generator change.
+	// The sequence must not be handed to another engine while this one is playing it.
+	void startSequence(std::shared_ptr<Sequence> sequence);
+
+	// Queues parameter changes for the render thread, which applies each exactly at its frame, splitting the callback there;
+	// a change whose frame has already been rendered takes effect at the start of the next callback. Changes due at the same frame
+	// are applied in the order they were queued. All or nothing: returns false if the changes queued or still pending would exceed
+	// the engine's capacity, which holds a few thousand; part of it is kept for the setters above. Changes still pending when
+	// the playback is stopped take effect right away. Lock-free, any number of threads while playing; while stopped, only the thread
+	// that calls playTone() and stopPlayback(), which then applies the changes due at frame 0 itself, same as the setters.
+	bool scheduleChanges(const ScheduledChange* changes, size_t n);
+	// How many changes scheduleChanges() would take right now. Only grows as the render thread applies them, unless other threads
+	// queue changes too. startSweep(), setOscillators(), startNoise() and startSequence() take one each from the same capacity.
+	[[nodiscard]] size_t schedulableChanges() const noexcept;
+	// The changes the render thread has applied since the last call, up to maxCount. Not to be called from more than one thread.
+	size_t appliedChanges(AppliedChange* changes, size_t maxCount) noexcept;
+	// Frames rendered since playTone(), as of the end of the last render callback; 0 after stopPlayback().
+	[[nodiscard]] uint64_t playbackPosition() const noexcept;
+
+	// Applies TPDF dither when the device takes integer samples; takes effect from the next playTone().
+	void setDitherEnabled(bool enabled);
+	// The shape and length of the gain ramps: the fade-in on start and stream restarts, the fade-out on stop, gain changes and
+	// channel switches. Takes effect from the next playTone().
+	void setGainRamp(RampShape shape, double seconds);
+
+	// Analyses every rendered frame for discontinuities, dropouts and clipping on a background thread (see CGlitchMonitor),
+	// appending the glitches found to logFilePath unless it's empty. The callback is called on the analysis thread.
+	// Takes effect from the next playTone(); stream restarts carry on with the same settings.
+	void setGlitchDetection(bool enabled, std::string logFilePath = {}, std::function<void(const GlitchEvent&)> callback = {});
+	// Glitches found since the stream was last (re)started.
+	[[nodiscard]] uint64_t glitchCount() const noexcept;
+
+	// Exclusive / low-latency mode, render thread priority and memory locking; takes effect from the next playTone().
+	void setStreamOptions(const StreamOptions& options);
+
+	bool playTone(const std::wstring& deviceId);
+	// Fades the output out first, which takes the ramp's length plus the output latency.
+	void stopPlayback();
+	[[nodiscard]] bool isPlaying() const noexcept;
+	// How long the last stopPlayback() has taken to stop the backend's render thread.
+	[[nodiscard]] double lastStopLatencyMs() const noexcept;
+
+	// Called on the render thread when the stream fails (e. g. the device has been unplugged) and the thread exits.
+	// isPlaying() stays true until recoverPlayback() or stopPlayback() is called from the control thread. Must be set while stopped.
+	void setPlaybackErrorCallback(std::function<void()> callback);
+	// Restarts the failed stream on the same device, carrying the generator state over.
+	bool recoverPlayback();
+
+	// Moves the playback to another device, carrying the generator state over (phases, sweep and noise positions).
+	// The backend hands the running stream over where it can (see CAudioBackend::switchDevice()), otherwise the stream is restarted.
+	// Returns the gap in the output in ms, nothing if the new device couldn't be started (the playback is stopped then).
+	[[nodiscard]] std::optional<double> switchDevice(const std::wstring& deviceId);
+
+	// The buffer size, period and output latency achieved by the running stream.
+	[[nodiscard]] LatencyInfo latencyInfo() const noexcept;
+
+	// Served from the device registry cache, see CDeviceRegistry.
+	[[nodiscard]] AudioFormat mixFormat(const std::wstring& deviceId);
+	[[nodiscard]] std::vector<AudioDeviceInfo> devices();
+	[[nodiscard]] std::optional<AudioDeviceInfo> device(const std::wstring& deviceId);
+	// Called on an arbitrary thread when the device list or a mix format changes. Everything queried before is stale.
+	void setDeviceChangeCallback(std::function<void()> callback);
+
+	// The stream format of the current playback session.
+	[[nodiscard]] const AudioFormat& format() const noexcept;
+
+	// Monitoring tap, see AudioSamplesBuffer::samples(). Not to be called from more than one thread.
+	bool currentSamplesBuffer(vector2D<float>& samples, size_t maxFrames);
+	[[nodiscard]] uint64_t monitorOverruns() const noexcept;
+	[[nodiscard]] uint64_t monitorDroppedFrames() const noexcept;
+
+	// Render callbacks since playTone(), and how many of them have come late: more than 1.5 times the duration of the previous
+	// callback's audio after it. Compare with StreamOptions::realtimePriority on and off.
+	[[nodiscard]] uint64_t renderCallbacks() const noexcept;
+	[[nodiscard]] uint64_t deadlineMisses() const noexcept;
+	// Whether the render buffers are page-locked, see StreamOptions::lockMemory.
+	[[nodiscard]] bool isMemoryLocked() const noexcept;
+	// See CAudioBackend::underruns().
+	[[nodiscard]] uint64_t underruns() const noexcept;
+
+	// Adds the timing records of the render callbacks since the last call to stats. Not to be called from more than one thread.
+	// The render thread keeps the last few seconds' worth, calling this more rarely loses records (see RenderStats::droppedRecords()).
+	void collectRenderStats(RenderStats& stats);
+
+private:
+	struct SignalParams;
+
+	// Opens the device and sets the render state up for its format; the generator state is left as is.
+	bool openDevice(const std::wstring& deviceId);
+	bool startRendering();
+	// Page-locks the render thread's buffers; they must not be reallocated until _lockedBuffers is cleared.
+	void lockBuffers();
+	// Ramps the output down to silence and waits for the silence to reach the device, unless the render thread isn't being called.
+	void fadeOut();
+	// Stops the backend's render thread; pending scheduled changes are kept.
+	void stopStream();
+	// Stops the stream and starts it anew on deviceId without resetting the generator state.
+	bool restartStream(const std::wstring& deviceId);
+
+	// Runs on the backend's render thread.
+	void render(void* dst, uint32_t nFrames) noexcept;
+	// Renders nFrames starting at offset in dst in the device's format.
+	bool renderFrames(void* dst, uint32_t offset, uint32_t nFrames, bool bSignalChanged) noexcept;
+	// Generates nFrames of interleaved float samples.
+	void renderSignal(float* buffer, size_t nFrames) noexcept;
+
+	// A change due as soon as possible; asserts if the queue is full.
+	void queueChange(ScheduledChange::Parameter parameter, double value = 0.0);
+	// Same for several changes at once.
+	void queueChanges(const ScheduledChange* changes, size_t n);
+	// While stopped, nothing consumes the queue, so the changes due at frame 0 are applied on the calling thread instead.
+	void applyChangesIfStopped() noexcept;
+	// Reserves room for the changes in _nChangesInFlight, unless that would exceed maxInFlight, and queues them.
+	bool pushChanges(const ScheduledChange* changes, size_t n, size_t maxInFlight) noexcept;
+	// Moves all the queued changes to _pendingChanges.
+	void receiveChanges() noexcept;
+	// Applies the pending changes due at or before position and reports them unless timestampNs is 0; returns whether there were any.
+	// Both are also called by the control thread while the render thread is stopped.
+	bool applyChanges(uint64_t position, int64_t timestampNs) noexcept;
+
+private:
+	// The generator other than a constant tone, published by the control thread.
+	struct SignalParams {
+		enum Mode { Tone, Sweep, Bank, Noise, Sequence };
+
+		Mode mode = Tone;
+
+		SweepParams sweep;
+		// Incremented by every startSweep() call so that the render thread can tell a new sweep from the current one.
+		uint32_t sweepId = 0;
+
+		NoiseParams noise;
+		bool noiseOnAllChannels = false;
+		// Same as sweepId, for startNoise().
+		uint32_t noiseId = 0;
+
+		// Built by the control thread; only the render thread advances its phases. Released by whichever writer overwrites the last reference.
+		std::shared_ptr<OscillatorBank> bank;
+
+		// Walked by the render thread only, same as the bank.
+		std::shared_ptr<::Sequence> sequence;
+		// Same as sweepId, for startSequence().
+		uint32_t sequenceId = 0;
+	};
+
+	struct Signal {
+		// Render thread only; never blocks. The previously returned reference is only valid until the next call.
+		inline const SignalParams& params() noexcept {
+			return _params.read();
+		}
+
+		inline void startSweep(const SweepParams& sweep) noexcept {
+			_params.modify([&sweep](SignalParams& p) {
+				p.sweep = sweep;
+				p.mode = SignalParams::Sweep;
+				++p.sweepId;
+			});
+		}
+
+		inline void setOscillators(std::shared_ptr<OscillatorBank> bank) noexcept {
+			_params.modify([&bank](SignalParams& p) {
+				p.bank = std::move(bank);
+				p.mode = SignalParams::Bank;
+			});
+		}
+
+		inline void startNoise(const NoiseParams& noise, bool allChannels) noexcept {
+			_params.modify([&noise, allChannels](SignalParams& p) {
+				p.noise = noise;
+				p.noiseOnAllChannels = allChannels;
+				p.mode = SignalParams::Noise;
+				++p.noiseId;
+			});
+		}
+
+		inline void startSequence(std::shared_ptr<::Sequence> sequence) noexcept {
+			_params.modify([&sequence](SignalParams& p) {
+				p.sequence = std::move(sequence);
+				p.mode = SignalParams::Sequence;
+				++p.sequenceId;
+			});
+		}
+
+	private:
+		TripleBuffer<SignalParams> _params;
+	};
+
+	const std::unique_ptr<CAudioBackend> _backend;
+	CDeviceRegistry _deviceRegistry{ *_backend };
+	AudioFormat _format;
+	StreamOptions _streamOptions;
+
+	Signal _signal;
+
+	// Render thread state
+	ToneOscillator _oscillator;
+	uint32_t _currentSweepId = 0;
+	NoiseGenerator _noise;
+	uint32_t _currentNoiseId = 0;
+	uint32_t _currentSequenceId = 0;
+
+	// Set by the changes only.
+	struct ToneParams {
+		SignalParams::Mode mode = SignalParams::Tone;
+		float hz = 1000.0f;
+		float gain = 1.0f;
+		size_t channelIndex = 0;
+		Waveform waveform = Waveform::Sine;
+		float pulseWidth = 0.5f;
+	};
+	ToneParams _tone;
+	// Picked up from _signal by the last Generator change.
+	const SignalParams* _generator = nullptr;
+	// Received changes that aren't due yet: a min-heap on the frame, then on the order of receiving. Reserved for all the changes
+	// _nChangesInFlight allows, so it's never reallocated.
+	struct PendingChange {
+		ScheduledChange change;
+		uint64_t order = 0;
+	};
+	std::vector<PendingChange> _pendingChanges;
+	uint64_t _nChangesReceived = 0;
+	// The heap order: the earliest change on top, the ones due at the same frame in the order they were queued in.
+	static bool isDueLater(const PendingChange& l, const PendingChange& r) noexcept;
+	// Queued and pending changes. Room is reserved here before queuing and released once a change has been applied.
+	std::atomic<size_t> _nChangesInFlight = 0;
+
+	// _tone.gain applied per channel, with ramps.
+	ChannelGains _gains;
+	RampShape _rampShape = RampShape::RaisedCosine;
+	double _rampSeconds = 0.01;
+	// Set by fadeOut(); the render thread ramps the gain down to 0 (_bFadingOut) and reports when it's got there.
+	std::atomic_bool _bFadeOutRequested = false;
+	std::atomic_bool _bFadedOut = false;
+	bool _bFadingOut = false;
+
+	// Converts the generated float samples for non-float devices, chunk by chunk via _scratch.
+	SampleWriter _sampleWriter;
+	std::vector<float> _scratch;
+	bool _bDither = true;
+
+	std::atomic_bool _bPlaybackStarted = false;
+	std::wstring _deviceId;
+	double _lastStopLatencyMs = 0.0;
+	std::function<void()> _playbackErrorCallback;
+
+	uint64_t _samplesPlayedSoFar = 0;
+	std::atomic<uint64_t> _playbackPosition = 0;
+
+	MpscRingBuffer<ScheduledChange> _scheduledChanges;
+	SpscRingBuffer<AppliedChange> _appliedChanges;
+
+	// Render callback timing. The previous callback's start and audio duration, and the backend's underrun count at the time; render thread only.
+	std::chrono::steady_clock::time_point _lastCallbackTime{};
+	std::chrono::steady_clock::duration _lastCallbackAudio{};
+	uint64_t _lastUnderruns = 0;
+	std::atomic<uint64_t> _renderCallbacks = 0;
+	std::atomic<uint64_t> _deadlineMisses = 0;
+	SpscRingBuffer<RenderCallbackRecord> _renderRecords;
+	std::atomic<uint64_t> _droppedRenderRecords = 0;
+
+	AudioSamplesBuffer<float> _currentSamplesBuffer;
+
+	CGlitchMonitor _glitchMonitor;
+	bool _bGlitchDetection = false;
+	std::string _glitchLogFilePath;
+	std::function<void(const GlitchEvent&)> _glitchCallback;
+
+	std::vector<LockedMemory> _lockedBuffers;
+	bool _bMemoryLocked = false;
+};
@@ -4,10 +4,11 @@
 
 DISABLE_COMPILER_WARNINGS
 #include <QAudioOutput>
-#include <QBuffer>
 #include <QString>
 RESTORE_COMPILER_WARNINGS
 
+#include "ctonegeneratordevice.h"
+
 #include <memory>
 #include <vector>
 
@@ -21,10 +22,16 @@ struct Channel final {
 class CAudioOutput
 {
 public:
+	// ms == 0 plays until stopped.
 	bool playTone(uint32_t hz, uint32_t ms, const QAudioDeviceInfo& device, QAudioFormat format, int channelIndex, float amplitude = 1.0f);
 	void stopPlayback();
 
+	// Live parameter changes for the tone that's currently playing.
+	void setFrequency(float hz);
+	void setChannelIndex(int channelIndex);
+	void setAmplitude(float amplitude);
+
 private:
-	QBuffer _data;
+	std::unique_ptr<CToneGeneratorDevice> _generator;
 	std::unique_ptr<QAudioOutput> _output;
 };
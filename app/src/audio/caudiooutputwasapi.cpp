@@ -1,356 +1,621 @@
 #include "caudiooutputwasapi.h"
+#include "realtimethread.h"
+#include "wasapiutils.h"
 
-#include "math/math.hpp"
+#include "assert/advanced_assert.h"
 #include "system/win_utils.hpp"
 
 #include <wil/com.h>
 #include <wil/resource.h>
 
 #include <audioclient.h>
+#include <mmreg.h>
 #include <mmdeviceapi.h>
 #include <Windows.h>
 #include <Functiondiscoverykeys_devpkey.h>
+#include <propkey.h>
 
-#include <iostream>
-#include <numbers>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 
 using namespace wil;
 
-static std::vector<ChannelInfo> channelsFromMask(const DWORD mask)
+// Exclusive mode streams have to use a format the hardware supports natively, which is often not the float mix format.
+// The candidates keep the mix format's rate and channel layout, in the order of preference.
+static std::vector<WAVEFORMATEXTENSIBLE> exclusiveFormatCandidates(const WAVEFORMATEXTENSIBLE& mixFormat)
 {
-	static constexpr auto channelInfo = std::to_array<std::pair<const char* /* channel name */, uint32_t>>({
-		{"Left", SPEAKER_FRONT_LEFT },
-		{"Right", SPEAKER_FRONT_RIGHT },
-		{"Center", SPEAKER_FRONT_CENTER },
-		{"LFE", SPEAKER_LOW_FREQUENCY },
-		{"Back Left", SPEAKER_BACK_LEFT },
-		{"Back Right", SPEAKER_BACK_RIGHT },
-		{"Wide Left", SPEAKER_FRONT_LEFT_OF_CENTER },
-		{"Wide Right", SPEAKER_FRONT_RIGHT_OF_CENTER },
-		{"Back Center", SPEAKER_BACK_CENTER },
-		{"Side Left", SPEAKER_SIDE_LEFT },
-		{"Side Right", SPEAKER_SIDE_RIGHT },
-		{"Top Center", SPEAKER_TOP_CENTER },
-		{"Top Front Left", SPEAKER_TOP_FRONT_LEFT },
-		{"Top Front Right", SPEAKER_TOP_FRONT_RIGHT },
-		{"Top Back Left", SPEAKER_TOP_BACK_LEFT },
-		{"Top Back Center", SPEAKER_TOP_BACK_CENTER },
-		{"Top Back Right", SPEAKER_TOP_BACK_RIGHT }
-	});
+	const auto makeFormat = [&mixFormat](const GUID& subFormat, const WORD containerBits, const WORD validBits) {
+		WAVEFORMATEXTENSIBLE format = mixFormat;
+		format.SubFormat = subFormat;
+		format.Format.wBitsPerSample = containerBits;
+		format.Samples.wValidBitsPerSample = validBits;
+		format.Format.nBlockAlign = static_cast<WORD>(format.Format.nChannels * containerBits / 8);
+		format.Format.nAvgBytesPerSec = format.Format.nSamplesPerSec * format.Format.nBlockAlign;
+		return format;
+	};
+
+	return {
+		makeFormat(KSDATAFORMAT_SUBTYPE_IEEE_FLOAT, 32, 32),
+		makeFormat(KSDATAFORMAT_SUBTYPE_PCM, 32, 24),
+		makeFormat(KSDATAFORMAT_SUBTYPE_PCM, 32, 32),
+		makeFormat(KSDATAFORMAT_SUBTYPE_PCM, 24, 24),
+		makeFormat(KSDATAFORMAT_SUBTYPE_PCM, 16, 16)
+	};
+}
+
+// The mix format in shared mode, the first natively supported candidate in exclusive mode.
+static bool negotiateFormat(IAudioClient* pAudioClient, const bool exclusive, WAVEFORMATEXTENSIBLE& streamFormat)
+{
+	unique_cotaskmem_ptr<WAVEFORMATEX> pMixFormat;
+	const HRESULT hr = pAudioClient->GetMixFormat(out_param(pMixFormat));
+	assert_and_return_message_r(SUCCEEDED(hr) && pMixFormat, "IAudioClient.GetMixFormat error: " + ErrorStringFromHRESULT(hr), false);
+	assert_and_return_r(pMixFormat->wFormatTag == WAVE_FORMAT_EXTENSIBLE, false);
 
-	std::vector<ChannelInfo> channels;
-	size_t index = 0;
-	for (const auto& ch : channelInfo)
+	streamFormat = *reinterpret_cast<const WAVEFORMATEXTENSIBLE*>(pMixFormat.get());
+	if (!exclusive)
+		return true;
+
+	for (const auto& candidate : exclusiveFormatCandidates(streamFormat))
 	{
-		if ((mask & ch.second) != 0)
-			channels.emplace_back(ch.first, index++);
+		if (pAudioClient->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE, &candidate.Format, nullptr) == S_OK)
+		{
+			streamFormat = candidate;
+			return true;
+		}
 	}
 
-	return channels;
+	assert_unconditional_r("No exclusive mode format is supported by the device");
+	return false;
 }
 
-void generateTone(BYTE* pData, const UINT32 nBufferFrames, const int nChannelsTotal, const int sampleRate, float hz, const size_t channelIndex, const uint64_t samplesPlayedSoFar)
+static constexpr double referenceTimeUnitsPerSecond = 10'000'000.0;
+
+// An initialized, not yet started audio client and everything the render loop needs to feed it.
+struct RenderStream {
+	com_ptr_nothrow<IAudioClient> audioClient;
+	com_ptr_nothrow<IAudioRenderClient> renderClient;
+	unique_event_nothrow event;
+	UINT32 bufferFrames = 0;
+	uint32_t sampleRate = 0;
+	LatencyInfo latencyInfo;
+};
+
+static std::unique_ptr<RenderStream> createStream(IMMDevice* pDevice, const WAVEFORMATEX* pStreamFormat, const StreamOptions& options)
 {
-	const float sampleRateF = static_cast<float>(sampleRate);
-	// s = A * sin(2 * Pi * f * t) = A * sin(Omega * t)
-	// Omega = 2 * Pi * f
-	// t = sampleIndex / samplesPerSecond
-	const float omega = 2.0f * std::numbers::pi_v<float> * hz / sampleRateF;
-	for (uint64_t i = 0; i < nBufferFrames; ++i)
+	auto stream = std::make_unique<RenderStream>();
+	com_ptr_nothrow<IAudioClient> pAudioClient = activateAudioClient(pDevice);
+	assert_and_return_r(pAudioClient, {});
+
+	REFERENCE_TIME defaultDevicePeriod = 0, minimumDevicePeriod = 0;
+	HRESULT hr = pAudioClient->GetDevicePeriod(&defaultDevicePeriod, &minimumDevicePeriod);
+	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.GetDevicePeriod error: " + ErrorStringFromHRESULT(hr), {});
+
+	const bool exclusive = options.exclusive;
+	REFERENCE_TIME period = options.minimumPeriod ? minimumDevicePeriod : defaultDevicePeriod;
+
+	com_ptr_nothrow<IAudioClient3> pAudioClient3;
+	if (!exclusive && options.minimumPeriod && pAudioClient.try_query_to(&pAudioClient3))
 	{
-		for (size_t c = 0; c < nChannelsTotal; ++c)
-		{
-			float sample = 0;
-			if (c == channelIndex)
-				sample = 1.0f * std::sin(omega * (i + samplesPlayedSoFar));
+		// Windows 10+ low-latency shared mode: run the engine at its minimum period.
+		UINT32 defaultPeriodFrames = 0, fundamentalPeriodFrames = 0, minPeriodFrames = 0, maxPeriodFrames = 0;
+		hr = pAudioClient3->GetSharedModeEnginePeriod(pStreamFormat, &defaultPeriodFrames, &fundamentalPeriodFrames, &minPeriodFrames, &maxPeriodFrames);
+		assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient3.GetSharedModeEnginePeriod error: " + ErrorStringFromHRESULT(hr), {});
+
+		hr = pAudioClient3->InitializeSharedAudioStream(AUDCLNT_STREAMFLAGS_EVENTCALLBACK, minPeriodFrames, pStreamFormat, nullptr);
+		assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient3.InitializeSharedAudioStream error: " + ErrorStringFromHRESULT(hr), {});
 
-			std::memcpy(pData + (i * nChannelsTotal + c) * sizeof(sample), &sample, sizeof(sample));
+		period = static_cast<REFERENCE_TIME>(minPeriodFrames * referenceTimeUnitsPerSecond / pStreamFormat->nSamplesPerSec + 0.5);
+	}
+	else if (exclusive)
+	{
+		// In event-driven exclusive mode the buffer is exactly one period long.
+		hr = pAudioClient->Initialize(
+			AUDCLNT_SHAREMODE_EXCLUSIVE,
+			AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+			period,
+			period,
+			pStreamFormat,
+			nullptr);
+
+		if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED)
+		{
+			// Retry with the period rounded to the buffer size the device has suggested. Requires a fresh IAudioClient.
+			UINT32 alignedBufferFrames = 0;
+			hr = pAudioClient->GetBufferSize(&alignedBufferFrames);
+			assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.GetBufferSize error: " + ErrorStringFromHRESULT(hr), {});
+
+			period = static_cast<REFERENCE_TIME>(alignedBufferFrames * referenceTimeUnitsPerSecond / pStreamFormat->nSamplesPerSec + 0.5);
+			pAudioClient = activateAudioClient(pDevice);
+			assert_and_return_r(pAudioClient, {});
+
+			hr = pAudioClient->Initialize(
+				AUDCLNT_SHAREMODE_EXCLUSIVE,
+				AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+				period,
+				period,
+				pStreamFormat,
+				nullptr);
 		}
+
+		assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.Initialize (exclusive) error: " + ErrorStringFromHRESULT(hr), {});
 	}
+	else
+	{
+		hr = pAudioClient->Initialize(
+			AUDCLNT_SHAREMODE_SHARED,
+			AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+			minimumDevicePeriod,
+			0,
+			pStreamFormat,
+			nullptr);
+		assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.Initialize error: " + ErrorStringFromHRESULT(hr), {});
+	}
+
+	// event
+	stream->event.create();
+	assert_and_return_message_r(stream->event, "CreateEvent error: " + ErrorStringFromLastError(), {});
+
+	hr = pAudioClient->SetEventHandle(stream->event.get());
+	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.SetEventHandle error: " + ErrorStringFromHRESULT(hr), {});
+
+	hr = pAudioClient->GetBufferSize(&stream->bufferFrames);
+	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.GetBufferSize error: " + ErrorStringFromHRESULT(hr), {});
+
+	hr = pAudioClient->GetService(
+		__uuidof(IAudioRenderClient),
+		(void**)&stream->renderClient);
+	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.GetService error: " + ErrorStringFromHRESULT(hr), {});
+
+	REFERENCE_TIME streamLatency = 0;
+	pAudioClient->GetStreamLatency(&streamLatency);
+
+	const double sampleRate = pStreamFormat->nSamplesPerSec;
+	LatencyInfo& info = stream->latencyInfo;
+	info.exclusive = exclusive;
+	info.bufferFrames = stream->bufferFrames;
+	info.periodFrames = exclusive ? stream->bufferFrames : static_cast<uint32_t>(period * sampleRate / referenceTimeUnitsPerSecond + 0.5);
+	info.bufferMs = 1000.0 * stream->bufferFrames / sampleRate;
+	info.periodMs = 1000.0 * info.periodFrames / sampleRate;
+	info.outputLatencyMs = info.bufferMs + streamLatency / 10'000.0;
+
+	stream->sampleRate = pStreamFormat->nSamplesPerSec;
+	stream->audioClient = std::move(pAudioClient);
+	return stream;
 }
 
-void CAudioOutputWasapi::setFrequency(float hz)
+static bool renderFrames(RenderStream& stream, const UINT32 nFrames, const CAudioBackend::RenderCallback& callback)
 {
-	_signal.setFrequency(hz);
+	BYTE* pData = nullptr;
+	HRESULT hr = stream.renderClient->GetBuffer(nFrames, &pData);
+	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.GetBuffer error: " + ErrorStringFromHRESULT(hr), false);
+
+	callback(pData, nFrames);
+
+	hr = stream.renderClient->ReleaseBuffer(nFrames, 0);
+	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.ReleaseBuffer error: " + ErrorStringFromHRESULT(hr), false);
+	return true;
 }
 
-void CAudioOutputWasapi::setChannelIndex(size_t channelIndex)
+// Fills the whole buffer of the next stream, lets the current one play out what it has queued and starts the next one right then.
+// Returns the measured gap in ms, nothing if the next stream has failed (the current one keeps playing then).
+static std::optional<double> handOver(RenderStream& current, RenderStream& next, const CAudioBackend::RenderCallback& callback)
 {
-	_signal.setChannelIndex(channelIndex);
+	using Clock = std::chrono::steady_clock;
+
+	if (!renderFrames(next, next.bufferFrames, callback))
+		return {};
+
+	// A device that has just been unplugged has nothing left to play.
+	UINT32 numPaddingFrames = 0;
+	if (FAILED(current.audioClient->GetCurrentPadding(&numPaddingFrames)))
+		numPaddingFrames = 0;
+
+	const auto currentStreamEnd = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{ static_cast<double>(numPaddingFrames) / current.sampleRate });
+	// Sleeping has a resolution of up to 15.6 ms on Windows; the wait is at most one buffer long, so spin instead.
+	while (Clock::now() < currentStreamEnd)
+		std::this_thread::yield();
+
+	const HRESULT hr = next.audioClient->Start();
+	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.Start error: " + ErrorStringFromHRESULT(hr), {});
+	const auto nextStreamStart = Clock::now();
+
+	current.audioClient->Stop();
+	return std::chrono::duration<double, std::milli>{ nextStreamStart - currentStreamEnd }.count();
+}
+
+// Forwards the endpoint notifications that affect the device list or the mix formats. Called on a system thread.
+class DeviceNotificationClient final : public IMMNotificationClient
+{
+public:
+	explicit DeviceNotificationClient(CAudioBackend::DeviceChangeCallback callback) : _callback{ std::move(callback) } {}
+
+	// IUnknown
+	ULONG STDMETHODCALLTYPE AddRef() override
+	{
+		return ++_refCount;
+	}
+
+	ULONG STDMETHODCALLTYPE Release() override
+	{
+		const ULONG refCount = --_refCount;
+		if (refCount == 0)
+			delete this;
+
+		return refCount;
+	}
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvInterface) override
+	{
+		if (riid == __uuidof(IUnknown) || riid == __uuidof(IMMNotificationClient))
+		{
+			*ppvInterface = static_cast<IMMNotificationClient*>(this);
+			AddRef();
+			return S_OK;
+		}
+
+		*ppvInterface = nullptr;
+		return E_NOINTERFACE;
+	}
+
+	// IMMNotificationClient
+	HRESULT STDMETHODCALLTYPE OnDeviceStateChanged(LPCWSTR /*deviceId*/, DWORD /*newState*/) override
+	{
+		_callback();
+		return S_OK;
+	}
+
+	HRESULT STDMETHODCALLTYPE OnDeviceAdded(LPCWSTR /*deviceId*/) override
+	{
+		_callback();
+		return S_OK;
+	}
+
+	HRESULT STDMETHODCALLTYPE OnDeviceRemoved(LPCWSTR /*deviceId*/) override
+	{
+		_callback();
+		return S_OK;
+	}
+
+	HRESULT STDMETHODCALLTYPE OnDefaultDeviceChanged(EDataFlow /*flow*/, ERole /*role*/, LPCWSTR /*defaultDeviceId*/) override
+	{
+		return S_OK;
+	}
+
+	HRESULT STDMETHODCALLTYPE OnPropertyValueChanged(LPCWSTR /*deviceId*/, const PROPERTYKEY key) override
+	{
+		// Plenty of other properties change all the time (e. g. the volume), only these two affect what's cached.
+		if (IsEqualPropertyKey(key, PKEY_Device_FriendlyName) || IsEqualPropertyKey(key, PKEY_AudioEngine_DeviceFormat))
+			_callback();
+
+		return S_OK;
+	}
+
+private:
+	std::atomic<ULONG> _refCount = 1;
+	const CAudioBackend::DeviceChangeCallback _callback;
+};
+
+struct CAudioOutputWasapi::DeviceNotifications {
+	com_ptr_nothrow<IMMDeviceEnumerator> enumerator;
+	com_ptr_nothrow<DeviceNotificationClient> client;
+
+	~DeviceNotifications()
+	{
+		if (enumerator && client)
+			enumerator->UnregisterEndpointNotificationCallback(client.get());
+	}
+};
+
+// If the device doesn't signal for this long, it is checked for having been invalidated (e. g. unplugged).
+static constexpr DWORD deviceEventTimeoutMs = 500;
+
+struct CAudioOutputWasapi::ThreadControl {
+	// Manual-reset, so that it also interrupts a device switch.
+	unique_event_nothrow stopEvent;
+	// Auto-reset; wakes the render thread up to pick the new stream.
+	unique_event_nothrow switchEvent;
+
+	std::mutex mutex;
+	std::unique_ptr<RenderStream> stream;
+	std::promise<std::optional<double>> result;
+	// False once the render thread has exited (or failed to start), so that nobody waits for it to pick the stream up.
+	bool bRenderThreadRunning = false;
+};
+
+CAudioOutputWasapi::CAudioOutputWasapi() :
+	_threadControl{ std::make_unique<ThreadControl>() }
+{
+	_threadControl->stopEvent.create(EventOptions::ManualReset);
+	_threadControl->switchEvent.create();
+	assert_message_r(_threadControl->stopEvent && _threadControl->switchEvent, "CreateEvent error: " + ErrorStringFromLastError());
 }
 
 CAudioOutputWasapi::~CAudioOutputWasapi()
 {
-	stopPlayback();
+	stop();
+}
+
+bool CAudioOutputWasapi::open(const std::wstring& deviceId, const StreamOptions& options)
+{
+	assert_and_return_r(!_bPlaybackStarted, false);
+
+	const auto pAudioClient = activateAudioClient(findDevice(deviceId).get());
+	assert_and_return_r(pAudioClient, false);
+
+	WAVEFORMATEXTENSIBLE streamFormat;
+	if (!negotiateFormat(pAudioClient.get(), options.exclusive, streamFormat))
+		return false;
+
+	_waveFormat.resize(sizeof(streamFormat));
+	std::memcpy(_waveFormat.data(), &streamFormat, sizeof(streamFormat));
+	_format = toAudioFormat(streamFormat.Format);
+	assert_and_return_r(!_format.channels.empty(), false);
+
+	_options = options;
+	_deviceId = deviceId;
+	return true;
 }
 
-bool CAudioOutputWasapi::playTone(std::wstring deviceId)
+AudioFormat CAudioOutputWasapi::format() const noexcept
 {
+	return _format;
+}
+
+bool CAudioOutputWasapi::start(RenderCallback callback)
+{
+	assert_and_return_r(callback, false);
+	assert_and_return_r(!_deviceId.empty(), false);
 	if (_bPlaybackStarted)
 		return true;
 
+	// The previous render thread may have exited on an error.
+	if (_thread.joinable())
+		_thread.join();
+
 	_bPlaybackStarted = true;
-	_bTerminateThread = false;
+	_underruns = 0;
+
+	std::promise<bool> started;
+	auto startupResult = started.get_future();
+	_thread = std::thread(&CAudioOutputWasapi::playbackThread, this, _deviceId, std::move(callback), std::move(started));
+
+	if (!startupResult.get())
+	{
+		_thread.join();
+		_bPlaybackStarted = false;
+		return false;
+	}
 
-	_thread = std::thread(&CAudioOutputWasapi::playbackThread, this, std::move(deviceId));
 	return true;
 }
 
-void CAudioOutputWasapi::stopPlayback()
+void CAudioOutputWasapi::stop()
 {
-	if (!_bPlaybackStarted)
+	if (!_thread.joinable())
 		return;
 
-	_bTerminateThread = true;
+	// The render thread waits on this event alongside the device one, so it exits right away even if the device has stopped signaling.
+	_threadControl->stopEvent.SetEvent();
 	_thread.join();
+	_threadControl->stopEvent.ResetEvent();
 	_bPlaybackStarted = false;
 }
 
-AudioFormat CAudioOutputWasapi::mixFormat(const std::wstring& deviceId) const noexcept
+std::optional<double> CAudioOutputWasapi::switchDevice(const std::wstring& deviceId, const StreamOptions& options)
 {
-	com_ptr_nothrow<IMMDeviceEnumerator> pDeviceEnumerator;
-	HRESULT hr = ::CoCreateInstance(
-		__uuidof(MMDeviceEnumerator),
-		nullptr,
-		CLSCTX_ALL,
-		__uuidof(IMMDeviceEnumerator),
-		(void**)&pDeviceEnumerator);
-	assert_and_return_message_r(SUCCEEDED(hr), "CoCreateInstance failed: " + ErrorStringFromHRESULT(hr), {});
-
-	com_ptr_nothrow<IMMDeviceCollection> pDevices;
-	hr = pDeviceEnumerator->EnumAudioEndpoints(
-		eRender,
-		DEVICE_STATE_ACTIVE,
-		&pDevices);
-	assert_and_return_message_r(SUCCEEDED(hr), "IMMDeviceEnumerator.EnumAudioEndpoints error: " + ErrorStringFromHRESULT(hr), {});
-
-	UINT n = 0;
-	pDevices->GetCount(&n);
-	com_ptr_nothrow<IMMDevice> pDevice;
-	for (UINT i = 0; i < n; ++i)
-	{
-		pDevices->Item(i, &pDevice);
-		if (!pDevice)
-			continue;
+	assert_and_return_r(_bPlaybackStarted, {});
 
-		unique_cotaskmem_string id;
-		pDevice->GetId(&id);
-		if (deviceId == id.get())
-			break;
-		else
-			pDevice.reset();
-	}	
-
-	com_ptr_nothrow<IAudioClient> pAudioClient;
-	hr = pDevice->Activate(
-		__uuidof(IAudioClient),
-		CLSCTX_ALL,
-		nullptr,
-		(void**)&pAudioClient);
-	assert_and_return_message_r(SUCCEEDED(hr), "IMMDevice.Activate error: " + ErrorStringFromHRESULT(hr), {});
+	// The audio client is free-threaded, so the new stream is set up here and the render thread only has to prime and start it.
+	const auto pDevice = findDevice(deviceId);
+	const auto pAudioClient = activateAudioClient(pDevice.get());
+	assert_and_return_r(pAudioClient, {});
 
-	unique_cotaskmem_ptr<WAVEFORMATEX> pMixFormat;
-	hr = pAudioClient->GetMixFormat(out_param(pMixFormat));
-	assert_and_return_message_r(SUCCEEDED(hr) && pMixFormat, "IAudioClient.GetMixFormat error: " + ErrorStringFromHRESULT(hr), {});
+	WAVEFORMATEXTENSIBLE streamFormat;
+	if (!negotiateFormat(pAudioClient.get(), options.exclusive, streamFormat))
+		return {};
 
-	AudioFormat fmt;
+	// The render callback keeps producing the current format.
+	if (!sameSampleLayout(toAudioFormat(streamFormat.Format), _format))
+		return {};
 
-	assert_and_return_r(pMixFormat->wFormatTag == WAVE_FORMAT_EXTENSIBLE, {});
-
-	WAVEFORMATEXTENSIBLE* pFormatEx = reinterpret_cast<WAVEFORMATEXTENSIBLE*>(pMixFormat.get());
-	fmt.channels = channelsFromMask(pFormatEx->dwChannelMask);
-	assert_r(fmt.channels.size() == pMixFormat->nChannels);
-	if (pFormatEx->SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT)
-		fmt.sampleFormat = AudioFormat::Float;
-	else if (pFormatEx->SubFormat == KSDATAFORMAT_SUBTYPE_PCM)
-		fmt.sampleFormat = AudioFormat::PCM;
-	else
-		assert_unconditional_r("Unknown subformat!");
+	auto stream = createStream(pDevice.get(), &streamFormat.Format, options);
+	if (!stream)
+		return {};
 
-	fmt.sampleRate = pMixFormat->nSamplesPerSec;
-	fmt.bitsPerSample = pMixFormat->wBitsPerSample;
-
-	return fmt;
-}
-
-std::vector<CAudioOutputWasapi::DeviceInfo> CAudioOutputWasapi::devices() const
-{
-	com_ptr_nothrow<IMMDeviceEnumerator> pDeviceEnumerator;
-	HRESULT hr = ::CoCreateInstance(
-		__uuidof(MMDeviceEnumerator),
-		nullptr,
-		CLSCTX_ALL,
-		__uuidof(IMMDeviceEnumerator),
-		(void**)&pDeviceEnumerator);
-	assert_and_return_message_r(SUCCEEDED(hr), "CoCreateInstance failed: " + ErrorStringFromHRESULT(hr), {});
-
-	com_ptr_nothrow<IMMDeviceCollection> pDevices;
-	hr = pDeviceEnumerator->EnumAudioEndpoints(
-		eRender,
-		DEVICE_STATE_ACTIVE,
-		&pDevices);
-	assert_and_return_message_r(SUCCEEDED(hr), "IMMDeviceEnumerator.EnumAudioEndpoints error: " + ErrorStringFromHRESULT(hr), {});
-
-	UINT n = 0;
-	pDevices->GetCount(&n);
-	std::vector<DeviceInfo> devices;
-	devices.reserve(n);
-	for (UINT i = 0; i < n; ++i)
+	std::future<std::optional<double>> result;
 	{
-		com_ptr_nothrow<IMMDevice> pDevice;
-		pDevices->Item(i, &pDevice);
-		if (!pDevice)
-			continue;
+		std::lock_guard lock{ _threadControl->mutex };
+		if (!_threadControl->bRenderThreadRunning)
+			return {};
 
-		unique_cotaskmem_string deviceID;
-		pDevice->GetId(&deviceID);
-
-		com_ptr_nothrow<IPropertyStore> props;
-		pDevice->OpenPropertyStore(STGM_READ, &props);
-		if (!props)
-			continue;
+		_threadControl->stream = std::move(stream);
+		_threadControl->result = {};
+		result = _threadControl->result.get_future();
+	}
 
-		wil::unique_prop_variant pv;
-		props->GetValue(PKEY_Device_FriendlyName, &pv);
-		devices.emplace_back(deviceID.get(), pv.pwszVal);
+	_threadControl->switchEvent.SetEvent();
+	const auto gapMs = result.get();
+	if (gapMs)
+	{
+		std::memcpy(_waveFormat.data(), &streamFormat, sizeof(streamFormat));
+		_format = toAudioFormat(streamFormat.Format);
+		_options = options;
+		_deviceId = deviceId;
 	}
 
-	return devices;
+	return gapMs;
 }
 
-vector2D<float> CAudioOutputWasapi::currentSamplesBuffer() const
+LatencyInfo CAudioOutputWasapi::latencyInfo() const noexcept
 {
-	return _currentSamplesBuffer.samples();
+	std::lock_guard lock{ _latencyInfoMutex };
+	LatencyInfo info = _latencyInfo;
+	info.realtimePriority = _bRealtimeThread;
+	return info;
 }
 
-void CAudioOutputWasapi::playbackThread(std::wstring deviceId)
+uint64_t CAudioOutputWasapi::underruns() const noexcept
 {
-	_samplesPlayedSoFar = 0;
+	return _underruns.load(std::memory_order_relaxed);
+}
 
-	CO_INIT_HELPER(COINIT_MULTITHREADED);
+void CAudioOutputWasapi::setStreamErrorCallback(StreamErrorCallback callback)
+{
+	assert_and_return_r(!_thread.joinable(), );
+	_streamErrorCallback = std::move(callback);
+}
 
-	com_ptr_nothrow<IMMDeviceEnumerator> pDeviceEnumerator;
-	HRESULT hr = ::CoCreateInstance(
-		__uuidof(MMDeviceEnumerator),
-		nullptr,
-		CLSCTX_ALL,
-		__uuidof(IMMDeviceEnumerator),
-		(void**)&pDeviceEnumerator);
-	assert_and_return_message_r(SUCCEEDED(hr), "CoCreateInstance failed: " + ErrorStringFromHRESULT(hr), );
-
-	com_ptr_nothrow<IMMDeviceCollection> pDevices;
-	hr = pDeviceEnumerator->EnumAudioEndpoints(
-		eRender,
-		DEVICE_STATE_ACTIVE,
-		&pDevices);
-	assert_and_return_message_r(SUCCEEDED(hr), "IMMDeviceEnumerator.EnumAudioEndpoints error: " + ErrorStringFromHRESULT(hr), );
-
-	UINT n = 0;
-	pDevices->GetCount(&n);
-	com_ptr_nothrow<IMMDevice> pDevice;
-	for (UINT i = 0; i < n; ++i)
-	{
-		pDevices->Item(i, &pDevice);
-		if (!pDevice)
-			continue;
+void CAudioOutputWasapi::setDeviceChangeCallback(DeviceChangeCallback callback)
+{
+	_deviceNotifications.reset();
+	if (!callback)
+		return;
 
-		unique_cotaskmem_string id;
-		pDevice->GetId(&id);
-		if (deviceId == id.get())
-			break;
-		else
-			pDevice.reset();
-	}
+	auto notifications = std::make_unique<DeviceNotifications>();
+	notifications->enumerator = createDeviceEnumerator();
+	assert_and_return_r(notifications->enumerator, );
 
-	com_ptr_nothrow<IAudioClient> pAudioClient;
-	hr = pDevice->Activate(
-		__uuidof(IAudioClient),
-		CLSCTX_ALL,
-		nullptr,
-		(void**)&pAudioClient);
-	assert_and_return_message_r(SUCCEEDED(hr), "IMMDevice.Activate error: " + ErrorStringFromHRESULT(hr), );
+	notifications->client.attach(new DeviceNotificationClient(std::move(callback)));
+	const HRESULT hr = notifications->enumerator->RegisterEndpointNotificationCallback(notifications->client.get());
+	assert_and_return_message_r(SUCCEEDED(hr), "IMMDeviceEnumerator.RegisterEndpointNotificationCallback error: " + ErrorStringFromHRESULT(hr), );
 
-	REFERENCE_TIME MinimumDevicePeriod = 0;
-	hr = pAudioClient->GetDevicePeriod(nullptr, &MinimumDevicePeriod);
-	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.GetDevicePeriod error: " + ErrorStringFromHRESULT(hr), );
+	_deviceNotifications = std::move(notifications);
+}
+
+AudioFormat CAudioOutputWasapi::mixFormat(const std::wstring& deviceId) const noexcept
+{
+	const auto pAudioClient = activateAudioClient(findDevice(deviceId).get());
+	assert_and_return_r(pAudioClient, {});
 
 	unique_cotaskmem_ptr<WAVEFORMATEX> pMixFormat;
-	hr = pAudioClient->GetMixFormat(out_param(pMixFormat));
-	assert_and_return_message_r(SUCCEEDED(hr) && pMixFormat, "IAudioClient.GetMixFormat error: " + ErrorStringFromHRESULT(hr), );
-
-	WAVEFORMATEXTENSIBLE* pFormatEx = reinterpret_cast<WAVEFORMATEXTENSIBLE*>(pMixFormat.get());
-	assert_r(pMixFormat->wFormatTag == WAVE_FORMAT_EXTENSIBLE);
-	assert_r(pFormatEx->SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT);
-
-	hr = pAudioClient->Initialize(
-		AUDCLNT_SHAREMODE_SHARED,
-		AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
-		MinimumDevicePeriod,
-		0,
-		pMixFormat.get(),
-		nullptr);
-	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.Initialize error: " + ErrorStringFromHRESULT(hr), );
+	const HRESULT hr = pAudioClient->GetMixFormat(out_param(pMixFormat));
+	assert_and_return_message_r(SUCCEEDED(hr) && pMixFormat, "IAudioClient.GetMixFormat error: " + ErrorStringFromHRESULT(hr), {});
 
-	// event
-	unique_event_nothrow hEvent;
-	hEvent.create();
-	assert_and_return_message_r(hEvent, "CreateEvent error: " + ErrorStringFromLastError(), );
+	return toAudioFormat(*pMixFormat);
+}
 
-	hr = pAudioClient->SetEventHandle(hEvent.get());
-	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.SetEventHandle error: " + ErrorStringFromHRESULT(hr), );
+std::vector<AudioDeviceInfo> CAudioOutputWasapi::devices() const
+{
+	return audioEndpoints(eRender);
+}
 
-	UINT32 numBufferFrames = 0;
-	hr = pAudioClient->GetBufferSize(&numBufferFrames);
-	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.GetBufferSize error: " + ErrorStringFromHRESULT(hr), );
-	std::cout << "buffer frame size=" << numBufferFrames << "[frames]" << std::endl;
+void CAudioOutputWasapi::playbackThread(std::wstring deviceId, RenderCallback callback, std::promise<bool> started)
+{
+	// Any early exit below reports the failure to start() which is waiting for the outcome, or, once running, to the owner.
+	bool bStartupReported = false;
+	bool bStopRequested = false;
+	auto reportFailure = wil::scope_exit([&] {
+		if (!bStartupReported)
+			started.set_value(false);
+		else if (!bStopRequested)
+		{
+			_bPlaybackStarted = false;
+			if (_streamErrorCallback)
+				_streamErrorCallback();
+		}
+	});
 
-	com_ptr_nothrow<IAudioRenderClient> pAudioRenderClient;
-	hr = pAudioClient->GetService(
-		__uuidof(IAudioRenderClient),
-		(void**)&pAudioRenderClient);
-	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.GetService error: " + ErrorStringFromHRESULT(hr), );
+	CO_INIT_HELPER(COINIT_MULTITHREADED);
 
-	BYTE* pData = nullptr;
-	hr = pAudioRenderClient->GetBuffer(numBufferFrames, &pData);
-	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.GetBuffer error: " + ErrorStringFromHRESULT(hr), );
+	const RealtimeThreadScope realtime{ _options };
+	_bRealtimeThread = realtime.isRealtime();
 
-	{
-		const auto [f, chIndex] = _signal.params();
-		generateTone(pData, numBufferFrames, pMixFormat->nChannels, pMixFormat->nSamplesPerSec, f, chIndex, 0);
-	}
+	// Nor should a switchDevice() call be left waiting. Runs before the COM uninitialization, which the pending stream needs.
+	auto rejectPendingSwitch = wil::scope_exit([this] {
+		std::lock_guard lock{ _threadControl->mutex };
+		_threadControl->bRenderThreadRunning = false;
+		if (_threadControl->stream)
+		{
+			_threadControl->stream.reset();
+			_threadControl->result.set_value({});
+		}
+	});
 
-	const auto bytesPerSample = pMixFormat->wBitsPerSample / 8;
-	_currentSamplesBuffer.setData(pData, numBufferFrames, pMixFormat->nChannels);
+	auto stream = createStream(findDevice(deviceId).get(), reinterpret_cast<const WAVEFORMATEX*>(_waveFormat.data()), _options);
+	assert_and_return_r(stream, );
 
-	hr = pAudioRenderClient->ReleaseBuffer(numBufferFrames, 0);
-	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.ReleaseBuffer error: " + ErrorStringFromHRESULT(hr), );
-	_samplesPlayedSoFar += numBufferFrames;
+	if (!renderFrames(*stream, stream->bufferFrames, callback))
+		return;
 
-	hr = pAudioClient->Start();
+	HRESULT hr = stream->audioClient->Start();
 	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.Start error: " + ErrorStringFromHRESULT(hr), );
 
-	UINT32 numPaddingFrames = 0;
-	while (!_bTerminateThread)
 	{
-		::WaitForSingleObject(hEvent.get(), INFINITE);
+		std::lock_guard lock{ _latencyInfoMutex };
+		_latencyInfo = stream->latencyInfo;
+	}
+
+	{
+		std::lock_guard lock{ _threadControl->mutex };
+		_threadControl->bRenderThreadRunning = true;
+	}
 
-		hr = pAudioClient->GetCurrentPadding(&numPaddingFrames);
-		assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.GetCurrentPadding error: " + ErrorStringFromHRESULT(hr), );
+	bStartupReported = true;
+	started.set_value(true);
 
-		UINT32 numAvailableFrames = numBufferFrames - numPaddingFrames;
-		if (numAvailableFrames == 0)
+	UINT32 numPaddingFrames = 0;
+	for (;;)
+	{
+		const std::array<HANDLE, 3> events{ stream->event.get(), _threadControl->stopEvent.get(), _threadControl->switchEvent.get() };
+		const DWORD waitResult = ::WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE, deviceEventTimeoutMs);
+		if (waitResult == WAIT_OBJECT_0 + 1)
+		{
+			bStopRequested = true;
+			break;
+		}
+		else if (waitResult == WAIT_TIMEOUT)
+		{
+			// Fails with AUDCLNT_E_DEVICE_INVALIDATED if the device is gone.
+			hr = stream->audioClient->GetCurrentPadding(&numPaddingFrames);
+			assert_and_return_message_r(SUCCEEDED(hr), "The device has stopped responding: " + ErrorStringFromHRESULT(hr), );
+			continue;
+		}
+		else if (waitResult == WAIT_OBJECT_0 + 2)
+		{
+			std::unique_ptr<RenderStream> nextStream;
+			std::promise<std::optional<double>> result;
+			{
+				std::lock_guard lock{ _threadControl->mutex };
+				nextStream = std::move(_threadControl->stream);
+				result = std::move(_threadControl->result);
+			}
+
+			if (!nextStream)
+				continue;
+
+			const auto gapMs = handOver(*stream, *nextStream, callback);
+			if (gapMs)
+			{
+				stream = std::move(nextStream);
+
+				std::lock_guard lock{ _latencyInfoMutex };
+				_latencyInfo = stream->latencyInfo;
+			}
+
+			result.set_value(gapMs);
 			continue;
+		}
 
-		hr = pAudioRenderClient->GetBuffer(numAvailableFrames, &pData);
-		assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.GetBuffer error: " + ErrorStringFromHRESULT(hr), );
+		// The exclusive mode buffer is consumed a whole period at a time, so all of it is free on every event.
+		UINT32 numAvailableFrames = stream->bufferFrames;
+		if (!stream->latencyInfo.exclusive)
+		{
+			hr = stream->audioClient->GetCurrentPadding(&numPaddingFrames);
+			assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.GetCurrentPadding error: " + ErrorStringFromHRESULT(hr), );
 
-		const auto [f, chIndex] = _signal.params();
-		generateTone(pData, numAvailableFrames, pMixFormat->nChannels, pMixFormat->nSamplesPerSec, f, chIndex, _samplesPlayedSoFar);
-		_currentSamplesBuffer.setData(pData, numAvailableFrames, pMixFormat->nChannels);
+			// The buffer has run dry: the audio engine has been playing silence.
+			if (numPaddingFrames == 0)
+				_underruns.fetch_add(1, std::memory_order_relaxed);
+
+			numAvailableFrames = stream->bufferFrames - numPaddingFrames;
+			if (numAvailableFrames == 0)
+				continue;
+		}
 
-		hr = pAudioRenderClient->ReleaseBuffer(numAvailableFrames, 0);
-		assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.ReleaseBuffer error: " + ErrorStringFromHRESULT(hr), );
-		_samplesPlayedSoFar += numAvailableFrames;
+		if (!renderFrames(*stream, numAvailableFrames, callback))
+			return;
 	}
 
 	//// Let the current buffer play to the end
@@ -365,6 +630,6 @@ void CAudioOutputWasapi::playbackThread(std::wstring deviceId)
 
 	//} while (NumPaddingFrames > 0);
 
-	hr = pAudioClient->Stop();
+	hr = stream->audioClient->Stop();
 	assert_and_return_message_r(SUCCEEDED(hr), "IAudioClient.Stop error: " + ErrorStringFromHRESULT(hr), );
 }
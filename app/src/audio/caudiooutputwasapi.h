@@ -1,80 +1,41 @@
 #pragma once
-#include "assert/advanced_assert.h"
-#include "container/vector2d.hpp"
-#include "utility/memory_cast.hpp"
+#include "caudiobackend.h"
 
-#include <array>
 #include <atomic>
+#include <future>
+#include <memory>
 #include <mutex>
 #include <stdint.h>
 #include <string>
 #include <thread>
-#include <utility>
+#include <vector>
 
-struct ChannelInfo {
-	std::string name;
-	size_t index;
-};
-
-struct AudioFormat {
-	std::vector<ChannelInfo> channels;
-
-	uint32_t sampleRate = 0;
-	enum {PCM, Float} sampleFormat;
-	uint16_t bitsPerSample = 0;
-};
-
-template <typename T>
-struct AudioSamplesBuffer {
-	void setData(const void* dataPtr, const size_t nFrames, const size_t nChannels)
-	{
-		std::lock_guard lock{ _mtx };
-
-		const auto frameSize = nChannels * sizeof(T);
-		_buffer.resize(nChannels, nFrames);
-
-		for (size_t i = 0; i < nFrames; ++i)
-		{
-			for (size_t c = 0; c < nChannels; ++c)
-			{
-				_buffer[c][i] = memory_cast<float>(reinterpret_cast<const char*>(dataPtr) + i * frameSize + c * sizeof(T));
-			}
-		}
-	}
-
-	[[nodiscard]] vector2D<T> samples() const {
-		std::lock_guard lock{ _mtx };
-		return _buffer;
-	}
-
-private:
-	mutable std::mutex _mtx;
-	vector2D<T> _buffer;
-};
-
-class CAudioOutputWasapi final
+class CAudioOutputWasapi final : public CAudioBackend
 {
 public:
-	~CAudioOutputWasapi();
+	CAudioOutputWasapi();
+	~CAudioOutputWasapi() override;
 
-	void setFrequency(float hz);
-	void setChannelIndex(size_t channelIndex);
+	[[nodiscard]] std::vector<AudioDeviceInfo> devices() const override;
+	[[nodiscard]] AudioFormat mixFormat(const std::wstring& deviceId) const noexcept override;
 
-	bool playTone(std::wstring deviceId);
-	void stopPlayback();
+	bool open(const std::wstring& deviceId, const StreamOptions& options) override;
+	[[nodiscard]] AudioFormat format() const noexcept override;
 
-	[[nodiscard]] AudioFormat mixFormat(const std::wstring& deviceId) const noexcept;
+	bool start(RenderCallback callback) override;
+	void stop() override;
 
-	struct DeviceInfo {
-		const std::wstring id;
-		const std::wstring friendlyName;
-	};
-	[[nodiscard]] std::vector<DeviceInfo> devices() const;
+	[[nodiscard]] std::optional<double> switchDevice(const std::wstring& deviceId, const StreamOptions& options) override;
+
+	[[nodiscard]] LatencyInfo latencyInfo() const noexcept override;
+	// Shared mode only: the events on which the engine had already played the whole buffer out.
+	[[nodiscard]] uint64_t underruns() const noexcept override;
 
-	[[nodiscard]] vector2D<float> currentSamplesBuffer() const;
+	void setDeviceChangeCallback(DeviceChangeCallback callback) override;
+	void setStreamErrorCallback(StreamErrorCallback callback) override;
 
 private:
-	void playbackThread(std::wstring deviceId);
+	void playbackThread(std::wstring deviceId, RenderCallback callback, std::promise<bool> started);
 
 private:
 	enum ChannelMask : uint32_t {
@@ -98,36 +59,30 @@ private:
 		SPEAKER_TOP_BACK_RIGHT = 0x20000
 	};
 
-	struct Signal {
-		inline std::pair<float, size_t> params() const noexcept {
-			std::lock_guard lock{ _signalParamsMutex };
-			return { _hz, _channelIndex };
-		}
+	std::wstring _deviceId;
+	AudioFormat _format;
+	StreamOptions _options;
+	// The WAVEFORMATEXTENSIBLE negotiated by open().
+	std::vector<uint8_t> _waveFormat;
 
-		inline void setFrequency(float hz) noexcept {
-			std::lock_guard lock{ _signalParamsMutex };
-			_hz = hz;
-		}
+	LatencyInfo _latencyInfo;
+	mutable std::mutex _latencyInfoMutex;
 
-		inline void setChannelIndex(size_t channelIndex) noexcept {
-			std::lock_guard lock{ _signalParamsMutex };
-			_channelIndex = channelIndex;
-		}
+	// The registered IMMNotificationClient, if any.
+	struct DeviceNotifications;
+	std::unique_ptr<DeviceNotifications> _deviceNotifications;
 
-	private:
-		mutable std::mutex _signalParamsMutex;
+	// Stops the render thread and hands new streams over to it, see stop() and switchDevice().
+	struct ThreadControl;
+	const std::unique_ptr<ThreadControl> _threadControl;
 
-		size_t _channelIndex = 0;
-		float _hz = 1000.0f;
-	};
+	StreamErrorCallback _streamErrorCallback;
 
 	std::thread _thread;
-	Signal _signal;
 
+	// Cleared by the render thread if it exits on an error.
 	std::atomic_bool _bPlaybackStarted = false;
-	std::atomic_bool _bTerminateThread = false;
-
-	uint64_t _samplesPlayedSoFar = 0;
-
-	AudioSamplesBuffer<float> _currentSamplesBuffer;
+	// Whether the render thread has been registered with MMCSS.
+	std::atomic_bool _bRealtimeThread = false;
+	std::atomic<uint64_t> _underruns = 0;
 };
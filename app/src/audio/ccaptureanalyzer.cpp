@@ -0,0 +1,99 @@
+#include "ccaptureanalyzer.h"
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+
+// Spectra averaged: about 0.4 s worth.
+static constexpr size_t spectrumAverages = 4;
+static constexpr double maxUpdateInterval = 0.1; // seconds
+
+CCaptureAnalyzer::CCaptureAnalyzer(std::unique_ptr<CAudioCapture> capture) :
+	_capture{ std::move(capture) }
+{
+}
+
+CCaptureAnalyzer::~CCaptureAnalyzer()
+{
+	stop();
+}
+
+std::vector<AudioDeviceInfo> CCaptureAnalyzer::devices() const
+{
+	return _capture ? _capture->devices() : std::vector<AudioDeviceInfo>{};
+}
+
+bool CCaptureAnalyzer::start(const std::wstring& deviceId)
+{
+	assert_and_return_message_r(_capture, "Audio capture is not supported on this platform", false);
+	stop();
+
+	_bAnalyzerReady = false;
+	_measurement.write({});
+	_bRunning = _capture->start(deviceId, [this](const float* frames, uint32_t nFrames) {
+		analyse(frames, nFrames);
+	});
+
+	return _bRunning;
+}
+
+void CCaptureAnalyzer::stop()
+{
+	if (!_bRunning)
+		return;
+
+	_capture->stop();
+	_bRunning = false;
+}
+
+bool CCaptureAnalyzer::isRunning() const noexcept
+{
+	return _bRunning;
+}
+
+void CCaptureAnalyzer::setChannelIndex(const size_t channelIndex) noexcept
+{
+	_channelIndex = channelIndex;
+}
+
+void CCaptureAnalyzer::setFundamental(const double hz) noexcept
+{
+	_fundamentalHz = hz;
+}
+
+SpectrumMeasurement CCaptureAnalyzer::measurement() noexcept
+{
+	return _measurement.read();
+}
+
+AudioFormat CCaptureAnalyzer::format() const noexcept
+{
+	return _capture && _bRunning ? _capture->format() : AudioFormat{};
+}
+
+uint64_t CCaptureAnalyzer::overruns() const noexcept
+{
+	return _capture ? _capture->overruns() : 0;
+}
+
+void CCaptureAnalyzer::analyse(const float* frames, const uint32_t nFrames) noexcept
+{
+	const size_t channel = std::min(_channelIndex.load(std::memory_order_relaxed), _nChannels > 0 ? _nChannels - 1 : 0);
+	if (!_bAnalyzerReady || channel != _analyzedChannel)
+	{
+		// Only allocates the first time: reset() to the same size reuses the buffers.
+		const AudioFormat format = _capture->format();
+		_nChannels = format.channels.size();
+		assert_and_return_r(_nChannels > 0 && format.sampleRate > 0, );
+
+		size_t fftSize = 4;
+		while (static_cast<double>(fftSize) <= maxUpdateInterval * format.sampleRate)
+			fftSize *= 2;
+
+		_analyzedChannel = std::min(_channelIndex.load(std::memory_order_relaxed), _nChannels - 1);
+		_analyzer.reset(fftSize, format.sampleRate, spectrumAverages);
+		_bAnalyzerReady = true;
+	}
+
+	if (_analyzer.process(frames, nFrames, _nChannels, _analyzedChannel))
+		_measurement.write(_analyzer.measure(_fundamentalHz.load(std::memory_order_relaxed)));
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "caudiocapture.h"
+#include "spectrumanalyzer.h"
+#include "triplebuffer.hpp"
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Measures the level and THD+N of one channel of a capture stream (a microphone, a line input or the loopback of the output) live.
+// The analysis runs on the capture thread: SpectrumAnalyzer is set up on the first packet and never allocates after that.
+// The FFT is the longest one whose half-frame hop is at most 100 ms, so the measurement is updated at least 10 times a second
+// at any sample rate, at a resolution of 5 - 6 Hz.
+class CCaptureAnalyzer final
+{
+public:
+	// capture may be null, on platforms without a capture backend.
+	explicit CCaptureAnalyzer(std::unique_ptr<CAudioCapture> capture);
+	~CCaptureAnalyzer();
+
+	[[nodiscard]] std::vector<AudioDeviceInfo> devices() const;
+
+	bool start(const std::wstring& deviceId);
+	void stop();
+	[[nodiscard]] bool isRunning() const noexcept;
+
+	// Both take effect from the next measurement. The channel index is clamped to the channels the device has;
+	// fundamentalHz is as for SpectrumAnalyzer::measure().
+	void setChannelIndex(size_t channelIndex) noexcept;
+	void setFundamental(double hz) noexcept;
+
+	// The measurement after the latest FFT frame. Not to be called from more than one thread.
+	[[nodiscard]] SpectrumMeasurement measurement() noexcept;
+	// The format of the running stream.
+	[[nodiscard]] AudioFormat format() const noexcept;
+	// See CAudioCapture::overruns().
+	[[nodiscard]] uint64_t overruns() const noexcept;
+
+private:
+	// Capture thread.
+	void analyse(const float* frames, uint32_t nFrames) noexcept;
+
+private:
+	const std::unique_ptr<CAudioCapture> _capture;
+	bool _bRunning = false;
+
+	std::atomic<size_t> _channelIndex = 0;
+	std::atomic<double> _fundamentalHz = 0.0;
+
+	// Capture thread state
+	SpectrumAnalyzer _analyzer;
+	bool _bAnalyzerReady = false;
+	size_t _nChannels = 0;
+	size_t _analyzedChannel = 0;
+
+	TripleBuffer<SpectrumMeasurement> _measurement;
+};
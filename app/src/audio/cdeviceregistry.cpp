@@ -0,0 +1,92 @@
+#include "cdeviceregistry.h"
+
+CDeviceRegistry::CDeviceRegistry(CAudioBackend& backend) :
+	_backend{ backend }
+{
+	_backend.setDeviceChangeCallback([this] {
+		invalidate();
+
+		std::function<void()> callback;
+		{
+			std::lock_guard lock{ _mutex };
+			callback = _changeCallback;
+		}
+
+		if (callback)
+			callback();
+	});
+}
+
+CDeviceRegistry::~CDeviceRegistry()
+{
+	_backend.setDeviceChangeCallback({});
+}
+
+std::vector<AudioDeviceInfo> CDeviceRegistry::devices()
+{
+	std::lock_guard lock{ _mutex };
+	if (!_bValid)
+		refreshDevices();
+
+	return _devices;
+}
+
+std::optional<AudioDeviceInfo> CDeviceRegistry::device(const std::wstring& id)
+{
+	std::lock_guard lock{ _mutex };
+	if (!_bValid)
+		refreshDevices();
+
+	const auto it = _deviceIndex.find(id);
+	if (it == _deviceIndex.end())
+		return {};
+
+	return _devices[it->second];
+}
+
+AudioFormat CDeviceRegistry::mixFormat(const std::wstring& id)
+{
+	uint64_t generation = 0;
+	{
+		std::lock_guard lock{ _mutex };
+		if (const auto it = _mixFormats.find(id); it != _mixFormats.end())
+			return it->second;
+
+		generation = _generation;
+	}
+
+	// Not holding the lock while the backend talks to the device.
+	auto format = _backend.mixFormat(id);
+
+	std::lock_guard lock{ _mutex };
+	// Don't cache a failure, or a format that may have been obsoleted by a notification received in the meantime.
+	if (!format.channels.empty() && generation == _generation)
+		_mixFormats.emplace(id, format);
+
+	return format;
+}
+
+void CDeviceRegistry::invalidate() noexcept
+{
+	std::lock_guard lock{ _mutex };
+	_bValid = false;
+	_mixFormats.clear();
+	++_generation;
+}
+
+void CDeviceRegistry::setChangeCallback(std::function<void()> callback)
+{
+	std::lock_guard lock{ _mutex };
+	_changeCallback = std::move(callback);
+}
+
+void CDeviceRegistry::refreshDevices()
+{
+	_devices = _backend.devices();
+
+	_deviceIndex.clear();
+	for (size_t i = 0; i < _devices.size(); ++i)
+		_deviceIndex.emplace(_devices[i].id, i);
+
+	_bValid = true;
+}
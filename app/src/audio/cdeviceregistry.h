@@ -0,0 +1,50 @@
+#pragma once
+#include "caudiobackend.h"
+
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Caches the backend's device list and mix formats, keyed by the device ID.
+// The backend's device change notifications invalidate the cache, which is refilled on the next query.
+// Thread-safe; the notifications arrive on the backend's thread.
+class CDeviceRegistry
+{
+public:
+	explicit CDeviceRegistry(CAudioBackend& backend);
+	~CDeviceRegistry();
+
+	CDeviceRegistry(const CDeviceRegistry&) = delete;
+	CDeviceRegistry& operator=(const CDeviceRegistry&) = delete;
+
+	[[nodiscard]] std::vector<AudioDeviceInfo> devices();
+	[[nodiscard]] std::optional<AudioDeviceInfo> device(const std::wstring& id);
+	// Queries the backend once per device, then serves the cached format until the next change notification.
+	[[nodiscard]] AudioFormat mixFormat(const std::wstring& id);
+
+	void invalidate() noexcept;
+
+	// Called (on an arbitrary thread) after the cache has been invalidated by a device change.
+	void setChangeCallback(std::function<void()> callback);
+
+private:
+	// Must be called with _mutex locked.
+	void refreshDevices();
+
+private:
+	CAudioBackend& _backend;
+
+	std::mutex _mutex;
+	bool _bValid = false;
+	// Incremented by every invalidation, so that mixFormat() can tell if its result has gone stale while it was querying the backend.
+	uint64_t _generation = 0;
+	std::vector<AudioDeviceInfo> _devices;
+	std::unordered_map<std::wstring, size_t> _deviceIndex;
+	std::unordered_map<std::wstring, AudioFormat> _mixFormats;
+
+	std::function<void()> _changeCallback;
+};
@@ -0,0 +1,176 @@
+#include "cglitchmonitor.h"
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
+static constexpr size_t maxQueuedBlocks = 1024;
+static constexpr uint64_t maxEventsPerSecond = 50;
+// How often the analysis thread wakes up to drain the ring.
+static constexpr auto analysisInterval = std::chrono::milliseconds{ 20 };
+
+CGlitchMonitor::~CGlitchMonitor()
+{
+	stop();
+}
+
+bool CGlitchMonitor::start(const size_t nChannels, const uint32_t sampleRate, const std::string& logFilePath, EventCallback callback)
+{
+	assert_and_return_r(!_thread.joinable(), false);
+	assert_and_return_r(nChannels > 0 && sampleRate > 0, false);
+
+	_nChannels = nChannels;
+	_sampleRate = sampleRate;
+	_detector.reset(nChannels, sampleRate);
+
+	_blocks.reset(maxQueuedBlocks);
+	_samples.reset(nChannels * sampleRate);
+	_blockFrames.resize(_samples.capacity());
+	_events.clear();
+	_expectedFrame.reset();
+	_callback = std::move(callback);
+	_eventsThisSecond = 0;
+	_currentSecond = 0;
+	_suppressedEvents = 0;
+	_eventCount = 0;
+	_framesAnalysed = 0;
+
+	if (!logFilePath.empty())
+	{
+		_logFile = std::fopen(logFilePath.c_str(), "a");
+		assert_message_r(_logFile, "Failed to open " + logFilePath);
+	}
+
+	if (_logFile)
+	{
+		const std::time_t now = std::time(nullptr);
+		char time[32];
+		std::strftime(time, sizeof(time), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+		std::fprintf(_logFile, "%s: started, %zu channels, %u Hz\n", time, nChannels, sampleRate);
+		std::fflush(_logFile);
+	}
+
+	_bTerminateThread = false;
+	_thread = std::thread(&CGlitchMonitor::analysisThread, this);
+	return true;
+}
+
+void CGlitchMonitor::stop()
+{
+	if (!_thread.joinable())
+		return;
+
+	{
+		std::lock_guard lock{ _wakeMutex };
+		_bTerminateThread = true;
+	}
+
+	_wake.notify_one();
+	_thread.join();
+
+	if (_logFile)
+	{
+		if (_suppressedEvents > 0)
+			std::fprintf(_logFile, "%llu more events not logged\n", static_cast<unsigned long long>(_suppressedEvents));
+		std::fprintf(_logFile, "Stopped: %llu frames analysed, %llu events\n", static_cast<unsigned long long>(_framesAnalysed.load()), static_cast<unsigned long long>(_eventCount.load()));
+		std::fclose(_logFile);
+		_logFile = nullptr;
+	}
+}
+
+bool CGlitchMonitor::isRunning() const noexcept
+{
+	return _thread.joinable();
+}
+
+void CGlitchMonitor::push(const float* frames, const size_t nFrames, const uint64_t firstFrame, const bool signalChanged) noexcept
+{
+	// The analysis thread finds out about the frames that don't fit from the gap in the positions.
+	if (_blocks.freeSpace() == 0 || !_samples.push(frames, nFrames * _nChannels))
+		return;
+
+	const BlockHeader header{ firstFrame, static_cast<uint32_t>(nFrames), signalChanged };
+	_blocks.push(&header, 1);
+}
+
+uint64_t CGlitchMonitor::events() const noexcept
+{
+	return _eventCount.load(std::memory_order_relaxed);
+}
+
+uint64_t CGlitchMonitor::framesAnalysed() const noexcept
+{
+	return _framesAnalysed.load(std::memory_order_relaxed);
+}
+
+void CGlitchMonitor::analysisThread()
+{
+	for (;;)
+	{
+		{
+			std::unique_lock lock{ _wakeMutex };
+			_wake.wait_for(lock, analysisInterval, [this] { return _bTerminateThread.load(); });
+		}
+
+		drain();
+		if (_bTerminateThread)
+			return;
+	}
+}
+
+void CGlitchMonitor::drain()
+{
+	BlockHeader header;
+	// The frames of a block are pushed before its header.
+	while (_blocks.pop(&header, 1) == 1)
+	{
+		const size_t nSamples = header.nFrames * _nChannels;
+		_samples.pop(_blockFrames.data(), nSamples);
+
+		if (_expectedFrame && header.firstFrame > *_expectedFrame)
+		{
+			GlitchEvent gap;
+			gap.type = GlitchEvent::AnalysisGap;
+			gap.frame = *_expectedFrame;
+			gap.lengthFrames = header.firstFrame - *_expectedFrame;
+			report(gap);
+		}
+
+		_expectedFrame = header.firstFrame + header.nFrames;
+
+		_events.clear();
+		_detector.process(_blockFrames.data(), header.nFrames, header.firstFrame, header.signalChanged, _events);
+		_framesAnalysed.fetch_add(header.nFrames, std::memory_order_relaxed);
+
+		for (const auto& event : _events)
+			report(event);
+	}
+
+	if (_logFile)
+		std::fflush(_logFile);
+}
+
+void CGlitchMonitor::report(const GlitchEvent& event)
+{
+	_eventCount.fetch_add(1, std::memory_order_relaxed);
+
+	const uint64_t second = event.frame / _sampleRate;
+	if (second != _currentSecond)
+	{
+		_currentSecond = second;
+		_eventsThisSecond = 0;
+	}
+
+	if (++_eventsThisSecond > maxEventsPerSecond)
+	{
+		++_suppressedEvents;
+		return;
+	}
+
+	if (_logFile)
+		std::fprintf(_logFile, "%s\n", toString(event, _sampleRate).c_str());
+
+	if (_callback)
+		_callback(event);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "glitchdetector.h"
+#include "spscringbuffer.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs GlitchDetector on every frame the render thread produces, on a thread of its own.
+// The render thread only copies the frames into a preallocated ring; if the analysis falls behind, the frames that don't fit
+// are reported as a GlitchEvent::AnalysisGap rather than holding the render thread up.
+class CGlitchMonitor final
+{
+public:
+	// Called on the analysis thread.
+	using EventCallback = std::function<void(const GlitchEvent&)>;
+
+	~CGlitchMonitor();
+
+	// Allocates the ring for a second of audio and starts the analysis thread. Every event is appended to the log file, if given,
+	// and passed to the callback. Must be called while the render thread isn't pushing.
+	bool start(size_t nChannels, uint32_t sampleRate, const std::string& logFilePath, EventCallback callback);
+	// Analyses whatever has been pushed so far and stops the thread.
+	void stop();
+	[[nodiscard]] bool isRunning() const noexcept;
+
+	// Render thread: never blocks or allocates. firstFrame is the stream position of the first frame;
+	// signalChanged tells that the generator settings have changed since the previous block.
+	void push(const float* frames, size_t nFrames, uint64_t firstFrame, bool signalChanged) noexcept;
+
+	// Totals since start().
+	[[nodiscard]] uint64_t events() const noexcept;
+	[[nodiscard]] uint64_t framesAnalysed() const noexcept;
+
+private:
+	// Precedes every block's frames in _samples.
+	struct BlockHeader {
+		uint64_t firstFrame;
+		uint32_t nFrames;
+		bool signalChanged;
+	};
+
+	void analysisThread();
+	// Analyses everything in the rings.
+	void drain();
+	void report(const GlitchEvent& event);
+
+private:
+	GlitchDetector _detector;
+	size_t _nChannels = 0;
+	uint32_t _sampleRate = 0;
+
+	SpscRingBuffer<BlockHeader> _blocks;
+	SpscRingBuffer<float> _samples;
+
+	// Analysis thread state
+	std::vector<float> _blockFrames;
+	std::vector<GlitchEvent> _events;
+	std::optional<uint64_t> _expectedFrame;
+	FILE* _logFile = nullptr;
+	EventCallback _callback;
+	// Events past this many per second of audio are counted but not reported, so that a broken stream doesn't flood the log.
+	uint64_t _eventsThisSecond = 0;
+	uint64_t _currentSecond = 0;
+	uint64_t _suppressedEvents = 0;
+
+	std::atomic<uint64_t> _eventCount = 0;
+	std::atomic<uint64_t> _framesAnalysed = 0;
+
+	std::thread _thread;
+	std::atomic_bool _bTerminateThread = false;
+	std::mutex _wakeMutex;
+	std::condition_variable _wake;
+};
@@ -0,0 +1,139 @@
+#include "channelgains.h"
+
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr double pi = 3.14159265358979323846;
+
+void ChannelGains::prepare(const size_t nChannels, const uint32_t sampleRate, const RampShape shape, const double rampSeconds)
+{
+	assert_r(nChannels > 0);
+	_channels.assign(nChannels, Ramp{ 0.0f, 0.0f, 0 });
+	_bFading = false;
+
+	_rampFrames = static_cast<uint32_t>(std::max<long long>(std::llround(rampSeconds * sampleRate), 1));
+	_curve.resize(_rampFrames + 1);
+	for (uint32_t i = 0; i <= _rampFrames; ++i)
+	{
+		const double progress = static_cast<double>(i) / _rampFrames;
+		switch (shape)
+		{
+		case RampShape::Linear:
+			_curve[i] = static_cast<float>(progress);
+			break;
+		case RampShape::EqualPower:
+			_curve[i] = static_cast<float>(std::sin(0.5 * pi * progress));
+			break;
+		case RampShape::RaisedCosine:
+			_curve[i] = static_cast<float>(0.5 - 0.5 * std::cos(pi * progress));
+			break;
+		}
+	}
+
+	for (Ramp& ramp : _channels)
+		ramp.frame = _rampFrames;
+	updateState();
+}
+
+void ChannelGains::setGain(const float gain) noexcept
+{
+	for (Ramp& ramp : _channels)
+		startRamp(ramp, gain);
+}
+
+void ChannelGains::crossfade(const size_t from, const size_t to, const float gain) noexcept
+{
+	if (from == to || from >= _channels.size() || to >= _channels.size())
+		return;
+
+	// The signal has only just appeared on the new channel.
+	_channels[to] = Ramp{ 0.0f, gain, 0 };
+
+	_fade = _channels[from];
+	startRamp(_fade, 0.0f);
+	_fadeChannel = from;
+	_fadeSourceChannel = to;
+	_bFading = true;
+	_bRamping = true;
+}
+
+bool ChannelGains::isRamping() const noexcept
+{
+	return _bRamping;
+}
+
+void ChannelGains::apply(float* interleavedBuffer, const size_t nFrames) noexcept
+{
+	const size_t nChannels = _channels.size();
+	if (!_bRamping)
+	{
+		if (_bUniform)
+		{
+			if (const float gain = _channels.front().to; gain != 1.0f)
+			{
+				for (size_t i = 0, n = nFrames * nChannels; i < n; ++i)
+					interleavedBuffer[i] *= gain;
+			}
+		}
+		else
+		{
+			for (size_t frame = 0; frame < nFrames; ++frame)
+			{
+				for (size_t c = 0; c < nChannels; ++c)
+					interleavedBuffer[frame * nChannels + c] *= _channels[c].to;
+			}
+		}
+
+		return;
+	}
+
+	for (size_t frame = 0; frame < nFrames; ++frame)
+	{
+		float* samples = interleavedBuffer + frame * nChannels;
+		const float source = samples[_fadeSourceChannel];
+		for (size_t c = 0; c < nChannels; ++c)
+		{
+			Ramp& ramp = _channels[c];
+			samples[c] *= gainAt(ramp);
+			if (ramp.frame < _rampFrames)
+				++ramp.frame;
+		}
+
+		if (_bFading)
+		{
+			samples[_fadeChannel] = source * gainAt(_fade);
+			_bFading = ++_fade.frame < _rampFrames;
+		}
+	}
+
+	updateState();
+}
+
+float ChannelGains::gainAt(const Ramp& ramp) const noexcept
+{
+	if (ramp.frame >= _rampFrames)
+		return ramp.to;
+
+	// Fading out, the curve read backwards: the same as 1 - progress for the linear and raised-cosine shapes, the cosine for the equal-power one,
+	// which keeps the power of a crossfade constant. Between two non-zero gains, a plain interpolation that doesn't overshoot.
+	if (ramp.to == 0.0f)
+		return ramp.from * _curve[_rampFrames - ramp.frame];
+
+	return ramp.from + (ramp.to - ramp.from) * _curve[ramp.frame];
+}
+
+void ChannelGains::startRamp(Ramp& ramp, const float to) noexcept
+{
+	const float current = gainAt(ramp);
+	ramp = Ramp{ current, to, current == to ? _rampFrames : 0 };
+	if (ramp.frame < _rampFrames)
+		_bRamping = true;
+}
+
+void ChannelGains::updateState() noexcept
+{
+	_bRamping = _bFading || std::any_of(_channels.cbegin(), _channels.cend(), [this](const Ramp& ramp) { return ramp.frame < _rampFrames; });
+	_bUniform = std::all_of(_channels.cbegin(), _channels.cend(), [this](const Ramp& ramp) { return ramp.to == _channels.front().to; });
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+enum class RampShape { Linear, EqualPower, RaisedCosine };
+
+// The output gain of every channel, smoothed: a new gain is reached through a ramp of the configured shape and length rather than
+// in one step, so that starting, stopping, gain changes and moving the signal to another channel don't click.
+// Equal-power ramps keep the total power constant through a crossfade; raised-cosine ones have no slope discontinuity at either end.
+//
+// The ramp is a table of its progress precomputed by prepare(); every other method belongs to the render thread.
+class ChannelGains
+{
+public:
+	// Every channel starts silent. Allocates.
+	void prepare(size_t nChannels, uint32_t sampleRate, RampShape shape, double rampSeconds);
+
+	// Ramps every channel from where it is to gain.
+	void setGain(float gain) noexcept;
+	// Moves a single-channel signal from one channel to another: it fades in on channel to while a copy of it fades out on channel from.
+	// A crossfade still running is cut short.
+	void crossfade(size_t from, size_t to, float gain) noexcept;
+
+	[[nodiscard]] bool isRamping() const noexcept;
+
+	// Scales an interleaved buffer in place and advances the ramps. Outside the ramps this is a single multiplication per sample,
+	// or nothing at unity gain.
+	void apply(float* interleavedBuffer, size_t nFrames) noexcept;
+
+private:
+	struct Ramp {
+		float from = 0.0f;
+		float to = 0.0f;
+		// Steady at `to` from _rampFrames on.
+		uint32_t frame = 0;
+	};
+
+	[[nodiscard]] float gainAt(const Ramp& ramp) const noexcept;
+	void startRamp(Ramp& ramp, float to) noexcept;
+	void updateState() noexcept;
+
+private:
+	std::vector<Ramp> _channels;
+
+	// The copy of the signal that crossfade() fades out.
+	Ramp _fade;
+	size_t _fadeChannel = 0;
+	size_t _fadeSourceChannel = 0;
+	bool _bFading = false;
+
+	// The progress of the ramp from 0 to 1, _rampFrames + 1 entries.
+	std::vector<float> _curve;
+	uint32_t _rampFrames = 1;
+
+	bool _bRamping = false;
+	// Every channel is steady at the same gain.
+	bool _bUniform = true;
+};
@@ -0,0 +1,109 @@
+#include "ctonegeneratordevice.h"
+
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+static constexpr size_t scratchFrames = 4096;
+
+[[nodiscard]] static AudioFormat toAudioFormat(const QAudioFormat& format)
+{
+	AudioFormat fmt;
+	fmt.sampleRate = static_cast<uint32_t>(format.sampleRate());
+	fmt.sampleFormat = format.sampleType() == QAudioFormat::Float ? AudioFormat::Float : AudioFormat::PCM;
+	fmt.bitsPerSample = static_cast<uint16_t>(format.sampleSize());
+	for (int c = 0; c < format.channelCount(); ++c)
+		fmt.channels.emplace_back(std::to_string(c), static_cast<size_t>(c));
+
+	return fmt;
+}
+
+CToneGeneratorDevice::CToneGeneratorDevice(const QAudioFormat& format, const float hz, const int channelIndex, const float amplitude, const uint64_t durationFrames, QObject* parent) :
+	QIODevice(parent),
+	_params{ Params{ hz, channelIndex, amplitude } },
+	_nChannels{ static_cast<size_t>(format.channelCount()) },
+	_durationFrames{ durationFrames },
+	_sampleWriter{ toAudioFormat(format), true }
+{
+	assert_r(isFormatSupported(format));
+
+	_oscillator.setSampleRate(static_cast<uint32_t>(format.sampleRate()));
+	_scratch.resize(scratchFrames * _nChannels);
+}
+
+bool CToneGeneratorDevice::isFormatSupported(const QAudioFormat& format)
+{
+	if (format.sampleType() != QAudioFormat::Float && format.sampleType() != QAudioFormat::SignedInt)
+		return false;
+
+	return SampleWriter::sampleType(toAudioFormat(format)) != SampleWriter::SampleType::Unsupported;
+}
+
+void CToneGeneratorDevice::setFrequency(float hz)
+{
+	_params.modify([hz](Params& p) { p.hz = hz; });
+}
+
+void CToneGeneratorDevice::setChannelIndex(int channelIndex)
+{
+	_params.modify([channelIndex](Params& p) { p.channelIndex = channelIndex; });
+}
+
+void CToneGeneratorDevice::setAmplitude(float amplitude)
+{
+	assert_and_return_r(amplitude >= 0.0f && amplitude <= 1.0f, );
+	_params.modify([amplitude](Params& p) { p.amplitude = amplitude; });
+}
+
+bool CToneGeneratorDevice::isSequential() const
+{
+	return true;
+}
+
+qint64 CToneGeneratorDevice::bytesAvailable() const
+{
+	const auto frameSize = static_cast<qint64>(_nChannels * _sampleWriter.bytesPerSample());
+	if (_durationFrames == 0)
+		return std::numeric_limits<qint64>::max() / frameSize * frameSize;
+
+	return static_cast<qint64>(_durationFrames - _framesGenerated) * frameSize + QIODevice::bytesAvailable();
+}
+
+bool CToneGeneratorDevice::atEnd() const
+{
+	return _durationFrames != 0 && _framesGenerated >= _durationFrames;
+}
+
+qint64 CToneGeneratorDevice::readData(char* data, const qint64 maxlen)
+{
+	const size_t frameSize = _nChannels * _sampleWriter.bytesPerSample();
+	size_t nFrames = static_cast<size_t>(maxlen) / frameSize;
+	if (_durationFrames != 0)
+		nFrames = static_cast<size_t>(std::min<uint64_t>(nFrames, _durationFrames - _framesGenerated));
+
+	const auto& params = _params.read();
+	// Rendered as float into the scratch buffer first, then converted to the output sample format.
+	for (size_t offset = 0; offset < nFrames; offset += scratchFrames)
+	{
+		const size_t n = std::min(scratchFrames, nFrames - offset);
+		_oscillator.renderTone(_scratch.data(), n, _nChannels, static_cast<size_t>(params.channelIndex), params.hz);
+
+		if (params.amplitude != 1.0f)
+		{
+			for (size_t i = 0; i < n * _nChannels; ++i)
+				_scratch[i] *= params.amplitude;
+		}
+
+		_sampleWriter.write(data + offset * frameSize, _scratch.data(), n * _nChannels);
+	}
+
+	_framesGenerated += nFrames;
+	return static_cast<qint64>(nFrames * frameSize);
+}
+
+qint64 CToneGeneratorDevice::writeData(const char* /*data*/, qint64 /*len*/)
+{
+	return -1;
+}
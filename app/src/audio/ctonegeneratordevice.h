@@ -0,0 +1,56 @@
+#pragma once
+#include "oscillator.h"
+#include "samplewriter.h"
+#include "triplebuffer.hpp"
+
+#include "compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QAudioFormat>
+#include <QIODevice>
+RESTORE_COMPILER_WARNINGS
+
+#include <stdint.h>
+#include <vector>
+
+// Pull-mode sample source for QAudioOutput: synthesizes frames on demand in readData(), continuing the phase,
+// so memory use is constant regardless of the duration and playback can start immediately.
+// The tone parameters can be changed from any thread while playing.
+class CToneGeneratorDevice final : public QIODevice
+{
+public:
+	// durationFrames == 0 means the tone never ends.
+	CToneGeneratorDevice(const QAudioFormat& format, float hz, int channelIndex, float amplitude, uint64_t durationFrames, QObject* parent = nullptr);
+
+	// Float and 16/24/32-bit signed integer formats are supported.
+	[[nodiscard]] static bool isFormatSupported(const QAudioFormat& format);
+
+	void setFrequency(float hz);
+	void setChannelIndex(int channelIndex);
+	void setAmplitude(float amplitude);
+
+	[[nodiscard]] bool isSequential() const override;
+	[[nodiscard]] qint64 bytesAvailable() const override;
+	[[nodiscard]] bool atEnd() const override;
+
+protected:
+	qint64 readData(char* data, qint64 maxlen) override;
+	qint64 writeData(const char* data, qint64 len) override;
+
+private:
+	struct Params {
+		float hz = 1000.0f;
+		int channelIndex = 0;
+		float amplitude = 1.0f;
+	};
+
+	TripleBuffer<Params> _params;
+
+	const size_t _nChannels;
+	const uint64_t _durationFrames;
+	uint64_t _framesGenerated = 0;
+
+	ToneOscillator _oscillator;
+	SampleWriter _sampleWriter;
+	std::vector<float> _scratch;
+};
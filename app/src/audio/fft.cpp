@@ -0,0 +1,172 @@
+#include "fft.h"
+#include "assert/advanced_assert.h"
+
+#include <cmath>
+#include <numbers>
+
+[[nodiscard]] static size_t roundUpToVector(const size_t n) noexcept
+{
+	return (n + Simd::width - 1) / Simd::width * Simd::width;
+}
+
+RealFft::RealFft(const size_t size)
+{
+	if (size != 0)
+		reset(size);
+}
+
+void RealFft::reset(const size_t size)
+{
+	assert_and_return_message_r(size >= 4 && (size & (size - 1)) == 0, "The FFT size must be a power of 2", );
+
+	_size = size;
+	_n = size / 2;
+
+	unsigned int log2n = 0;
+	while ((size_t{ 1 } << log2n) < _n)
+		++log2n;
+
+	_bitReversed.resize(_n);
+	for (size_t i = 0; i < _n; ++i)
+	{
+		uint32_t reversed = 0;
+		for (unsigned int bit = 0; bit < log2n; ++bit)
+			reversed |= static_cast<uint32_t>((i >> bit) & 1) << (log2n - 1 - bit);
+
+		_bitReversed[i] = reversed;
+	}
+
+	_halfStride = roundUpToVector(_n);
+	_work.assign(2 * _halfStride / Simd::width, VectorBlock{});
+	_twiddles.assign(2 * _halfStride / Simd::width, VectorBlock{});
+
+	auto* twiddles = reinterpret_cast<float*>(_twiddles.data());
+	for (size_t h = 1; h < _n; h *= 2)
+	{
+		for (size_t j = 0; j < h; ++j)
+		{
+			const double angle = -std::numbers::pi * static_cast<double>(j) / static_cast<double>(h);
+			twiddles[h + j] = static_cast<float>(std::cos(angle));
+			twiddles[_halfStride + h + j] = static_cast<float>(std::sin(angle));
+		}
+	}
+
+	_splitCos.resize(_n + 1);
+	_splitSin.resize(_n + 1);
+	for (size_t k = 0; k <= _n; ++k)
+	{
+		const double angle = std::numbers::pi * static_cast<double>(k) / static_cast<double>(_n);
+		_splitCos[k] = static_cast<float>(std::cos(angle));
+		_splitSin[k] = static_cast<float>(std::sin(angle));
+	}
+}
+
+size_t RealFft::size() const noexcept
+{
+	return _size;
+}
+
+void RealFft::transform(const float* input, float* re, float* im) noexcept
+{
+	float* zr = real();
+	float* zi = imag();
+
+	// Even samples are the real part, odd ones the imaginary part.
+	for (size_t i = 0; i < _n; ++i)
+	{
+		const uint32_t j = _bitReversed[i];
+		zr[j] = input[2 * i];
+		zi[j] = input[2 * i + 1];
+	}
+
+	complexTransform();
+
+	// X[k] = E[k] + e^(-i*pi*k/n) * O[k], where E and O, the spectra of the even and odd samples, are the conjugate-symmetric
+	// and antisymmetric parts of Z: E[k] = (Z[k] + Z*[n - k]) / 2, O[k] = (Z[k] - Z*[n - k]) / 2i.
+	for (size_t k = 0; k <= _n; ++k)
+	{
+		const size_t k1 = k == _n ? 0 : k;
+		const size_t k2 = k == 0 ? 0 : _n - k;
+		const float a = zr[k1], b = zi[k1];
+		const float c = zr[k2], d = zi[k2];
+
+		const float evenRe = 0.5f * (a + c), evenIm = 0.5f * (b - d);
+		const float oddRe = 0.5f * (b + d), oddIm = 0.5f * (c - a);
+		const float cs = _splitCos[k], sn = _splitSin[k];
+
+		re[k] = evenRe + oddRe * cs + oddIm * sn;
+		im[k] = evenIm + oddIm * cs - oddRe * sn;
+	}
+}
+
+float* RealFft::real() noexcept
+{
+	return reinterpret_cast<float*>(_work.data());
+}
+
+float* RealFft::imag() noexcept
+{
+	return reinterpret_cast<float*>(_work.data()) + _halfStride;
+}
+
+const float* RealFft::twiddleReal(const size_t halfSpan) const noexcept
+{
+	return reinterpret_cast<const float*>(_twiddles.data()) + halfSpan;
+}
+
+const float* RealFft::twiddleImag(const size_t halfSpan) const noexcept
+{
+	return reinterpret_cast<const float*>(_twiddles.data()) + _halfStride + halfSpan;
+}
+
+void RealFft::complexTransform() noexcept
+{
+	float* xr = real();
+	float* xi = imag();
+
+	for (size_t h = 1; h < _n; h *= 2)
+	{
+		const float* wr = twiddleReal(h);
+		const float* wi = twiddleImag(h);
+
+		// Once the butterflies span whole vectors, so do their halves and twiddle tables, all aligned.
+		if (h >= Simd::width)
+		{
+			for (size_t k = 0; k < _n; k += 2 * h)
+			{
+				for (size_t j = 0; j < h; j += Simd::width)
+				{
+					const size_t top = k + j, bottom = k + j + h;
+					const Simd::V br = Simd::load(xr + bottom), bi = Simd::load(xi + bottom);
+					const Simd::V twr = Simd::load(wr + j), twi = Simd::load(wi + j);
+
+					const Simd::V tr = Simd::sub(Simd::mul(br, twr), Simd::mul(bi, twi));
+					const Simd::V ti = Simd::add(Simd::mul(br, twi), Simd::mul(bi, twr));
+					const Simd::V ar = Simd::load(xr + top), ai = Simd::load(xi + top);
+
+					Simd::store(xr + bottom, Simd::sub(ar, tr));
+					Simd::store(xi + bottom, Simd::sub(ai, ti));
+					Simd::store(xr + top, Simd::add(ar, tr));
+					Simd::store(xi + top, Simd::add(ai, ti));
+				}
+			}
+		}
+		else
+		{
+			for (size_t k = 0; k < _n; k += 2 * h)
+			{
+				for (size_t j = 0; j < h; ++j)
+				{
+					const size_t top = k + j, bottom = k + j + h;
+					const float tr = xr[bottom] * wr[j] - xi[bottom] * wi[j];
+					const float ti = xr[bottom] * wi[j] + xi[bottom] * wr[j];
+
+					xr[bottom] = xr[top] - tr;
+					xi[bottom] = xi[top] - ti;
+					xr[top] += tr;
+					xi[top] += ti;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "simd.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Forward FFT of a real signal of a fixed power-of-2 length. All the tables and the work buffers are allocated by the constructor
+// (or reset()), transform() never allocates.
+// The signal is packed into a complex one of half the length; that is transformed by an iterative radix-2 FFT on split real / imaginary
+// arrays, the butterflies of the wider stages running on Simd vectors, and the spectrum of the real signal is recovered from it.
+class RealFft
+{
+public:
+	explicit RealFft(size_t size = 0);
+
+	// size must be a power of 2, at least 4.
+	void reset(size_t size);
+	[[nodiscard]] size_t size() const noexcept;
+
+	// input is size() samples. re and im receive size() / 2 + 1 bins, from DC up to and including Nyquist; unnormalized.
+	void transform(const float* input, float* re, float* im) noexcept;
+
+private:
+	[[nodiscard]] float* real() noexcept;
+	[[nodiscard]] float* imag() noexcept;
+	[[nodiscard]] const float* twiddleReal(size_t halfSpan) const noexcept;
+	[[nodiscard]] const float* twiddleImag(size_t halfSpan) const noexcept;
+
+	// The complex FFT of the packed signal, in place in real() / imag().
+	void complexTransform() noexcept;
+
+private:
+	size_t _size = 0;
+	// The length of the complex transform: _size / 2.
+	size_t _n = 0;
+
+	// Bit-reversed positions for the input permutation.
+	std::vector<uint32_t> _bitReversed;
+
+	// Keeps every array aligned for Simd::load() / store().
+	struct alignas(alignof(Simd::V)) VectorBlock {
+		float v[Simd::width];
+	};
+
+	// The work buffer is the real part, then the imaginary part, _n each. The twiddles for the stage with the butterflies spanning
+	// 2h elements are at offset h in each of the two halves of their table.
+	std::vector<VectorBlock> _work;
+	std::vector<VectorBlock> _twiddles;
+	size_t _halfStride = 0;
+
+	// e^(-i*pi*k/_n) for k in [0; _n], to split the packed spectrum.
+	std::vector<float> _splitCos;
+	std::vector<float> _splitSin;
+};
@@ -0,0 +1,136 @@
+#include "glitchdetector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// Below -100 dBFS.
+static constexpr float silenceLevel = 1e-5f;
+// Three equal samples at or above this are a flat top.
+static constexpr float clipLevel = 0.99f;
+// A second difference this many times the recent peak is a jump; the floor keeps near-silence from tripping it.
+static constexpr float discontinuityRatio = 4.0f;
+static constexpr float discontinuityFloor = 1e-3f;
+// Long enough for the envelope to hold over the edges of a 20 Hz square wave.
+static constexpr double envelopeHalfLifeSeconds = 0.5;
+static constexpr double learningSeconds = 0.1;
+static constexpr double dropoutMinSeconds = 0.001;
+
+std::string toString(const GlitchEvent& event, const uint32_t sampleRate)
+{
+	const uint64_t ms = sampleRate > 0 ? event.frame * 1000 / sampleRate : 0;
+	char time[32];
+	std::snprintf(time, sizeof(time), "%02llu:%02llu:%02llu.%03llu",
+		static_cast<unsigned long long>(ms / 3'600'000), static_cast<unsigned long long>(ms / 60'000 % 60),
+		static_cast<unsigned long long>(ms / 1000 % 60), static_cast<unsigned long long>(ms % 1000));
+
+	std::string text = std::string{ time } + " (frame " + std::to_string(event.frame) + ")";
+	if (event.type != GlitchEvent::AnalysisGap)
+		text += ", channel " + std::to_string(event.channel + 1);
+
+	switch (event.type)
+	{
+	case GlitchEvent::Discontinuity:
+		return text + ": discontinuity, " + std::to_string(static_cast<int>(event.magnitude)) + "x the recent peak";
+	case GlitchEvent::Dropout:
+		return text + ": dropout, " + std::to_string(event.lengthFrames) + " frames";
+	case GlitchEvent::Clipping:
+		return text + ": clipping, " + std::to_string(event.lengthFrames) + " frames, peak " + std::to_string(event.magnitude);
+	case GlitchEvent::AnalysisGap:
+		return text + ": " + std::to_string(event.lengthFrames) + " frames not analysed";
+	}
+
+	return text;
+}
+
+void GlitchDetector::reset(const size_t nChannels, const uint32_t sampleRate)
+{
+	_channels.assign(nChannels, ChannelState{});
+	_sampleRate = sampleRate;
+	_envelopeDecay = static_cast<float>(std::pow(0.5, 1.0 / (envelopeHalfLifeSeconds * sampleRate)));
+	_dropoutMinFrames = std::max<uint64_t>(2, static_cast<uint64_t>(dropoutMinSeconds * sampleRate));
+	_learningFrames = static_cast<uint64_t>(learningSeconds * sampleRate);
+	_nextFrame.reset();
+}
+
+void GlitchDetector::relearn(const uint64_t fromFrame) noexcept
+{
+	_differenceFromFrame = fromFrame + 2;
+	_learnUntilFrame = fromFrame + _learningFrames;
+
+	for (auto& ch : _channels)
+	{
+		ch.envelope = 0.0f;
+		// A channel that has been switched off is not dropping out.
+		ch.bHadSignal = false;
+		ch.silenceLength = 0;
+	}
+}
+
+void GlitchDetector::process(const float* frames, const size_t nFrames, const uint64_t firstFrame, const bool signalChanged, std::vector<GlitchEvent>& events)
+{
+	if (signalChanged || _nextFrame != firstFrame)
+		relearn(firstFrame);
+
+	_nextFrame = firstFrame + nFrames;
+
+	const size_t nChannels = _channels.size();
+	for (size_t i = 0; i < nFrames; ++i)
+	{
+		const uint64_t frame = firstFrame + i;
+		const bool bLearning = frame < _learnUntilFrame;
+		const bool bHaveHistory = frame >= _differenceFromFrame;
+
+		for (size_t c = 0; c < nChannels; ++c)
+		{
+			ChannelState& ch = _channels[c];
+			const float x = frames[i * nChannels + c];
+			const float absX = std::abs(x);
+
+			if (absX > 1.0f || (absX >= clipLevel && x == ch.x1 && x == ch.x2))
+			{
+				if (ch.clipLength++ == 0)
+					ch.clipStart = frame;
+				ch.clipPeak = std::max(ch.clipPeak, absX);
+			}
+			else if (ch.clipLength > 0)
+			{
+				events.push_back({ GlitchEvent::Clipping, ch.clipStart, c, ch.clipLength, ch.clipPeak });
+				ch.clipLength = 0;
+				ch.clipPeak = 0.0f;
+			}
+
+			if (absX < silenceLevel)
+			{
+				if (ch.silenceLength++ == 0)
+					ch.silenceStart = frame;
+			}
+			else
+			{
+				if (ch.bHadSignal && ch.silenceLength >= _dropoutMinFrames)
+					events.push_back({ GlitchEvent::Dropout, ch.silenceStart, c, ch.silenceLength, 0.0f });
+
+				ch.silenceLength = 0;
+				ch.bHadSignal = true;
+			}
+
+			if (bHaveHistory)
+			{
+				const float d2 = std::abs(x - 2.0f * ch.x1 + ch.x2);
+				if (!bLearning && d2 > discontinuityRatio * ch.envelope + discontinuityFloor)
+				{
+					if (frame >= ch.discontinuityEnd)
+						events.push_back({ GlitchEvent::Discontinuity, frame, c, 1, d2 / std::max(ch.envelope, discontinuityFloor) });
+
+					// The jump itself doesn't raise the envelope, or it would mask the next one.
+					ch.discontinuityEnd = frame + 3;
+				}
+				else
+					ch.envelope = std::max(d2, ch.envelope * _envelopeDecay);
+			}
+
+			ch.x2 = ch.x1;
+			ch.x1 = x;
+		}
+	}
+}
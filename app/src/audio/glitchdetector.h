@@ -0,0 +1,78 @@
+#pragma once
+
+#include <optional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct GlitchEvent {
+	enum Type {
+		// A jump in the waveform: the second difference far above what the signal has been producing.
+		Discontinuity,
+		// A channel that had been playing went silent and came back.
+		Dropout,
+		// Samples beyond full scale, or flat-topped at it.
+		Clipping,
+		// Frames that never reached the detector because it had fallen behind; nothing is known about them.
+		AnalysisGap
+	};
+
+	Type type = Discontinuity;
+	// The position in the output stream (frames since playback started) of the first affected frame.
+	uint64_t frame = 0;
+	size_t channel = 0;
+	uint64_t lengthFrames = 1;
+	// Discontinuity: the jump relative to the recent peak second difference. Clipping: the peak absolute sample value.
+	float magnitude = 0.0f;
+};
+
+// E. g. "00:01:23.456 (frame 4006000), channel 2: dropout, 96 frames".
+[[nodiscard]] std::string toString(const GlitchEvent& event, uint32_t sampleRate);
+
+// Finds discontinuities, dropouts and clipping in a continuous stream of interleaved float frames.
+// Fixed cost per sample and channel, no allocations other than for the events reported.
+class GlitchDetector
+{
+public:
+	// Forgets everything and starts learning the signal anew.
+	void reset(size_t nChannels, uint32_t sampleRate);
+
+	// Analyses the next nFrames, which start at stream position firstFrame, and appends any glitches found to events.
+	// signalChanged means the generator's settings have changed at firstFrame: what follows is a different signal, not a glitch.
+	// Neither is a firstFrame that doesn't continue from the previous call: the detector starts learning the signal anew.
+	void process(const float* frames, size_t nFrames, uint64_t firstFrame, bool signalChanged, std::vector<GlitchEvent>& events);
+
+private:
+	struct ChannelState {
+		float x1 = 0.0f;
+		float x2 = 0.0f;
+		// Decaying peak of the second difference.
+		float envelope = 0.0f;
+		// A jump shows in the second difference of three frames in a row, only the first one is reported.
+		uint64_t discontinuityEnd = 0;
+
+		bool bHadSignal = false;
+		uint64_t silenceStart = 0;
+		uint64_t silenceLength = 0;
+
+		uint64_t clipStart = 0;
+		uint64_t clipLength = 0;
+		float clipPeak = 0.0f;
+	};
+
+	// After a reset, a gap or a signal change, discontinuities are not reported while the envelope is being learned.
+	void relearn(uint64_t fromFrame) noexcept;
+
+private:
+	std::vector<ChannelState> _channels;
+	uint32_t _sampleRate = 0;
+	float _envelopeDecay = 1.0f;
+	uint64_t _dropoutMinFrames = 0;
+	uint64_t _learningFrames = 0;
+
+	// The second difference needs two frames of the same signal before it.
+	uint64_t _differenceFromFrame = 0;
+	uint64_t _learnUntilFrame = 0;
+	std::optional<uint64_t> _nextFrame;
+};
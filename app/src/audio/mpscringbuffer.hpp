@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <type_traits>
+
+// Bounded lock-free multi-producer / single-consumer queue of trivially copyable items (D. Vyukov's bounded queue).
+// A producer reserves a run of slots by advancing the write index with a CAS, then publishes every slot by stamping its sequence
+// number, so a batch is all or nothing and never interleaved with another producer's items. Storage is allocated by reset() only.
+// The consumer never waits: it stops at the first slot still being written, and a producer preempted mid-push only delays its own
+// and later items until it resumes.
+template <typename T>
+class MpscRingBuffer
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+
+	struct Slot {
+		// The slot's position + 1 once its item has been written, i. e. the value the consumer expects to find there.
+		std::atomic<size_t> sequence = 0;
+		T item{};
+	};
+
+public:
+	// Not thread-safe: must be called while neither side is active. The capacity is rounded up to a power of 2.
+	void reset(const size_t minCapacity)
+	{
+		size_t capacity = 1;
+		while (capacity < minCapacity)
+			capacity <<= 1;
+
+		_slots = std::make_unique<Slot[]>(capacity);
+		_capacity = capacity;
+		_mask = capacity - 1;
+		_writeIndex.store(0, std::memory_order_relaxed);
+		_readIndex.store(0, std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] size_t capacity() const noexcept {
+		return _capacity;
+	}
+
+	// The storage allocated by reset(), e. g. for page-locking it.
+	[[nodiscard]] const void* data() const noexcept {
+		return _slots.get();
+	}
+
+	[[nodiscard]] size_t storageSize() const noexcept {
+		return _capacity * sizeof(Slot);
+	}
+
+	// Producer side, any number of threads. Writes all n items or nothing.
+	bool push(const T* items, const size_t n) noexcept
+	{
+		size_t write = _writeIndex.load(std::memory_order_relaxed);
+		do
+		{
+			// The consumer releases a slot only after it has copied the item out.
+			const size_t read = _readIndex.load(std::memory_order_acquire);
+			if (_capacity - (write - read) < n)
+				return false;
+		} while (!_writeIndex.compare_exchange_weak(write, write + n, std::memory_order_relaxed, std::memory_order_relaxed));
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			Slot& slot = _slots[(write + i) & _mask];
+			slot.item = items[i];
+			slot.sequence.store(write + i + 1, std::memory_order_release);
+		}
+
+		return true;
+	}
+
+	// Consumer side. Pops up to n items, stopping at the first one that hasn't been published yet.
+	size_t pop(T* items, const size_t n) noexcept
+	{
+		const size_t read = _readIndex.load(std::memory_order_relaxed);
+		size_t i = 0;
+		for (; i < n; ++i)
+		{
+			const Slot& slot = _slots[(read + i) & _mask];
+			if (slot.sequence.load(std::memory_order_acquire) != read + i + 1)
+				break;
+
+			items[i] = slot.item;
+		}
+
+		_readIndex.store(read + i, std::memory_order_release);
+		return i;
+	}
+
+private:
+	std::unique_ptr<Slot[]> _slots;
+	size_t _capacity = 0;
+	size_t _mask = 0;
+
+	// Monotonic counters, wrapped with _mask on access.
+	alignas(64) std::atomic<size_t> _writeIndex = 0;
+	alignas(64) std::atomic<size_t> _readIndex = 0;
+};
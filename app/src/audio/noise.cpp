@@ -0,0 +1,191 @@
+#include "noise.h"
+
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+[[nodiscard]] static inline uint64_t splitMix64(uint64_t& state) noexcept
+{
+	uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+void RandomLanes::seed(uint64_t seed) noexcept
+{
+	for (size_t lane = 0; lane < nLanes; ++lane)
+	{
+		const uint64_t a = splitMix64(seed), b = splitMix64(seed);
+		_s0[lane] = static_cast<uint32_t>(a);
+		_s1[lane] = static_cast<uint32_t>(a >> 32);
+		_s2[lane] = static_cast<uint32_t>(b);
+		// The all-zero state is the one state xoshiro can't leave.
+		_s3[lane] = static_cast<uint32_t>(b >> 32) | 1u;
+	}
+}
+
+void RandomLanes::fill(float* values, const size_t nValues) noexcept
+{
+	assert_debug_only(nValues % nLanes == 0);
+
+	// The top 24 bits of the sum become the float mantissa; the weak low bits of xoshiro128+ are discarded by the conversion.
+	constexpr float scale = 1.0f / 2147483648.0f;
+	for (size_t i = 0; i < nValues; i += nLanes)
+	{
+		for (size_t lane = 0; lane < nLanes; ++lane)
+		{
+			const uint32_t result = _s0[lane] + _s3[lane];
+			const uint32_t t = _s1[lane] << 9;
+
+			_s2[lane] ^= _s0[lane];
+			_s3[lane] ^= _s1[lane];
+			_s1[lane] ^= _s2[lane];
+			_s0[lane] ^= _s3[lane];
+			_s2[lane] ^= t;
+			_s3[lane] = (_s3[lane] << 11) | (_s3[lane] >> 21);
+
+			values[i + lane] = static_cast<float>(static_cast<int32_t>(result)) * scale;
+		}
+	}
+}
+
+void NoiseGenerator::prepare(const uint32_t sampleRate, const size_t nChannels)
+{
+	assert_and_return_r(sampleRate > 0, );
+
+	_sampleRate = sampleRate;
+	_streams.resize(nChannels);
+	setParams(_params);
+}
+
+void NoiseGenerator::setParams(const NoiseParams& params) noexcept
+{
+	_params = params;
+
+	// RBJ cookbook filters with Q = 1 / sqrt(2).
+	const auto makeFilter = [this](double hz, const bool highPass) {
+		hz = std::clamp(hz, 1.0, 0.49 * _sampleRate);
+		const double w0 = 2.0 * std::numbers::pi * hz / _sampleRate;
+		const double cosW0 = std::cos(w0);
+		const double alpha = std::sin(w0) / std::numbers::sqrt2;
+		const double a0 = 1.0 + alpha;
+
+		Biquad f;
+		f.b0 = (highPass ? (1.0 + cosW0) : (1.0 - cosW0)) / 2.0 / a0;
+		f.b1 = (highPass ? -(1.0 + cosW0) : (1.0 - cosW0)) / a0;
+		f.b2 = f.b0;
+		f.a1 = -2.0 * cosW0 / a0;
+		f.a2 = (1.0 - alpha) / a0;
+		return f;
+	};
+
+	const Biquad highPass = makeFilter(params.lowHz, true);
+	const Biquad lowPass = makeFilter(params.highHz, false);
+
+	uint64_t seed = params.seed;
+	for (Stream& stream : _streams)
+	{
+		stream.random.seed(splitMix64(seed));
+		stream.blockPosition = Stream::blockSize;
+
+		stream.pinkCounter = 0;
+		stream.pinkSum = 0.0f;
+		for (float& row : stream.pinkRows)
+		{
+			row = stream.nextUniform();
+			stream.pinkSum += row;
+		}
+
+		stream.highPass = highPass;
+		stream.lowPass = lowPass;
+	}
+}
+
+void NoiseGenerator::render(float* interleavedBuffer, const size_t nFrames, const size_t nChannels, const size_t channelIndex) noexcept
+{
+	std::memset(interleavedBuffer, 0, nFrames * nChannels * sizeof(float));
+
+	constexpr size_t chunkSize = 256;
+	float chunk[chunkSize];
+
+	for (size_t c = 0; c < std::min(nChannels, _streams.size()); ++c)
+	{
+		if (channelIndex != allChannels && channelIndex != c)
+			continue;
+
+		for (size_t offset = 0; offset < nFrames; offset += chunkSize)
+		{
+			const size_t n = std::min(chunkSize, nFrames - offset);
+			renderStream(_streams[c], chunk, n);
+
+			float* dst = interleavedBuffer + offset * nChannels + c;
+			for (size_t i = 0; i < n; ++i)
+				dst[i * nChannels] = chunk[i];
+		}
+	}
+}
+
+void NoiseGenerator::renderStream(Stream& stream, float* chunk, const size_t nFrames) noexcept
+{
+	const float gain = _params.gain;
+
+	switch (_params.type)
+	{
+	case NoiseParams::White:
+		// Straight from the random block, whatever the buffer size - the sequence only depends on the seed.
+		for (size_t i = 0; i < nFrames; )
+		{
+			if (stream.blockPosition == Stream::blockSize)
+			{
+				stream.random.fill(stream.block, Stream::blockSize);
+				stream.blockPosition = 0;
+			}
+
+			const size_t n = std::min(nFrames - i, Stream::blockSize - stream.blockPosition);
+			for (size_t k = 0; k < n; ++k)
+				chunk[i + k] = stream.block[stream.blockPosition + k] * gain;
+
+			i += n;
+			stream.blockPosition += n;
+		}
+		break;
+
+	case NoiseParams::Pink:
+	{
+		// 16 rows and a white sample - 17 uniform values: scaling by 1 / sqrt(17) matches the RMS of the white noise.
+		const float scale = gain / std::sqrt(static_cast<float>(Stream::nPinkRows + 1));
+		for (size_t i = 0; i < nFrames; ++i)
+		{
+			const uint32_t counter = ++stream.pinkCounter;
+			const auto row = static_cast<size_t>(std::countr_zero(counter));
+			if (row < Stream::nPinkRows)
+			{
+				const float value = stream.nextUniform();
+				stream.pinkSum += value - stream.pinkRows[row];
+				stream.pinkRows[row] = value;
+			}
+
+			chunk[i] = (stream.pinkSum + stream.nextUniform()) * scale;
+
+			// Re-add the rows from scratch now and then so that the rounding errors of the running sum don't accumulate.
+			if ((counter & 0xFFFFu) == 0)
+			{
+				stream.pinkSum = 0.0f;
+				for (const float rowValue : stream.pinkRows)
+					stream.pinkSum += rowValue;
+			}
+		}
+		break;
+	}
+
+	case NoiseParams::BandLimited:
+		for (size_t i = 0; i < nFrames; ++i)
+			chunk[i] = stream.lowPass.process(stream.highPass.process(stream.nextUniform())) * gain;
+		break;
+	}
+}
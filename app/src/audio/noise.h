@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+struct NoiseParams {
+	enum Type { White, Pink, BandLimited };
+
+	Type type = Pink;
+	// White noise is uniform in [-gain; gain] (RMS gain / sqrt(3)); pink noise has the same RMS but a higher crest factor.
+	float gain = 0.25f;
+	// The same seed always produces the same samples.
+	uint64_t seed = 1;
+
+	// BandLimited only: white noise through 2nd order Butterworth high-pass and low-pass filters.
+	double lowHz = 500.0;
+	double highHz = 2000.0;
+};
+
+// xoshiro128+ with its state laid out as arrays of lanes, so that the generation loop vectorizes.
+// Each lane is an independent generator; the lanes are interleaved in the output.
+class RandomLanes
+{
+public:
+	static constexpr size_t nLanes = 8;
+
+	void seed(uint64_t seed) noexcept;
+	// Fills nValues (a multiple of nLanes) uniform floats in [-1; 1).
+	void fill(float* values, size_t nValues) noexcept;
+
+private:
+	alignas(32) uint32_t _s0[nLanes];
+	alignas(32) uint32_t _s1[nLanes];
+	alignas(32) uint32_t _s2[nLanes];
+	alignas(32) uint32_t _s3[nLanes];
+};
+
+// White, pink (Voss-McCartney) or band-limited noise. Every channel has its own independent stream derived from the seed.
+class NoiseGenerator
+{
+public:
+	// Renders into all the channels rather than just one.
+	static constexpr size_t allChannels = static_cast<size_t>(-1);
+
+	// Not real-time safe, allocates the per-channel state.
+	void prepare(uint32_t sampleRate, size_t nChannels);
+	// Reseeds all the streams and recalculates the filters. Real-time safe.
+	void setParams(const NoiseParams& params) noexcept;
+
+	// Writes noise into the channel channelIndex of an interleaved float buffer (or into every channel for allChannels) and zeroes the rest.
+	void render(float* interleavedBuffer, size_t nFrames, size_t nChannels, size_t channelIndex) noexcept;
+
+private:
+	struct Biquad {
+		double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+		double z1 = 0.0, z2 = 0.0;
+
+		[[nodiscard]] inline float process(const float x) noexcept {
+			const double y = b0 * x + z1;
+			z1 = b1 * x - a1 * y + z2;
+			z2 = b2 * x - a2 * y;
+			return static_cast<float>(y);
+		}
+	};
+
+	struct Stream {
+		static constexpr size_t nPinkRows = 16;
+		static constexpr size_t blockSize = 256;
+
+		RandomLanes random;
+		// Uniform samples ready to be consumed, refilled blockSize at a time.
+		alignas(32) float block[blockSize];
+		size_t blockPosition = blockSize;
+
+		// Voss-McCartney: row k is redrawn every 2^(k+1) samples, the sum of all the rows plus one white sample has a -3 dB / octave slope.
+		float pinkRows[nPinkRows] {};
+		float pinkSum = 0.0f;
+		uint32_t pinkCounter = 0;
+
+		Biquad highPass, lowPass;
+
+		[[nodiscard]] inline float nextUniform() noexcept {
+			if (blockPosition == blockSize)
+			{
+				random.fill(block, blockSize);
+				blockPosition = 0;
+			}
+
+			return block[blockPosition++];
+		}
+	};
+
+	void renderStream(Stream& stream, float* chunk, size_t nFrames) noexcept;
+
+private:
+	NoiseParams _params;
+	uint32_t _sampleRate = 48000;
+	std::vector<Stream> _streams;
+};
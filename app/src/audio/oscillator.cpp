@@ -0,0 +1,149 @@
+#include "oscillator.h"
+#include "tonekernel.h"
+
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+static constexpr double twoPi = 2.0 * std::numbers::pi;
+static constexpr size_t chunkSize = 256;
+
+// sin(x) for x in [-Pi; Pi]: folded to [-Pi/2; Pi/2], then a degree 11 Taylor polynomial (error < 1e-7).
+// Branch-free so that the loops calling it vectorize.
+[[nodiscard]] static inline float sinPoly(float x) noexcept
+{
+	constexpr float pi = std::numbers::pi_v<float>;
+	constexpr float halfPi = pi / 2.0f;
+	x = x > halfPi ? pi - x : (x < -halfPi ? -pi - x : x);
+
+	const float x2 = x * x;
+	return x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f + x2 * (1.0f / 362880.0f + x2 * (-1.0f / 39916800.0f))))));
+}
+
+void ToneOscillator::setSampleRate(const uint32_t sampleRate) noexcept
+{
+	assert_and_return_r(sampleRate > 0, );
+	_sampleRate = sampleRate;
+}
+
+void ToneOscillator::resetPhase() noexcept
+{
+	_phase = 0.0;
+}
+
+void ToneOscillator::renderTone(float* interleavedBuffer, const size_t nFrames, const size_t nChannels, const size_t channelIndex, const double hz, const Waveform waveform, const float pulseWidth) noexcept
+{
+	// s = A * sin(2 * Pi * f * t) = A * sin(Omega * t)
+	// Omega = 2 * Pi * f
+	// t = sampleIndex / samplesPerSecond
+	const double omega = twoPi * hz / static_cast<double>(_sampleRate);
+	if (waveform == Waveform::Sine)
+	{
+		_phase = generateTone(interleavedBuffer, nFrames, nChannels, channelIndex, _phase, omega);
+		return;
+	}
+
+	std::memset(interleavedBuffer, 0, nFrames * nChannels * sizeof(float));
+
+	// The wavetables measure the phase in periods rather than radians.
+	double phase = _phase / twoPi;
+	const double cyclesPerSample = hz / static_cast<double>(_sampleRate);
+
+	float chunk[chunkSize];
+	for (size_t offset = 0; offset < nFrames; offset += chunkSize)
+	{
+		const size_t n = std::min(chunkSize, nFrames - offset);
+		phase = renderWavetable(chunk, n, phase, cyclesPerSample, waveform, pulseWidth);
+
+		if (channelIndex >= nChannels)
+			continue;
+
+		float* dst = interleavedBuffer + offset * nChannels + channelIndex;
+		for (size_t i = 0; i < n; ++i)
+			dst[i * nChannels] = chunk[i];
+	}
+
+	_phase = phase * twoPi;
+}
+
+void ToneOscillator::startSweep(const SweepParams& sweep) noexcept
+{
+	assert_and_return_r(sweep.seconds > 0.0 && sweep.f0 > 0.0 && sweep.f1 > 0.0, );
+
+	_sweep = sweep;
+	_sweepFrame = 0;
+	_sweepLength = std::max<uint64_t>(1, static_cast<uint64_t>(sweep.seconds * _sampleRate));
+}
+
+void ToneOscillator::renderSweep(float* interleavedBuffer, const size_t nFrames, const size_t nChannels, const size_t channelIndex) noexcept
+{
+	std::memset(interleavedBuffer, 0, nFrames * nChannels * sizeof(float));
+
+	alignas(32) float chunk[chunkSize];
+	for (size_t offset = 0; offset < nFrames; offset += chunkSize)
+	{
+		const size_t n = std::min(chunkSize, nFrames - offset);
+		renderSweepChunk(chunk, n);
+
+		if (channelIndex >= nChannels)
+			continue;
+
+		float* dst = interleavedBuffer + offset * nChannels + channelIndex;
+		for (size_t i = 0; i < n; ++i)
+			dst[i * nChannels] = chunk[i];
+	}
+}
+
+bool ToneOscillator::sweepFinished() const noexcept
+{
+	return !_sweep.repeat && _sweepFrame >= _sweepLength;
+}
+
+double ToneOscillator::sweepIncrement(const uint64_t n) const noexcept
+{
+	const double t = static_cast<double>(std::min(n, _sweepLength)) / static_cast<double>(_sweepLength);
+	const double hz = _sweep.shape == SweepParams::Linear
+		? _sweep.f0 + (_sweep.f1 - _sweep.f0) * t
+		: _sweep.f0 * std::pow(_sweep.f1 / _sweep.f0, t);
+
+	return twoPi * hz / static_cast<double>(_sampleRate);
+}
+
+void ToneOscillator::renderSweepChunk(float* chunk, size_t nFrames) noexcept
+{
+	size_t i = 0;
+	while (i < nFrames)
+	{
+		if (_sweepFrame >= _sweepLength && _sweep.repeat)
+			_sweepFrame = 0;
+
+		// Hold f1 once a non-repeating sweep is over.
+		const size_t n = _sweepFrame < _sweepLength ? static_cast<size_t>(std::min<uint64_t>(nFrames - i, _sweepLength - _sweepFrame)) : nFrames - i;
+
+		// The increment is evaluated exactly at the start of the run and then stepped per sample:
+		// additively for the linear sweep, multiplicatively for the logarithmic one.
+		double increment = sweepIncrement(_sweepFrame);
+		const double linearStep = (sweepIncrement(_sweepLength) - sweepIncrement(0)) / static_cast<double>(_sweepLength);
+		const double logStep = std::pow(_sweep.f1 / _sweep.f0, 1.0 / static_cast<double>(_sweepLength));
+		const bool sweeping = _sweepFrame < _sweepLength;
+
+		double phase = _phase;
+		for (size_t k = 0; k < n; ++k)
+		{
+			const double reduced = phase - twoPi * std::nearbyint(phase / twoPi);
+			chunk[i + k] = sinPoly(static_cast<float>(reduced));
+
+			phase += increment;
+			if (sweeping)
+				increment = _sweep.shape == SweepParams::Linear ? increment + linearStep : increment * logStep;
+		}
+
+		_phase = std::fmod(phase, twoPi);
+		if (sweeping)
+			_sweepFrame += n;
+		i += n;
+	}
+}
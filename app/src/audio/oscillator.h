@@ -0,0 +1,49 @@
+#pragma once
+
+#include "wavetable.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct SweepParams {
+	enum Shape { Linear, Logarithmic };
+
+	double f0 = 20.0;
+	double f1 = 20000.0;
+	double seconds = 10.0;
+	Shape shape = Logarithmic;
+	// Start over from f0 when the sweep ends instead of holding f1.
+	bool repeat = false;
+};
+
+// Sine oscillator whose phase (kept in double precision and wrapped every buffer) carries over between buffers,
+// so that frequency changes never cause a phase jump and long runs don't lose precision.
+// All the render methods write into the channel channelIndex of an interleaved float buffer and zero the rest.
+class ToneOscillator
+{
+public:
+	void setSampleRate(uint32_t sampleRate) noexcept;
+	void resetPhase() noexcept;
+
+	// Constant frequency tone. The non-sine waveforms are band-limited (see Wavetable) and share the phase with the sine,
+	// so switching between waveforms doesn't restart the period.
+	void renderTone(float* interleavedBuffer, size_t nFrames, size_t nChannels, size_t channelIndex, double hz, Waveform waveform = Waveform::Sine, float pulseWidth = 0.5f) noexcept;
+
+	// Linear or logarithmic chirp with a sample-accurate instantaneous frequency. The phase stays continuous when a sweep starts.
+	void startSweep(const SweepParams& sweep) noexcept;
+	void renderSweep(float* interleavedBuffer, size_t nFrames, size_t nChannels, size_t channelIndex) noexcept;
+	[[nodiscard]] bool sweepFinished() const noexcept;
+
+private:
+	// Per-sample phase increment at frame n of the sweep.
+	[[nodiscard]] double sweepIncrement(uint64_t n) const noexcept;
+	void renderSweepChunk(float* chunk, size_t nFrames) noexcept;
+
+private:
+	double _phase = 0.0;
+	uint32_t _sampleRate = 48000;
+
+	SweepParams _sweep;
+	uint64_t _sweepFrame = 0;
+	uint64_t _sweepLength = 1;
+};
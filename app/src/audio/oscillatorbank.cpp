@@ -0,0 +1,197 @@
+#include "oscillatorbank.h"
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+namespace {
+
+constexpr double twoPi = 2.0 * std::numbers::pi;
+
+// The rotation recurrence is re-seeded from the double precision phase every block, same as in the tone kernel.
+constexpr size_t blockFrames = 256;
+
+[[nodiscard]] inline double wrapPhase(double phase) noexcept
+{
+	phase = std::fmod(phase, twoPi);
+	return phase < 0.0 ? phase + twoPi : phase;
+}
+
+[[nodiscard]] inline Simd::V loadLanes(const float* lanes) noexcept
+{
+	alignas(alignof(Simd::V)) float aligned[Simd::width];
+	std::memcpy(aligned, lanes, sizeof(aligned));
+	return Simd::load(aligned);
+}
+
+[[nodiscard]] inline float sumLanes(const Simd::V v) noexcept
+{
+	alignas(alignof(Simd::V)) float lanes[Simd::width];
+	Simd::store(lanes, v);
+
+	float sum = 0.0f;
+	for (const float lane : lanes)
+		sum += lane;
+	return sum;
+}
+
+} // namespace
+
+OscillatorBank::OscillatorBank(const std::vector<Oscillator>& oscillators)
+{
+	setOscillators(oscillators);
+}
+
+void OscillatorBank::setOscillators(const std::vector<Oscillator>& oscillators)
+{
+	auto sorted = oscillators;
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Oscillator& l, const Oscillator& r) {
+		return l.channelIndex < r.channelIndex;
+	});
+
+	_groups.clear();
+	_gain.clear();
+	_hz.clear();
+	_initialPhase.clear();
+	_size = sorted.size();
+
+	for (size_t i = 0; i < sorted.size(); )
+	{
+		const size_t channelIndex = sorted[i].channelIndex;
+		const size_t groupEnd = static_cast<size_t>(std::find_if(sorted.begin() + static_cast<ptrdiff_t>(i), sorted.end(), [channelIndex](const Oscillator& o) {
+			return o.channelIndex != channelIndex;
+		}) - sorted.begin());
+
+		const size_t nVectors = (groupEnd - i + Simd::width - 1) / Simd::width;
+
+		_groups.push_back({ channelIndex, _gain.size() / Simd::width, nVectors });
+		for (const size_t groupStart = i; i < groupStart + nVectors * Simd::width; ++i)
+		{
+			// The padding lanes have zero gain.
+			const bool padding = i >= groupEnd;
+			_gain.push_back(padding ? 0.0f : sorted[i].gain);
+			_hz.push_back(padding ? 0.0f : sorted[i].hz);
+			_initialPhase.push_back(padding ? 0.0 : wrapPhase(sorted[i].phase));
+		}
+
+		i = groupEnd;
+	}
+
+	_rotationCos.resize(_hz.size());
+	_rotationSin.resize(_hz.size());
+	_phaseIncrement.resize(_hz.size());
+	_phase = _initialPhase;
+
+	// Forces updateIncrements() on the next render().
+	_sampleRate = 0;
+}
+
+size_t OscillatorBank::size() const noexcept
+{
+	return _size;
+}
+
+void OscillatorBank::resetPhases() noexcept
+{
+	std::copy(_initialPhase.begin(), _initialPhase.end(), _phase.begin());
+}
+
+void OscillatorBank::updateIncrements(const uint32_t sampleRate) noexcept
+{
+	_sampleRate = sampleRate;
+	for (size_t osc = 0; osc < _hz.size(); ++osc)
+	{
+		_phaseIncrement[osc] = twoPi * static_cast<double>(_hz[osc]) / sampleRate;
+		_rotationCos[osc] = static_cast<float>(std::cos(_phaseIncrement[osc]));
+		_rotationSin[osc] = static_cast<float>(std::sin(_phaseIncrement[osc]));
+	}
+}
+
+void OscillatorBank::render(float* interleavedBuffer, const size_t nFrames, const size_t nChannels, const uint32_t sampleRate) noexcept
+{
+	assert_and_return_r(sampleRate > 0, );
+	if (sampleRate != _sampleRate)
+		updateIncrements(sampleRate);
+
+	std::memset(interleavedBuffer, 0, nFrames * nChannels * sizeof(float));
+
+	// Per-frame partial sums, one lane per oscillator of the vector; reduced to one sample per frame after the whole group has been added up.
+	Simd::V accumulator[blockFrames];
+
+	for (size_t offset = 0; offset < nFrames; offset += blockFrames)
+	{
+		const size_t n = std::min(blockFrames, nFrames - offset);
+
+		for (const ChannelGroup& group : _groups)
+		{
+			if (group.channelIndex >= nChannels)
+				continue;
+
+			std::fill_n(accumulator, n, Simd::set1(0.0f));
+
+			for (size_t v = group.firstVector; v < group.firstVector + group.nVectors; ++v)
+			{
+				float c0[Simd::width], s0[Simd::width];
+				for (size_t lane = 0; lane < Simd::width; ++lane)
+				{
+					const double phase = _phase[v * Simd::width + lane];
+					c0[lane] = static_cast<float>(std::cos(phase));
+					s0[lane] = static_cast<float>(std::sin(phase));
+				}
+
+				const auto gain = loadLanes(_gain.data() + v * Simd::width);
+				const auto cr = loadLanes(_rotationCos.data() + v * Simd::width);
+				const auto sr = loadLanes(_rotationSin.data() + v * Simd::width);
+
+				auto c = loadLanes(c0);
+				auto s = loadLanes(s0);
+				for (size_t i = 0; i < n; ++i)
+				{
+					accumulator[i] = Simd::add(accumulator[i], Simd::mul(s, gain));
+
+					const auto cNext = Simd::sub(Simd::mul(c, cr), Simd::mul(s, sr));
+					s = Simd::add(Simd::mul(s, cr), Simd::mul(c, sr));
+					c = cNext;
+				}
+			}
+
+			float* dst = interleavedBuffer + offset * nChannels + group.channelIndex;
+			for (size_t i = 0; i < n; ++i)
+				dst[i * nChannels] += sumLanes(accumulator[i]);
+		}
+
+		for (size_t osc = 0; osc < _phase.size(); ++osc)
+			_phase[osc] = wrapPhase(_phase[osc] + static_cast<double>(n) * _phaseIncrement[osc]);
+	}
+}
+
+std::vector<OscillatorBank::Oscillator> OscillatorBank::perChannelTones(const std::vector<float>& hz, const std::vector<float>& gain)
+{
+	assert_r(hz.size() == gain.size());
+
+	std::vector<Oscillator> oscillators;
+	for (size_t c = 0, n = std::min(hz.size(), gain.size()); c < n; ++c)
+		oscillators.push_back({ hz[c], gain[c], c, 0.0 });
+
+	return oscillators;
+}
+
+std::vector<OscillatorBank::Oscillator> OscillatorBank::multitone(const double f0, const double f1, const size_t nTones, const size_t channelIndex, const float peakGain)
+{
+	assert_and_return_r(nTones > 0 && f0 > 0.0 && f1 > 0.0, {});
+
+	std::vector<Oscillator> oscillators;
+	oscillators.reserve(nTones);
+	for (size_t k = 0; k < nTones; ++k)
+	{
+		const double position = nTones > 1 ? static_cast<double>(k) / static_cast<double>(nTones - 1) : 0.0;
+		const double hz = f0 * std::pow(f1 / f0, position);
+		// Schroeder phases spread the components' peaks apart; equal gains of peakGain / nTones can't add up to more than peakGain.
+		const double phase = -std::numbers::pi * static_cast<double>(k) * static_cast<double>(k + 1) / static_cast<double>(nTones);
+		oscillators.push_back({ static_cast<float>(hz), peakGain / static_cast<float>(nTones), channelIndex, phase });
+	}
+
+	return oscillators;
+}
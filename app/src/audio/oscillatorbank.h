@@ -0,0 +1,70 @@
+#pragma once
+
+#include "simd.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// A bank of sine oscillators, each with its own frequency, gain, starting phase and output channel.
+// Used for driving a different tone on every channel at once and for multitone stimuli.
+//
+// The state is kept in a structure-of-arrays layout: the oscillators are grouped by channel and every group is padded
+// to the SIMD width, so that one vector register advances Simd::width oscillators by one frame.
+// The per-oscillator cost is a complex multiplication and an accumulation per frame, plus one sin / cos pair per block of frames.
+class OscillatorBank
+{
+public:
+	struct Oscillator {
+		float hz = 1000.0f;
+		float gain = 1.0f;
+		size_t channelIndex = 0;
+		// Initial phase in radians.
+		double phase = 0.0;
+	};
+
+	OscillatorBank() = default;
+	explicit OscillatorBank(const std::vector<Oscillator>& oscillators);
+
+	// Not real-time safe, allocates.
+	void setOscillators(const std::vector<Oscillator>& oscillators);
+	[[nodiscard]] size_t size() const noexcept;
+
+	// Returns every oscillator to its initial phase.
+	void resetPhases() noexcept;
+
+	// Writes the sum of the oscillators of each channel into an interleaved float buffer.
+	// Channels without oscillators are zeroed, oscillators assigned to channels >= nChannels are advanced but not heard.
+	void render(float* interleavedBuffer, size_t nFrames, size_t nChannels, uint32_t sampleRate) noexcept;
+
+	// One oscillator per channel: hz[c] at gain[c] on channel c.
+	[[nodiscard]] static std::vector<Oscillator> perChannelTones(const std::vector<float>& hz, const std::vector<float>& gain);
+	// nTones log-spaced sines from f0 to f1 with Schroeder phases, which keep the crest factor well below that of in-phase tones. The sum never exceeds peakGain.
+	[[nodiscard]] static std::vector<Oscillator> multitone(double f0, double f1, size_t nTones, size_t channelIndex, float peakGain);
+
+private:
+	void updateIncrements(uint32_t sampleRate) noexcept;
+
+private:
+	struct ChannelGroup {
+		size_t channelIndex;
+		size_t firstVector;
+		size_t nVectors;
+	};
+
+	std::vector<ChannelGroup> _groups;
+	size_t _size = 0;
+
+	// One entry per oscillator, including the zero-gain padding. Every Simd::width consecutive entries form one vector.
+	std::vector<float> _gain;
+	std::vector<float> _rotationCos;
+	std::vector<float> _rotationSin;
+	std::vector<float> _hz;
+
+	// The block start values of the recurrence are derived from these in double precision.
+	std::vector<double> _initialPhase;
+	std::vector<double> _phase;
+	std::vector<double> _phaseIncrement;
+
+	uint32_t _sampleRate = 0;
+};
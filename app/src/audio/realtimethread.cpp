@@ -0,0 +1,169 @@
+#include "realtimethread.h"
+
+#if defined _WIN32
+#include <Windows.h>
+#include <avrt.h>
+#elif defined __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <stdint.h>
+#include <utility>
+
+// Enough for the deepest render call chain, with room to spare.
+static constexpr size_t prefaultStackBytes = 64 * 1024;
+static constexpr size_t pageSize = 4096;
+
+// Commits the stack pages the render path is going to need, so that it doesn't take a page fault the first time it goes that deep.
+static void prefaultStack() noexcept
+{
+	volatile uint8_t stack[prefaultStackBytes];
+	// Top to bottom, the way the stack grows, so that Windows' guard page is hit in order.
+	for (size_t offset = prefaultStackBytes; offset >= pageSize; offset -= pageSize)
+		stack[offset - 1] = 0;
+
+	(void)stack[0];
+}
+
+#if defined __linux__
+// High enough to preempt the desktop, low enough to leave the IRQ threads and the sound server above.
+static constexpr int fifoPriority = 70;
+#endif
+
+RealtimeThreadScope::RealtimeThreadScope(const StreamOptions& options) noexcept
+{
+#if defined _WIN32
+	if (options.cpuAffinity >= 0 && options.cpuAffinity < 64)
+		::SetThreadAffinityMask(::GetCurrentThread(), DWORD_PTR{ 1 } << options.cpuAffinity);
+
+	if (options.realtimePriority)
+	{
+		DWORD taskIndex = 0;
+		_mmcssTask = ::AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+		_bRealtime = _mmcssTask != nullptr;
+	}
+#elif defined __linux__
+	if (options.cpuAffinity >= 0 && options.cpuAffinity < CPU_SETSIZE)
+	{
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(options.cpuAffinity, &cpus);
+		::pthread_setaffinity_np(::pthread_self(), sizeof(cpus), &cpus);
+	}
+
+	if (options.realtimePriority)
+	{
+		sched_param param{};
+		::pthread_getschedparam(::pthread_self(), &_previousPolicy, &param);
+		_previousPriority = param.sched_priority;
+
+		// Unprivileged users get as much as RLIMIT_RTPRIO allows (e. g. the "audio" group's limits.conf entry), and EPERM without it.
+		int priority = std::min(fifoPriority, ::sched_get_priority_max(SCHED_FIFO));
+		if (rlimit limit{}; ::geteuid() != 0 && ::getrlimit(RLIMIT_RTPRIO, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur > 0)
+			priority = std::min(priority, static_cast<int>(limit.rlim_cur));
+
+		param.sched_priority = priority;
+		_bRealtime = ::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &param) == 0;
+	}
+#endif
+
+	if (options.lockMemory)
+		prefaultStack();
+}
+
+RealtimeThreadScope::~RealtimeThreadScope() noexcept
+{
+	if (!_bRealtime)
+		return;
+
+#if defined _WIN32
+	::AvRevertMmThreadCharacteristics(_mmcssTask);
+#elif defined __linux__
+	sched_param param{};
+	param.sched_priority = _previousPriority;
+	::pthread_setschedparam(::pthread_self(), _previousPolicy, &param);
+#endif
+}
+
+bool RealtimeThreadScope::isRealtime() const noexcept
+{
+	return _bRealtime;
+}
+
+LockedMemory::LockedMemory(const void* data, const size_t size) noexcept
+{
+	if (!data || size == 0)
+		return;
+
+#if defined _WIN32
+	void* address = const_cast<void*>(data);
+	bool bLocked = ::VirtualLock(address, size) != FALSE;
+	if (!bLocked && ::GetLastError() == ERROR_WORKING_SET_QUOTA)
+	{
+		// The default minimum working set only has room for a few hundred KB of locked pages. Grow it by this range and try again.
+		SIZE_T minWorkingSet = 0, maxWorkingSet = 0;
+		const HANDLE process = ::GetCurrentProcess();
+		const SIZE_T extra = size + 2 * pageSize;
+		if (::GetProcessWorkingSetSize(process, &minWorkingSet, &maxWorkingSet) && ::SetProcessWorkingSetSize(process, minWorkingSet + extra, maxWorkingSet + extra))
+			bLocked = ::VirtualLock(address, size) != FALSE;
+	}
+#elif defined __linux__
+	const bool bLocked = ::mlock(data, size) == 0;
+#else
+	const bool bLocked = false;
+#endif
+
+	if (bLocked)
+	{
+		_data = data;
+		_size = size;
+	}
+}
+
+LockedMemory::~LockedMemory() noexcept
+{
+	unlock();
+}
+
+LockedMemory::LockedMemory(LockedMemory&& other) noexcept :
+	_data{ std::exchange(other._data, nullptr) },
+	_size{ std::exchange(other._size, 0) }
+{
+}
+
+LockedMemory& LockedMemory::operator=(LockedMemory&& other) noexcept
+{
+	if (this != &other)
+	{
+		unlock();
+		_data = std::exchange(other._data, nullptr);
+		_size = std::exchange(other._size, 0);
+	}
+
+	return *this;
+}
+
+bool LockedMemory::isLocked() const noexcept
+{
+	return _data != nullptr;
+}
+
+void LockedMemory::unlock() noexcept
+{
+	if (!_data)
+		return;
+
+#if defined _WIN32
+	::VirtualUnlock(const_cast<void*>(_data), _size);
+#elif defined __linux__
+	::munlock(_data, _size);
+#endif
+
+	_data = nullptr;
+	_size = 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "caudiobackend.h"
+
+#include <stddef.h>
+
+// Promotes the calling render thread as StreamOptions asks: MMCSS "Pro Audio" on Windows, SCHED_FIFO on Linux, optional CPU affinity,
+// and a prefaulted stack if the memory is to be locked. Undone when destroyed, which must happen on the same thread.
+// Failing to promote is not an error: the thread carries on at the normal priority, and isRealtime() tells.
+class RealtimeThreadScope
+{
+public:
+	explicit RealtimeThreadScope(const StreamOptions& options) noexcept;
+	~RealtimeThreadScope() noexcept;
+
+	RealtimeThreadScope(const RealtimeThreadScope&) = delete;
+	RealtimeThreadScope& operator=(const RealtimeThreadScope&) = delete;
+
+	[[nodiscard]] bool isRealtime() const noexcept;
+
+private:
+	// The MMCSS task handle on Windows.
+	void* _mmcssTask = nullptr;
+	// The scheduling policy and priority to go back to on Linux.
+	int _previousPolicy = 0;
+	int _previousPriority = 0;
+	bool _bRealtime = false;
+};
+
+// Keeps a memory range page-locked (and hence faulted in) for as long as it lives, so that the render thread never page faults on it.
+// The range must outlive the lock.
+class LockedMemory
+{
+public:
+	LockedMemory() noexcept = default;
+	LockedMemory(const void* data, size_t size) noexcept;
+	~LockedMemory() noexcept;
+
+	LockedMemory(LockedMemory&& other) noexcept;
+	LockedMemory& operator=(LockedMemory&& other) noexcept;
+
+	// False if the OS has refused, e. g. the range is over RLIMIT_MEMLOCK or the working set quota.
+	[[nodiscard]] bool isLocked() const noexcept;
+
+private:
+	void unlock() noexcept;
+
+private:
+	const void* _data = nullptr;
+	size_t _size = 0;
+};
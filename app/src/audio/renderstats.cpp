@@ -0,0 +1,230 @@
+#include "renderstats.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+size_t LatencyHistogram::bucketIndex(const uint64_t value) noexcept
+{
+	if (value < subBucketCount)
+		return static_cast<size_t>(value);
+
+	// The top subBucketBits + 1 bits of the value select the bucket.
+	const unsigned int shift = static_cast<unsigned int>(std::bit_width(value)) - subBucketBits - 1;
+	const uint64_t subBucket = (value >> shift) - subBucketCount;
+	return static_cast<size_t>((shift + 1) * subBucketCount + subBucket);
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(const size_t index) noexcept
+{
+	if (index < subBucketCount)
+		return index;
+
+	const uint64_t shift = index / subBucketCount - 1;
+	return (subBucketCount + index % subBucketCount) << shift;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(const size_t index) noexcept
+{
+	if (index < subBucketCount)
+		return index;
+
+	const uint64_t shift = index / subBucketCount - 1;
+	return bucketLowerBound(index) + ((uint64_t{ 1 } << shift) - 1);
+}
+
+void LatencyHistogram::record(const uint64_t value) noexcept
+{
+	++_counts[bucketIndex(value)];
+	++_count;
+	_min = std::min(_min, value);
+	_max = std::max(_max, value);
+	_sum += static_cast<double>(value);
+}
+
+void LatencyHistogram::reset() noexcept
+{
+	*this = {};
+}
+
+uint64_t LatencyHistogram::count() const noexcept
+{
+	return _count;
+}
+
+uint64_t LatencyHistogram::min() const noexcept
+{
+	return _count > 0 ? _min : 0;
+}
+
+uint64_t LatencyHistogram::max() const noexcept
+{
+	return _max;
+}
+
+double LatencyHistogram::mean() const noexcept
+{
+	return _count > 0 ? _sum / static_cast<double>(_count) : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(const double fraction) const noexcept
+{
+	if (_count == 0)
+		return 0;
+
+	const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(_count))));
+	uint64_t cumulative = 0;
+	for (size_t i = 0; i < bucketCount; ++i)
+	{
+		cumulative += _counts[i];
+		if (cumulative >= rank)
+			return std::clamp(bucketUpperBound(i), _min, _max);
+	}
+
+	return _max;
+}
+
+void RenderStats::add(const RenderCallbackRecord& record) noexcept
+{
+	_callbackDuration.record(record.durationNs);
+	_wakeupJitter.record(static_cast<uint64_t>(std::abs(static_cast<int64_t>(record.wakeupJitterNs))));
+
+	++_callbacks;
+	if ((record.flags & RenderCallbackRecord::DeadlineMiss) != 0)
+		++_deadlineMisses;
+	if ((record.flags & RenderCallbackRecord::Underrun) != 0)
+		++_underruns;
+	if ((record.flags & RenderCallbackRecord::MonitorOverrun) != 0)
+		++_monitorOverruns;
+
+	if (record.budgetNs > 0)
+		_peakLoad = std::max(_peakLoad, static_cast<double>(record.durationNs) / record.budgetNs);
+}
+
+void RenderStats::addDroppedRecords(const uint64_t n) noexcept
+{
+	_droppedRecords += n;
+}
+
+void RenderStats::reset() noexcept
+{
+	*this = {};
+}
+
+const LatencyHistogram& RenderStats::callbackDuration() const noexcept
+{
+	return _callbackDuration;
+}
+
+const LatencyHistogram& RenderStats::wakeupJitter() const noexcept
+{
+	return _wakeupJitter;
+}
+
+uint64_t RenderStats::callbacks() const noexcept
+{
+	return _callbacks;
+}
+
+uint64_t RenderStats::deadlineMisses() const noexcept
+{
+	return _deadlineMisses;
+}
+
+uint64_t RenderStats::underruns() const noexcept
+{
+	return _underruns;
+}
+
+uint64_t RenderStats::monitorOverruns() const noexcept
+{
+	return _monitorOverruns;
+}
+
+uint64_t RenderStats::droppedRecords() const noexcept
+{
+	return _droppedRecords;
+}
+
+double RenderStats::peakLoad() const noexcept
+{
+	return _peakLoad;
+}
+
+std::string RenderStats::toCsv() const
+{
+	const std::pair<const char*, uint64_t> counters[] {
+		{ "callbacks", _callbacks },
+		{ "deadline_misses", _deadlineMisses },
+		{ "underruns", _underruns },
+		{ "monitor_overruns", _monitorOverruns },
+		{ "dropped_records", _droppedRecords }
+	};
+
+	const std::pair<const char*, const LatencyHistogram*> histograms[] {
+		{ "callback_duration", &_callbackDuration },
+		{ "wakeup_jitter", &_wakeupJitter }
+	};
+
+	std::string csv = "metric,lowest_ns,highest_ns,count\n";
+	for (const auto& [name, value] : counters)
+		csv += std::string{ name } + ",,," + std::to_string(value) + '\n';
+
+	for (const auto& [name, histogram] : histograms)
+	{
+		histogram->forEachBucket([&csv, name](uint64_t lowest, uint64_t highest, uint64_t count) {
+			csv += std::string{ name } + ',' + std::to_string(lowest) + ',' + std::to_string(highest) + ',' + std::to_string(count) + '\n';
+		});
+	}
+
+	return csv;
+}
+
+// Not std::to_string(double): its decimal separator depends on the locale.
+static std::string fixedPoint3(const double value)
+{
+	const auto thousandths = std::llround(value * 1000.0);
+	const auto fraction = std::to_string(1000 + std::llabs(thousandths) % 1000);
+	return (thousandths < 0 ? "-" : "") + std::to_string(std::llabs(thousandths) / 1000) + '.' + fraction.substr(1);
+}
+
+static std::string histogramToJson(const LatencyHistogram& histogram)
+{
+	std::string json = "{\n";
+	json += "\t\t\"count\": " + std::to_string(histogram.count()) + ",\n";
+	json += "\t\t\"min\": " + std::to_string(histogram.min()) + ",\n";
+	json += "\t\t\"max\": " + std::to_string(histogram.max()) + ",\n";
+	json += "\t\t\"mean\": " + fixedPoint3(histogram.mean()) + ",\n";
+	json += "\t\t\"p50\": " + std::to_string(histogram.percentile(0.5)) + ",\n";
+	json += "\t\t\"p90\": " + std::to_string(histogram.percentile(0.9)) + ",\n";
+	json += "\t\t\"p99\": " + std::to_string(histogram.percentile(0.99)) + ",\n";
+	json += "\t\t\"p99.9\": " + std::to_string(histogram.percentile(0.999)) + ",\n";
+	json += "\t\t\"buckets\": [";
+
+	const char* separator = "";
+	histogram.forEachBucket([&](uint64_t lowest, uint64_t highest, uint64_t count) {
+		json += separator;
+		json += '[' + std::to_string(lowest) + ", " + std::to_string(highest) + ", " + std::to_string(count) + ']';
+		separator = ", ";
+	});
+
+	json += "]\n\t}";
+	return json;
+}
+
+std::string RenderStats::toJson() const
+{
+	std::string json = "{\n";
+	json += "\t\"callbacks\": " + std::to_string(_callbacks) + ",\n";
+	json += "\t\"deadline_misses\": " + std::to_string(_deadlineMisses) + ",\n";
+	json += "\t\"underruns\": " + std::to_string(_underruns) + ",\n";
+	json += "\t\"monitor_overruns\": " + std::to_string(_monitorOverruns) + ",\n";
+	json += "\t\"dropped_records\": " + std::to_string(_droppedRecords) + ",\n";
+	json += "\t\"peak_load\": " + fixedPoint3(_peakLoad) + ",\n";
+	json += "\t\"callback_duration_ns\": " + histogramToJson(_callbackDuration) + ",\n";
+	json += "\t\"wakeup_jitter_ns\": " + histogramToJson(_wakeupJitter) + '\n';
+	json += "}\n";
+	return json;
+}
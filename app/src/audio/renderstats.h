@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// What the render thread records about every callback; see CAudioEngine::collectRenderStats().
+struct RenderCallbackRecord {
+	enum Flags : uint32_t {
+		DeadlineMiss = 1 << 0,
+		// The device has run out of data since the previous callback.
+		Underrun = 1 << 1,
+		// The monitoring tap had no room for this callback's frames.
+		MonitorOverrun = 1 << 2
+	};
+
+	// steady_clock time of the callback's start.
+	int64_t timestampNs = 0;
+	// Time spent rendering.
+	uint32_t durationNs = 0;
+	// The audio duration of the frames rendered, i.e. the time budget for rendering them.
+	uint32_t budgetNs = 0;
+	uint32_t frames = 0;
+	// Against the previous callback's start plus the duration of its audio. Positive if late.
+	int32_t wakeupJitterNs = 0;
+	uint32_t flags = 0;
+};
+
+// Log-linear histogram in the manner of HdrHistogram: values below 32 are counted exactly, above that every power of 2 is split
+// into 32 linear sub-buckets, so that any value is known to within ~3% all the way up. Fixed size, never allocates.
+class LatencyHistogram
+{
+public:
+	void record(uint64_t value) noexcept;
+	void reset() noexcept;
+
+	[[nodiscard]] uint64_t count() const noexcept;
+	[[nodiscard]] uint64_t min() const noexcept;
+	[[nodiscard]] uint64_t max() const noexcept;
+	[[nodiscard]] double mean() const noexcept;
+	// The value that the given fraction (0 to 1) of the recorded values do not exceed, to the bucket precision.
+	[[nodiscard]] uint64_t percentile(double fraction) const noexcept;
+
+	// Calls f(lowest value, highest value, count) for every non-empty bucket in ascending order.
+	template <typename F>
+	void forEachBucket(F&& f) const
+	{
+		for (size_t i = 0; i < bucketCount; ++i)
+		{
+			if (_counts[i] != 0)
+				f(bucketLowerBound(i), bucketUpperBound(i), _counts[i]);
+		}
+	}
+
+private:
+	static constexpr unsigned int subBucketBits = 5;
+	static constexpr uint64_t subBucketCount = uint64_t{ 1 } << subBucketBits;
+	static constexpr size_t bucketCount = (64 - subBucketBits + 1) * subBucketCount;
+
+	[[nodiscard]] static size_t bucketIndex(uint64_t value) noexcept;
+	[[nodiscard]] static uint64_t bucketLowerBound(size_t index) noexcept;
+	[[nodiscard]] static uint64_t bucketUpperBound(size_t index) noexcept;
+
+private:
+	std::array<uint64_t, bucketCount> _counts{};
+	uint64_t _count = 0;
+	uint64_t _min = UINT64_MAX;
+	uint64_t _max = 0;
+	double _sum = 0.0;
+};
+
+// Aggregates the render callback records on the consumer's side: callback duration and wakeup jitter histograms, glitch counters.
+class RenderStats
+{
+public:
+	void add(const RenderCallbackRecord& record) noexcept;
+	// Records the producer had to drop because nobody collected them in time.
+	void addDroppedRecords(uint64_t n) noexcept;
+	void reset() noexcept;
+
+	[[nodiscard]] const LatencyHistogram& callbackDuration() const noexcept;
+	// Absolute values, in ns.
+	[[nodiscard]] const LatencyHistogram& wakeupJitter() const noexcept;
+
+	[[nodiscard]] uint64_t callbacks() const noexcept;
+	[[nodiscard]] uint64_t deadlineMisses() const noexcept;
+	[[nodiscard]] uint64_t underruns() const noexcept;
+	[[nodiscard]] uint64_t monitorOverruns() const noexcept;
+	[[nodiscard]] uint64_t droppedRecords() const noexcept;
+	// The highest callback duration relative to its budget; 1.0 and above means the callback took longer than the audio it rendered.
+	[[nodiscard]] double peakLoad() const noexcept;
+
+	// The counters, then one line per non-empty histogram bucket. All times are in ns.
+	[[nodiscard]] std::string toCsv() const;
+	// The counters, and per histogram: count, min, max, mean, p50 / p90 / p99 / p99.9 and the buckets as [lowest, highest, count].
+	[[nodiscard]] std::string toJson() const;
+
+private:
+	LatencyHistogram _callbackDuration;
+	LatencyHistogram _wakeupJitter;
+
+	uint64_t _callbacks = 0;
+	uint64_t _deadlineMisses = 0;
+	uint64_t _underruns = 0;
+	uint64_t _monitorOverruns = 0;
+	uint64_t _droppedRecords = 0;
+	double _peakLoad = 0.0;
+};
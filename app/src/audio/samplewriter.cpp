@@ -0,0 +1,165 @@
+#include "samplewriter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+struct Float32 {
+	static constexpr size_t size = 4;
+	static constexpr double fullScale = 1.0;
+
+	static void store(uint8_t* dst, const double v) noexcept {
+		const auto sample = static_cast<float>(v);
+		std::memcpy(dst, &sample, size);
+	}
+};
+
+template <typename Integer, int bits>
+[[nodiscard]] inline Integer quantize(const double v) noexcept
+{
+	constexpr double maxValue = static_cast<double>((int64_t{ 1 } << (bits - 1)) - 1);
+	return static_cast<Integer>(std::lrint(std::clamp(v, -maxValue - 1.0, maxValue)));
+}
+
+struct Int16 {
+	static constexpr size_t size = 2;
+	static constexpr double fullScale = 32767.0;
+
+	static void store(uint8_t* dst, const double v) noexcept {
+		const auto sample = quantize<int16_t, 16>(v);
+		std::memcpy(dst, &sample, size);
+	}
+};
+
+// Packed little-endian 3-byte samples.
+struct Int24 {
+	static constexpr size_t size = 3;
+	static constexpr double fullScale = 8388607.0;
+
+	static void store(uint8_t* dst, const double v) noexcept {
+		const auto sample = quantize<int32_t, 24>(v);
+		dst[0] = static_cast<uint8_t>(sample);
+		dst[1] = static_cast<uint8_t>(sample >> 8);
+		dst[2] = static_cast<uint8_t>(sample >> 16);
+	}
+};
+
+// 24 valid bits, left-justified in a 32-bit container.
+struct Int24In32 {
+	static constexpr size_t size = 4;
+	static constexpr double fullScale = 8388607.0;
+
+	static void store(uint8_t* dst, const double v) noexcept {
+		const auto sample = static_cast<int32_t>(static_cast<uint32_t>(quantize<int32_t, 24>(v)) << 8);
+		std::memcpy(dst, &sample, size);
+	}
+};
+
+struct Int32 {
+	static constexpr size_t size = 4;
+	static constexpr double fullScale = 2147483647.0;
+
+	static void store(uint8_t* dst, const double v) noexcept {
+		const auto sample = quantize<int32_t, 32>(v);
+		std::memcpy(dst, &sample, size);
+	}
+};
+
+// Uniform in [0; 1), xorshift32.
+[[nodiscard]] inline double nextUniform(uint32_t& state) noexcept
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return static_cast<double>(state) * (1.0 / 4294967296.0);
+}
+
+template <typename Format, bool dither>
+void writeSamples(void* dst, const float* src, const size_t nSamples, uint32_t& ditherState) noexcept
+{
+	auto* out = static_cast<uint8_t*>(dst);
+	for (size_t i = 0; i < nSamples; ++i)
+	{
+		double v = static_cast<double>(src[i]) * Format::fullScale;
+		if constexpr (dither)
+			v += nextUniform(ditherState) - nextUniform(ditherState); // Triangular PDF, +-1 LSB
+
+		Format::store(out + i * Format::size, v);
+	}
+}
+
+template <typename Format>
+constexpr auto writeFunction(const bool dither) noexcept
+{
+	return dither ? &writeSamples<Format, true> : &writeSamples<Format, false>;
+}
+
+} // namespace
+
+SampleWriter::SampleType SampleWriter::sampleType(const AudioFormat& format) noexcept
+{
+	const uint16_t validBits = format.validBitsPerSample != 0 ? format.validBitsPerSample : format.bitsPerSample;
+
+	if (format.sampleFormat == AudioFormat::Float)
+		return format.bitsPerSample == 32 ? SampleType::Float32 : SampleType::Unsupported;
+	else if (format.bitsPerSample == 16)
+		return SampleType::Int16;
+	else if (format.bitsPerSample == 24)
+		return SampleType::Int24;
+	else if (format.bitsPerSample == 32)
+		return validBits == 24 ? SampleType::Int24In32 : SampleType::Int32;
+	else
+		return SampleType::Unsupported;
+}
+
+SampleWriter::SampleWriter(const AudioFormat& format, const bool dither) noexcept :
+	_type{ sampleType(format) }
+{
+	switch (_type)
+	{
+	case SampleType::Float32:
+		_write = &writeSamples<Float32, false>;
+		_bytesPerSample = Float32::size;
+		break;
+	case SampleType::Int16:
+		_write = writeFunction<Int16>(dither);
+		_bytesPerSample = Int16::size;
+		break;
+	case SampleType::Int24:
+		_write = writeFunction<Int24>(dither);
+		_bytesPerSample = Int24::size;
+		break;
+	case SampleType::Int24In32:
+		_write = writeFunction<Int24In32>(dither);
+		_bytesPerSample = Int24In32::size;
+		break;
+	case SampleType::Int32:
+		_write = writeFunction<Int32>(dither);
+		_bytesPerSample = Int32::size;
+		break;
+	case SampleType::Unsupported:
+		break;
+	}
+}
+
+bool SampleWriter::isValid() const noexcept
+{
+	return _write != nullptr;
+}
+
+bool SampleWriter::isFloat32() const noexcept
+{
+	return _type == SampleType::Float32;
+}
+
+size_t SampleWriter::bytesPerSample() const noexcept
+{
+	return _bytesPerSample;
+}
+
+void SampleWriter::write(void* dst, const float* src, const size_t nSamples) noexcept
+{
+	_write(dst, src, nSamples, _ditherState);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "audioformat.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Converts float samples in [-1; 1] to the device sample format.
+// The conversion kernel, specialized on the sample type and on whether dither is applied, is picked once per stream,
+// so the inner loop has no per-sample branching.
+class SampleWriter
+{
+public:
+	enum class SampleType { Float32, Int16, Int24, Int24In32, Int32, Unsupported };
+
+	[[nodiscard]] static SampleType sampleType(const AudioFormat& format) noexcept;
+
+	// TPDF dither of +-1 LSB is only applied to the integer formats, and only if requested.
+	explicit SampleWriter(const AudioFormat& format = {}, bool dither = false) noexcept;
+
+	[[nodiscard]] bool isValid() const noexcept;
+	// True for 32-bit float output that the generator can render into directly, bypassing the conversion.
+	[[nodiscard]] bool isFloat32() const noexcept;
+	[[nodiscard]] size_t bytesPerSample() const noexcept;
+
+	// src and dst are both interleaved; nSamples is frames * channels.
+	void write(void* dst, const float* src, size_t nSamples) noexcept;
+
+private:
+	using WriteFunction = void (*)(void* dst, const float* src, size_t nSamples, uint32_t& ditherState) noexcept;
+
+	WriteFunction _write = nullptr;
+	SampleType _type = SampleType::Unsupported;
+	size_t _bytesPerSample = 0;
+	uint32_t _ditherState = 0x9E3779B9;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+
+// A parameter change that takes effect at an exact stream position; see CAudioEngine::scheduleChanges().
+struct ScheduledChange {
+	// Generator is the engine's own: startSweep(), setOscillators() and startNoise() queue it to hand the generator they have
+	// published over to the render thread in order with the other changes.
+	enum Parameter : uint32_t { Frequency, Gain, Channel, Waveform, PulseWidth, Generator };
+
+	// Frames since playTone(); 0 for "as soon as possible".
+	uint64_t frame = 0;
+	// Hz (switches to a constant tone), linear gain, the channel index, a Waveform value or the Pulse duty cycle.
+	double value = 0.0;
+	Parameter parameter = Frequency;
+	// The caller's tag, reported back in AppliedChange; changes tagged 0 aren't reported.
+	uint32_t id = 0;
+};
+
+// What the render thread reports back about every scheduled change it has applied.
+struct AppliedChange {
+	uint32_t id = 0;
+	// The frame the change was due at, and the frame it has actually taken effect at: later if it had come too late.
+	uint64_t frame = 0;
+	uint64_t renderedFrame = 0;
+	// steady_clock time of the callback's start, plus the duration of the frames rendered before the change in that callback.
+	// The change becomes audible one output latency (LatencyInfo::outputLatencyMs) after that.
+	int64_t timestampNs = 0;
+};
@@ -0,0 +1,455 @@
+#include "sequence.h"
+#include "wavetable.h"
+
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+// Nested "repeat" blocks.
+static constexpr size_t maxLoopDepth = 16;
+
+// "2", "2s" or "2000ms".
+static bool parseDuration(const std::string& token, double& seconds)
+{
+	char* end = nullptr;
+	const double value = std::strtod(token.c_str(), &end);
+	const std::string suffix{ end };
+	if (end == token.c_str() || !std::isfinite(value) || value <= 0.0)
+		return false;
+
+	if (suffix.empty() || suffix == "s")
+		seconds = value;
+	else if (suffix == "ms")
+		seconds = value / 1000.0;
+	else
+		return false;
+
+	return true;
+}
+
+// "all" or "0,1,3".
+static bool parseChannels(const std::string& token, SequenceStep& step)
+{
+	if (token == "all")
+	{
+		step.channelMask = ~uint64_t{ 0 };
+		step.noiseOnAllChannels = true;
+		return true;
+	}
+
+	step.channelMask = 0;
+	std::istringstream list{ token };
+	for (std::string index; std::getline(list, index, ',');)
+	{
+		char* end = nullptr;
+		const unsigned long channel = std::strtoul(index.c_str(), &end, 10);
+		if (index.empty() || *end != '\0' || channel >= 64)
+			return false;
+
+		step.channelMask |= uint64_t{ 1 } << channel;
+	}
+
+	return step.channelMask != 0;
+}
+
+// The options following the step's arguments: "ch", "gain", and "waveform" for tones.
+static bool parseOptions(std::istringstream& fields, SequenceStep& step, std::string& error)
+{
+	for (std::string option; fields >> option;)
+	{
+		std::string value;
+		if (!(fields >> value))
+		{
+			error = option + " takes a value";
+			return false;
+		}
+
+		if (option == "ch")
+		{
+			if (!parseChannels(value, step))
+			{
+				error = "invalid channel list '" + value + "'";
+				return false;
+			}
+		}
+		else if (option == "gain")
+		{
+			char* end = nullptr;
+			const double db = std::strtod(value.c_str(), &end);
+			if (end == value.c_str() || *end != '\0' || !std::isfinite(db))
+			{
+				error = "gain takes a level in dBFS";
+				return false;
+			}
+
+			step.gain = static_cast<float>(std::pow(10.0, db / 20.0));
+		}
+		else if (option == "waveform" && step.type == SequenceStep::Tone)
+		{
+			const auto waveform = waveformFromName(value);
+			if (!waveform)
+			{
+				error = "unknown waveform '" + value + "'";
+				return false;
+			}
+
+			step.waveform = *waveform;
+		}
+		else
+		{
+			error = "unexpected '" + option + "'";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool parseStep(const std::string& command, std::istringstream& fields, SequenceStep& step, std::string& error)
+{
+	std::string duration;
+	if (command == "tone")
+	{
+		step.type = SequenceStep::Tone;
+		if (!(fields >> step.hz >> duration) || step.hz <= 0.0)
+		{
+			error = "tone takes a frequency and a duration";
+			return false;
+		}
+	}
+	else if (command == "sweep")
+	{
+		step.type = SequenceStep::Sweep;
+		if (!(fields >> step.sweep.f0 >> step.sweep.f1 >> duration) || step.sweep.f0 <= 0.0 || step.sweep.f1 <= 0.0)
+		{
+			error = "sweep takes two frequencies and a duration";
+			return false;
+		}
+
+		step.sweep.shape = SweepParams::Logarithmic;
+		if (const auto shape = (fields >> std::ws).peek(); shape == 'l')
+		{
+			std::string name;
+			fields >> name;
+			if (name != "lin" && name != "log")
+			{
+				error = "unexpected '" + name + "'";
+				return false;
+			}
+
+			step.sweep.shape = name == "lin" ? SweepParams::Linear : SweepParams::Logarithmic;
+		}
+	}
+	else if (command == "noise")
+	{
+		step.type = SequenceStep::Noise;
+		std::string type;
+		fields >> type;
+		if (type == "white")
+			step.noise.type = NoiseParams::White;
+		else if (type == "pink")
+			step.noise.type = NoiseParams::Pink;
+		else if (type == "band")
+		{
+			step.noise.type = NoiseParams::BandLimited;
+			if (!(fields >> step.noise.lowHz >> step.noise.highHz) || step.noise.lowHz <= 0.0 || step.noise.highHz <= step.noise.lowHz)
+			{
+				error = "band noise takes the low and high cutoff frequencies";
+				return false;
+			}
+		}
+		else
+		{
+			error = "noise takes white, pink or band";
+			return false;
+		}
+
+		fields >> duration;
+	}
+	else if (command == "silence")
+	{
+		step.type = SequenceStep::Silence;
+		fields >> duration;
+	}
+	else
+	{
+		error = "unknown step '" + command + "'";
+		return false;
+	}
+
+	if (!parseDuration(duration, step.seconds))
+	{
+		error = "invalid duration '" + duration + "'";
+		return false;
+	}
+
+	step.sweep.seconds = step.seconds;
+	return parseOptions(fields, step, error);
+}
+
+std::shared_ptr<Sequence> Sequence::compile(const std::string& source, std::string& error)
+{
+	std::vector<SequenceStep> steps;
+	// The open loops: the index of the LoopStart step and the duration of the steps since then.
+	struct OpenLoop {
+		size_t start;
+		double seconds;
+	};
+	std::vector<OpenLoop> openLoops;
+	uint32_t nLoops = 0;
+	double seconds = 0.0;
+
+	std::istringstream lines{ source };
+	std::string line;
+	for (uint32_t lineNumber = 1; std::getline(lines, line); ++lineNumber)
+	{
+		if (const auto comment = line.find('#'); comment != std::string::npos)
+			line.erase(comment);
+
+		std::istringstream fields{ line };
+		std::string command;
+		if (!(fields >> command))
+			continue;
+
+		const auto fail = [&](const std::string& message) {
+			error = "line " + std::to_string(lineNumber) + ": " + message;
+			return nullptr;
+		};
+
+		SequenceStep step;
+		step.line = lineNumber;
+		if (command == "repeat")
+		{
+			step.type = SequenceStep::LoopStart;
+			if (!(fields >> std::ws).eof() && (!(fields >> step.count) || step.count == 0))
+				return fail("repeat takes a positive count, or none for an endless loop");
+			if (openLoops.size() == maxLoopDepth)
+				return fail("too many nested loops");
+
+			step.loopIndex = nLoops++;
+			openLoops.push_back({ steps.size(), 0.0 });
+		}
+		else if (command == "end")
+		{
+			if (openLoops.empty())
+				return fail("end without repeat");
+
+			const OpenLoop loop = openLoops.back();
+			openLoops.pop_back();
+			// An endless loop with nothing to play would never let the render thread out.
+			if (loop.seconds == 0.0)
+				return fail("empty loop");
+
+			step.type = SequenceStep::LoopEnd;
+			step.loopStart = loop.start;
+			step.loopIndex = steps[loop.start].loopIndex;
+
+			const uint32_t count = steps[loop.start].count;
+			const double loopSeconds = loop.seconds * std::max(count, 1u);
+			if (openLoops.empty())
+				seconds += loopSeconds;
+			else
+				openLoops.back().seconds += loopSeconds;
+		}
+		else
+		{
+			std::string message;
+			if (!parseStep(command, fields, step, message))
+				return fail(message);
+
+			if (openLoops.empty())
+				seconds += step.seconds;
+			else
+				openLoops.back().seconds += step.seconds;
+		}
+
+		if (step.type == SequenceStep::LoopStart || step.type == SequenceStep::LoopEnd)
+		{
+			std::string unexpected;
+			if (fields >> unexpected)
+				return fail("unexpected '" + unexpected + "'");
+		}
+
+		steps.push_back(step);
+	}
+
+	if (!openLoops.empty())
+	{
+		error = "line " + std::to_string(steps[openLoops.back().start].line) + ": repeat without end";
+		return nullptr;
+	}
+
+	if (seconds == 0.0)
+	{
+		error = "the sequence is empty";
+		return nullptr;
+	}
+
+	// Built here rather than on the render thread the first time a step needs them.
+	for (const SequenceStep& step : steps)
+	{
+		if (step.type == SequenceStep::Tone && step.waveform != Waveform::Sine)
+			(void)Wavetable::get(step.waveform);
+	}
+
+	return std::shared_ptr<Sequence>{ new Sequence{ std::move(steps), nLoops, seconds } };
+}
+
+std::shared_ptr<Sequence> Sequence::load(const std::string& filePath, std::string& error)
+{
+	std::ifstream file{ filePath };
+	if (!file.is_open())
+	{
+		error = "Failed to open " + filePath;
+		return nullptr;
+	}
+
+	std::ostringstream source;
+	source << file.rdbuf();
+	return compile(source.str(), error);
+}
+
+Sequence::Sequence(std::vector<SequenceStep> steps, const uint32_t nLoops, const double seconds) :
+	_steps{ std::move(steps) },
+	_loopCounters(nLoops, 0),
+	_seconds{ seconds }
+{
+}
+
+const std::vector<SequenceStep>& Sequence::steps() const noexcept
+{
+	return _steps;
+}
+
+double Sequence::seconds() const noexcept
+{
+	return _seconds;
+}
+
+void Sequence::rewind() noexcept
+{
+	_step = 0;
+	_stepFramesLeft = 0;
+	_bStarted = false;
+	_currentLine = 0;
+	_bFinished = false;
+}
+
+void Sequence::render(float* interleavedBuffer, size_t nFrames, const size_t nChannels, const uint32_t sampleRate, ToneOscillator& oscillator, NoiseGenerator& noise) noexcept
+{
+	while (nFrames > 0)
+	{
+		if (_stepFramesLeft == 0 && !enterNextStep(sampleRate, oscillator, noise))
+		{
+			std::fill_n(interleavedBuffer, nFrames * nChannels, 0.0f);
+			return;
+		}
+
+		const size_t n = static_cast<size_t>(std::min<uint64_t>(nFrames, _stepFramesLeft));
+		renderStep(_steps[_step], interleavedBuffer, n, nChannels, oscillator, noise);
+
+		interleavedBuffer += n * nChannels;
+		nFrames -= n;
+		_stepFramesLeft -= n;
+	}
+}
+
+uint32_t Sequence::currentLine() const noexcept
+{
+	return _currentLine.load(std::memory_order_relaxed);
+}
+
+bool Sequence::finished() const noexcept
+{
+	return _bFinished.load(std::memory_order_relaxed);
+}
+
+bool Sequence::enterNextStep(const uint32_t sampleRate, ToneOscillator& oscillator, NoiseGenerator& noise) noexcept
+{
+	for (size_t i = _bStarted ? _step + 1 : 0; i < _steps.size();)
+	{
+		const SequenceStep& step = _steps[i];
+		if (step.type == SequenceStep::LoopStart)
+		{
+			_loopCounters[step.loopIndex] = step.count;
+			++i;
+		}
+		else if (step.type == SequenceStep::LoopEnd)
+		{
+			// The compiler makes sure every loop has something to play, so this never spins.
+			uint32_t& passesLeft = _loopCounters[step.loopIndex];
+			if (_steps[step.loopStart].count == 0 || --passesLeft > 0)
+				i = step.loopStart + 1;
+			else
+				++i;
+		}
+		else
+		{
+			_step = i;
+			_bStarted = true;
+			// At least one frame, so that every step is heard however short and the walk always moves on.
+			_stepFramesLeft = std::max<uint64_t>(std::llround(step.seconds * sampleRate), 1);
+
+			if (step.type == SequenceStep::Sweep)
+				oscillator.startSweep(step.sweep);
+			else if (step.type == SequenceStep::Noise)
+				noise.setParams(step.noise);
+
+			_currentLine.store(step.line, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	_bStarted = true;
+	_step = _steps.size();
+	_bFinished.store(true, std::memory_order_relaxed);
+	return false;
+}
+
+void Sequence::renderStep(const SequenceStep& step, float* interleavedBuffer, const size_t nFrames, const size_t nChannels, ToneOscillator& oscillator, NoiseGenerator& noise) const noexcept
+{
+	const uint64_t mask = nChannels >= 64 ? step.channelMask : step.channelMask & ((uint64_t{ 1 } << nChannels) - 1);
+	if (step.type == SequenceStep::Silence || mask == 0)
+	{
+		std::fill_n(interleavedBuffer, nFrames * nChannels, 0.0f);
+		return;
+	}
+
+	// The lowest channel of the mask.
+	size_t first = 0;
+	while ((mask & (uint64_t{ 1 } << first)) == 0)
+		++first;
+
+	if (step.type == SequenceStep::Noise && step.noiseOnAllChannels)
+	{
+		noise.render(interleavedBuffer, nFrames, nChannels, NoiseGenerator::allChannels);
+		if (step.gain != 1.0f)
+		{
+			for (size_t i = 0, n = nFrames * nChannels; i < n; ++i)
+				interleavedBuffer[i] *= step.gain;
+		}
+		return;
+	}
+
+	if (step.type == SequenceStep::Tone)
+		oscillator.renderTone(interleavedBuffer, nFrames, nChannels, first, step.hz, step.waveform, step.pulseWidth);
+	else if (step.type == SequenceStep::Sweep)
+		oscillator.renderSweep(interleavedBuffer, nFrames, nChannels, first);
+	else
+		noise.render(interleavedBuffer, nFrames, nChannels, first);
+
+	const uint64_t others = mask & ~(uint64_t{ 1 } << first);
+	for (size_t frame = 0; frame < nFrames; ++frame)
+	{
+		float* samples = interleavedBuffer + frame * nChannels;
+		samples[first] *= step.gain;
+		for (size_t c = first + 1; c < nChannels; ++c)
+		{
+			if ((others & (uint64_t{ 1 } << c)) != 0)
+				samples[c] = samples[first];
+		}
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "noise.h"
+#include "oscillator.h"
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// One step of a compiled sequence. Audio steps play for their duration; loop markers take no time.
+struct SequenceStep {
+	enum Type : uint8_t { Tone, Sweep, Noise, Silence, LoopStart, LoopEnd };
+
+	Type type = Silence;
+	// The source line, for progress reporting.
+	uint32_t line = 0;
+
+	// Audio steps.
+	double seconds = 0.0;
+	// The signal is rendered on the lowest channel of the mask and copied to the rest; bits past the device's channel count are ignored.
+	uint64_t channelMask = 1;
+	// Noise only: an independent stream on every channel of the device rather than copies of one.
+	bool noiseOnAllChannels = false;
+	float gain = 1.0f;
+
+	// Tone
+	double hz = 1000.0;
+	Waveform waveform = Waveform::Sine;
+	float pulseWidth = 0.5f;
+	// Sweep
+	SweepParams sweep;
+	// Noise
+	NoiseParams noise;
+
+	// LoopStart: the number of passes, 0 for an endless loop. LoopEnd: the index of its LoopStart.
+	uint32_t count = 0;
+	size_t loopStart = 0;
+	// Both: the loop's counter.
+	uint32_t loopIndex = 0;
+};
+
+// A calibration procedure compiled ahead of time into a flat array of steps, played back to back with no gaps: one sample after
+// the last frame of a step comes the first frame of the next, and the tone phase carries over.
+// Built on the control thread; only the render thread walks it, with no parsing or allocation.
+//
+// The source has one step per line, '#' starts a comment:
+//   tone <Hz> <duration> [ch <channels>] [waveform <name>] [gain <dBFS>]
+//   sweep <f0 Hz> <f1 Hz> <duration> [lin|log] [ch <channels>] [gain <dBFS>]
+//   noise white|pink|band <low Hz> <high Hz> <duration> [ch <channels>] [gain <dBFS>]
+//   silence <duration>
+//   repeat [count]                 Repeats the steps up to the matching "end" count times, or endlessly.
+//   end
+// A duration is in seconds, or in ms with the "ms" suffix ("2s" and "2" are the same). Channels are a comma-separated list
+// of indices ("0,1,3") or "all", channel 0 by default. Noise on "all" channels is an independent stream per channel.
+//
+// Example - 1 kHz on each of the two channels for 2 s, then a sweep, then pink noise, all of it three times over:
+//   repeat 3
+//     tone 1000 2s ch 0
+//     tone 1000 2s ch 1
+//     sweep 20 20000 10s log ch all
+//     noise pink 5s ch all gain -6
+//   end
+class Sequence
+{
+public:
+	// Returns nullptr, with the message in error, if the source doesn't compile. Also builds the wavetables of the waveforms the steps use.
+	[[nodiscard]] static std::shared_ptr<Sequence> compile(const std::string& source, std::string& error);
+	[[nodiscard]] static std::shared_ptr<Sequence> load(const std::string& filePath, std::string& error);
+
+	[[nodiscard]] const std::vector<SequenceStep>& steps() const noexcept;
+	// The total duration of one pass, not counting the endless loops more than once.
+	[[nodiscard]] double seconds() const noexcept;
+
+	// Back to the first step. Called by the thread that renders the sequence.
+	void rewind() noexcept;
+	// Renders the next nFrames into an interleaved float buffer, silence past the end. Drives the tone oscillator and the noise
+	// generator it's given (prepared for nChannels at sampleRate), so that the phase carries over from whatever has played before.
+	void render(float* interleavedBuffer, size_t nFrames, size_t nChannels, uint32_t sampleRate, ToneOscillator& oscillator, NoiseGenerator& noise) noexcept;
+
+	// The source line of the step being played, 0 before the first one. Any thread.
+	[[nodiscard]] uint32_t currentLine() const noexcept;
+	[[nodiscard]] bool finished() const noexcept;
+
+private:
+	Sequence(std::vector<SequenceStep> steps, uint32_t nLoops, double seconds);
+
+	// Moves on to the next audio step, running the loop markers on the way; false at the end.
+	bool enterNextStep(uint32_t sampleRate, ToneOscillator& oscillator, NoiseGenerator& noise) noexcept;
+	void renderStep(const SequenceStep& step, float* interleavedBuffer, size_t nFrames, size_t nChannels, ToneOscillator& oscillator, NoiseGenerator& noise) const noexcept;
+
+private:
+	const std::vector<SequenceStep> _steps;
+	// One per loop, sized by the compiler.
+	std::vector<uint32_t> _loopCounters;
+	const double _seconds;
+
+	// The step being played (valid once _bStarted) and its frames still to go.
+	size_t _step = 0;
+	uint64_t _stepFramesLeft = 0;
+	bool _bStarted = false;
+
+	std::atomic<uint32_t> _currentLine = 0;
+	std::atomic_bool _bFinished = false;
+};
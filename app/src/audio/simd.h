@@ -0,0 +1,77 @@
+#pragma once
+
+// The widest float vector type available at compile time, with the handful of operations the signal generators need.
+// load() and store() require the pointer to be aligned to alignof(Simd::V).
+
+#include <cstring>
+#include <stddef.h>
+
+#if defined(__AVX2__) || defined(__AVX__)
+	#include <immintrin.h>
+	#define AUDIO_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define AUDIO_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+	#include <arm_neon.h>
+	#define AUDIO_SIMD_NEON
+#endif
+
+#if defined(AUDIO_SIMD_AVX)
+
+struct Simd {
+	using V = __m256;
+	static constexpr size_t width = 8;
+
+	static V set1(float v) noexcept { return _mm256_set1_ps(v); }
+	static V load(const float* p) noexcept { return _mm256_load_ps(p); }
+	static void store(float* p, V v) noexcept { _mm256_store_ps(p, v); }
+	static V add(V a, V b) noexcept { return _mm256_add_ps(a, b); }
+	static V sub(V a, V b) noexcept { return _mm256_sub_ps(a, b); }
+	static V mul(V a, V b) noexcept { return _mm256_mul_ps(a, b); }
+};
+
+#elif defined(AUDIO_SIMD_SSE2)
+
+struct Simd {
+	using V = __m128;
+	static constexpr size_t width = 4;
+
+	static V set1(float v) noexcept { return _mm_set1_ps(v); }
+	static V load(const float* p) noexcept { return _mm_load_ps(p); }
+	static void store(float* p, V v) noexcept { _mm_store_ps(p, v); }
+	static V add(V a, V b) noexcept { return _mm_add_ps(a, b); }
+	static V sub(V a, V b) noexcept { return _mm_sub_ps(a, b); }
+	static V mul(V a, V b) noexcept { return _mm_mul_ps(a, b); }
+};
+
+#elif defined(AUDIO_SIMD_NEON)
+
+struct Simd {
+	using V = float32x4_t;
+	static constexpr size_t width = 4;
+
+	static V set1(float v) noexcept { return vdupq_n_f32(v); }
+	static V load(const float* p) noexcept { return vld1q_f32(p); }
+	static void store(float* p, V v) noexcept { vst1q_f32(p, v); }
+	static V add(V a, V b) noexcept { return vaddq_f32(a, b); }
+	static V sub(V a, V b) noexcept { return vsubq_f32(a, b); }
+	static V mul(V a, V b) noexcept { return vmulq_f32(a, b); }
+};
+
+#else
+
+// Plain arrays - the compiler is free to auto-vectorize these.
+struct Simd {
+	static constexpr size_t width = 4;
+	struct V { float v[width]; };
+
+	static V set1(float x) noexcept { V r; for (auto& e : r.v) e = x; return r; }
+	static V load(const float* p) noexcept { V r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+	static void store(float* p, V v) noexcept { std::memcpy(p, v.v, sizeof(v.v)); }
+	static V add(V a, V b) noexcept { for (size_t i = 0; i < width; ++i) a.v[i] += b.v[i]; return a; }
+	static V sub(V a, V b) noexcept { for (size_t i = 0; i < width; ++i) a.v[i] -= b.v[i]; return a; }
+	static V mul(V a, V b) noexcept { for (size_t i = 0; i < width; ++i) a.v[i] *= b.v[i]; return a; }
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "spectrumanalyzer.h"
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+static constexpr double bandLowHz = 20.0;
+static constexpr double bandHighHz = 20'000.0;
+// The Blackman-Harris main lobe is 4 bins either side of the peak; one more for where the peak falls between two bins.
+static constexpr size_t fundamentalHalfWidthBins = 5;
+static constexpr double fundamentalSearchRatio = 0.02;
+
+[[nodiscard]] static double toDb(const double powerRatio) noexcept
+{
+	return powerRatio > 1e-20 ? 10.0 * std::log10(powerRatio) : -200.0;
+}
+
+void SpectrumAnalyzer::reset(const size_t fftSize, const uint32_t sampleRate, const size_t averages)
+{
+	assert_and_return_r(sampleRate > 0, );
+
+	_fft.reset(fftSize);
+	_sampleRate = sampleRate;
+	_averages = std::max<size_t>(averages, 1);
+
+	// 4-term Blackman-Harris.
+	_window.resize(fftSize);
+	double sumOfSquares = 0.0;
+	for (size_t n = 0; n < fftSize; ++n)
+	{
+		const double x = 2.0 * std::numbers::pi * static_cast<double>(n) / static_cast<double>(fftSize);
+		const double w = 0.35875 - 0.48829 * std::cos(x) + 0.14128 * std::cos(2.0 * x) - 0.01168 * std::cos(3.0 * x);
+		_window[n] = static_cast<float>(w);
+		sumOfSquares += w * w;
+	}
+
+	// The one-sided spectrum holds half of the power of every bin other than DC and Nyquist.
+	_powerScale = static_cast<float>(2.0 / (static_cast<double>(fftSize) * sumOfSquares));
+
+	_input.assign(fftSize, 0.0f);
+	_inputLength = 0;
+	_windowed.assign(fftSize, 0.0f);
+	_re.assign(fftSize / 2 + 1, 0.0f);
+	_im.assign(fftSize / 2 + 1, 0.0f);
+	_power.assign(fftSize / 2 + 1, 0.0f);
+	_frames = 0;
+}
+
+bool SpectrumAnalyzer::process(const float* frames, const size_t nFrames, const size_t nChannels, const size_t channel) noexcept
+{
+	assert_and_return_r(channel < nChannels, false);
+
+	const size_t fftSize = _input.size();
+	const size_t hop = fftSize / 2;
+	bool bNewFrame = false;
+
+	for (size_t i = 0; i < nFrames; )
+	{
+		const size_t n = std::min(nFrames - i, fftSize - _inputLength);
+		for (size_t k = 0; k < n; ++k)
+			_input[_inputLength + k] = frames[(i + k) * nChannels + channel];
+
+		_inputLength += n;
+		i += n;
+
+		if (_inputLength == fftSize)
+		{
+			analyseFrame();
+			bNewFrame = true;
+
+			std::memmove(_input.data(), _input.data() + hop, (fftSize - hop) * sizeof(float));
+			_inputLength = fftSize - hop;
+		}
+	}
+
+	return bNewFrame;
+}
+
+SpectrumMeasurement SpectrumAnalyzer::measure(const double fundamentalHz) const noexcept
+{
+	SpectrumMeasurement m;
+	m.frames = _frames;
+	if (_frames == 0)
+		return m;
+
+	const double hzPerBin = binWidth();
+	const size_t lastBin = _power.size() - 1;
+	const size_t bandLow = std::max<size_t>(static_cast<size_t>(std::ceil(bandLowHz / hzPerBin)), 1);
+	const size_t bandHigh = std::min(static_cast<size_t>(bandHighHz / hzPerBin), lastBin);
+	if (bandLow >= bandHigh)
+		return m;
+
+	size_t searchLow = bandLow, searchHigh = bandHigh;
+	if (fundamentalHz > 0.0)
+	{
+		const double halfWidthHz = std::max(fundamentalHz * fundamentalSearchRatio, 2.0 * hzPerBin);
+		searchLow = std::clamp(static_cast<size_t>(std::max(fundamentalHz - halfWidthHz, 0.0) / hzPerBin), bandLow, bandHigh);
+		searchHigh = std::clamp(static_cast<size_t>((fundamentalHz + halfWidthHz) / hzPerBin + 1.0), bandLow, bandHigh);
+	}
+
+	const size_t peak = static_cast<size_t>(std::max_element(_power.begin() + static_cast<ptrdiff_t>(searchLow), _power.begin() + static_cast<ptrdiff_t>(searchHigh) + 1) - _power.begin());
+	const size_t fundamentalLow = std::max(peak > fundamentalHalfWidthBins ? peak - fundamentalHalfWidthBins : 0, bandLow);
+	const size_t fundamentalHigh = std::min(peak + fundamentalHalfWidthBins, bandHigh);
+
+	double total = 0.0, fundamental = 0.0, weightedBins = 0.0;
+	for (size_t k = bandLow; k <= bandHigh; ++k)
+	{
+		const double p = _power[k];
+		total += p;
+		if (k >= fundamentalLow && k <= fundamentalHigh)
+		{
+			fundamental += p;
+			weightedBins += p * static_cast<double>(k);
+		}
+	}
+
+	const double residual = std::max(total - fundamental, 0.0);
+	m.fundamentalHz = fundamental > 0.0 ? weightedBins / fundamental * hzPerBin : 0.0;
+	m.levelDbfs = toDb(2.0 * fundamental);
+	m.totalDbfs = toDb(2.0 * total);
+	if (total > 0.0)
+	{
+		m.thdNDb = toDb(residual / total);
+		m.thdNPercent = 100.0 * std::sqrt(residual / total);
+	}
+
+	return m;
+}
+
+const std::vector<float>& SpectrumAnalyzer::powerSpectrum() const noexcept
+{
+	return _power;
+}
+
+double SpectrumAnalyzer::binWidth() const noexcept
+{
+	return _fft.size() > 0 ? static_cast<double>(_sampleRate) / static_cast<double>(_fft.size()) : 0.0;
+}
+
+void SpectrumAnalyzer::analyseFrame() noexcept
+{
+	const size_t fftSize = _input.size();
+	for (size_t n = 0; n < fftSize; ++n)
+		_windowed[n] = _input[n] * _window[n];
+
+	_fft.transform(_windowed.data(), _re.data(), _im.data());
+
+	++_frames;
+	// A plain mean until there are enough frames, so that the first reading isn't dragged down by the zeros it started from.
+	const float weight = 1.0f / static_cast<float>(std::min<uint64_t>(_frames, _averages));
+	const size_t lastBin = _power.size() - 1;
+	for (size_t k = 0; k <= lastBin; ++k)
+	{
+		float p = (_re[k] * _re[k] + _im[k] * _im[k]) * _powerScale;
+		if (k == 0 || k == lastBin)
+			p *= 0.5f;
+
+		_power[k] += (p - _power[k]) * weight;
+	}
+}
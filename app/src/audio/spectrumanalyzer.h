@@ -0,0 +1,63 @@
+#pragma once
+#include "fft.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+struct SpectrumMeasurement {
+	// The power-weighted centre of the fundamental's bins, finer than the bin width.
+	double fundamentalHz = 0.0;
+	// dBFS, a full-scale sine being 0 dBFS.
+	double levelDbfs = -200.0;
+	// Everything in the 20 Hz - 20 kHz band (or up to Nyquist).
+	double totalDbfs = -200.0;
+	// Everything in the band other than the fundamental, relative to the total.
+	double thdNDb = 0.0;
+	double thdNPercent = 0.0;
+	// FFT frames since reset().
+	uint64_t frames = 0;
+};
+
+// Streaming power spectrum of one channel: Blackman-Harris windowed FFT frames overlapping by half, averaged exponentially.
+// The window's sidelobes are below -92 dB, so the leakage of the fundamental doesn't mask the distortion.
+// Everything is allocated by reset(), process() and measure() never allocate.
+class SpectrumAnalyzer
+{
+public:
+	// fftSize is a power of 2. The spectrum is the mean of the first `averages` frames, then a moving average with that time constant.
+	void reset(size_t fftSize, uint32_t sampleRate, size_t averages);
+
+	// Takes one channel out of nFrames interleaved frames. Returns true if at least one new frame has been added to the average.
+	bool process(const float* frames, size_t nFrames, size_t nChannels, size_t channel) noexcept;
+
+	// The level of the fundamental and THD+N. The fundamental is the strongest component within 2% of fundamentalHz,
+	// or the strongest in the band if fundamentalHz is 0.
+	[[nodiscard]] SpectrumMeasurement measure(double fundamentalHz) const noexcept;
+
+	// Averaged mean-square value per bin, from DC up to Nyquist; the bins of a sine add up to half its amplitude squared.
+	[[nodiscard]] const std::vector<float>& powerSpectrum() const noexcept;
+	[[nodiscard]] double binWidth() const noexcept;
+
+private:
+	void analyseFrame() noexcept;
+
+private:
+	RealFft _fft;
+	uint32_t _sampleRate = 0;
+	size_t _averages = 1;
+
+	std::vector<float> _window;
+	// Normalizes |X|^2 to the mean-square value, see powerSpectrum().
+	float _powerScale = 0.0f;
+
+	// The samples of the frame being filled; the second half of every frame is the first half of the next one.
+	std::vector<float> _input;
+	size_t _inputLength = 0;
+
+	std::vector<float> _windowed;
+	std::vector<float> _re;
+	std::vector<float> _im;
+	std::vector<float> _power;
+	uint64_t _frames = 0;
+};
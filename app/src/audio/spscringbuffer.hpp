@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stddef.h>
+#include <type_traits>
+#include <vector>
+
+// Bounded lock-free single-producer / single-consumer queue of trivially copyable items.
+// Storage is allocated by reset() only; push and pop never allocate, lock or block.
+template <typename T>
+class SpscRingBuffer
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+	// Not thread-safe: must be called while neither side is active. The capacity is rounded up to a power of 2.
+	void reset(const size_t minCapacity)
+	{
+		size_t capacity = 1;
+		while (capacity < minCapacity)
+			capacity <<= 1;
+
+		_storage.assign(capacity, T{});
+		_mask = capacity - 1;
+		_writeIndex.store(0, std::memory_order_relaxed);
+		_readIndex.store(0, std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] size_t capacity() const noexcept {
+		return _storage.size();
+	}
+
+	// The storage allocated by reset(), e. g. for page-locking it.
+	[[nodiscard]] const T* data() const noexcept {
+		return _storage.data();
+	}
+
+	// Producer side. Writes all n items or nothing.
+	bool push(const T* items, const size_t n) noexcept
+	{
+		const size_t write = _writeIndex.load(std::memory_order_relaxed);
+		const size_t read = _readIndex.load(std::memory_order_acquire);
+		if (capacity() - (write - read) < n)
+			return false;
+
+		copyIn(write, items, n);
+		_writeIndex.store(write + n, std::memory_order_release);
+		return true;
+	}
+
+	[[nodiscard]] size_t freeSpace() const noexcept
+	{
+		return capacity() - (_writeIndex.load(std::memory_order_relaxed) - _readIndex.load(std::memory_order_acquire));
+	}
+
+	// Consumer side.
+	[[nodiscard]] size_t available() const noexcept
+	{
+		return _writeIndex.load(std::memory_order_acquire) - _readIndex.load(std::memory_order_relaxed);
+	}
+
+	size_t pop(T* items, size_t n) noexcept
+	{
+		const size_t read = _readIndex.load(std::memory_order_relaxed);
+		n = std::min(n, _writeIndex.load(std::memory_order_acquire) - read);
+
+		copyOut(read, items, n);
+		_readIndex.store(read + n, std::memory_order_release);
+		return n;
+	}
+
+	size_t skip(size_t n) noexcept
+	{
+		const size_t read = _readIndex.load(std::memory_order_relaxed);
+		n = std::min(n, _writeIndex.load(std::memory_order_acquire) - read);
+		_readIndex.store(read + n, std::memory_order_release);
+		return n;
+	}
+
+private:
+	void copyIn(const size_t index, const T* items, const size_t n) noexcept
+	{
+		const size_t offset = index & _mask;
+		const size_t firstPart = std::min(n, capacity() - offset);
+		std::memcpy(_storage.data() + offset, items, firstPart * sizeof(T));
+		std::memcpy(_storage.data(), items + firstPart, (n - firstPart) * sizeof(T));
+	}
+
+	void copyOut(const size_t index, T* items, const size_t n) const noexcept
+	{
+		const size_t offset = index & _mask;
+		const size_t firstPart = std::min(n, capacity() - offset);
+		std::memcpy(items, _storage.data() + offset, firstPart * sizeof(T));
+		std::memcpy(items + firstPart, _storage.data(), (n - firstPart) * sizeof(T));
+	}
+
+private:
+	std::vector<T> _storage;
+	size_t _mask = 0;
+
+	// Monotonic counters, wrapped with _mask on access.
+	alignas(64) std::atomic<size_t> _writeIndex = 0;
+	alignas(64) std::atomic<size_t> _readIndex = 0;
+};
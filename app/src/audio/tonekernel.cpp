@@ -0,0 +1,93 @@
+#include "tonekernel.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+namespace {
+
+constexpr double twoPi = 2.0 * std::numbers::pi;
+
+// The recurrence accumulates roughly one float epsilon of error per step; re-seeding every chunk keeps it below -100 dB.
+constexpr size_t chunkSize = 256;
+static_assert(chunkSize % Simd::width == 0);
+
+[[nodiscard]] inline double wrapPhase(double phase) noexcept
+{
+	phase = std::fmod(phase, twoPi);
+	return phase < 0.0 ? phase + twoPi : phase;
+}
+
+// Fills the whole chunk (a multiple of the vector width), the caller uses as many frames as it needs.
+void renderChunk(float* chunk, const size_t nFrames, const double phase, const double phaseIncrement) noexcept
+{
+	alignas(32) float c0[Simd::width], s0[Simd::width];
+	for (size_t k = 0; k < Simd::width; ++k)
+	{
+		const double angle = phase + static_cast<double>(k) * phaseIncrement;
+		c0[k] = static_cast<float>(std::cos(angle));
+		s0[k] = static_cast<float>(std::sin(angle));
+	}
+
+	// Every lane advances by Simd::width frames per step.
+	const double step = static_cast<double>(Simd::width) * phaseIncrement;
+	const auto cr = Simd::set1(static_cast<float>(std::cos(step)));
+	const auto sr = Simd::set1(static_cast<float>(std::sin(step)));
+
+	auto c = Simd::load(c0);
+	auto s = Simd::load(s0);
+	for (size_t i = 0; i < nFrames; i += Simd::width)
+	{
+		Simd::store(chunk + i, s);
+
+		const auto cNext = Simd::sub(Simd::mul(c, cr), Simd::mul(s, sr));
+		s = Simd::add(Simd::mul(s, cr), Simd::mul(c, sr));
+		c = cNext;
+	}
+}
+
+template <typename Sink>
+double render(const size_t nFrames, double phase, const double phaseIncrement, Sink&& sink) noexcept
+{
+	alignas(32) float chunk[chunkSize];
+
+	phase = wrapPhase(phase);
+	for (size_t offset = 0; offset < nFrames; offset += chunkSize)
+	{
+		const size_t n = std::min(chunkSize, nFrames - offset);
+		const size_t nAligned = (n + Simd::width - 1) / Simd::width * Simd::width;
+
+		renderChunk(chunk, nAligned, phase + static_cast<double>(offset) * phaseIncrement, phaseIncrement);
+		sink(offset, chunk, n);
+	}
+
+	return wrapPhase(phase + static_cast<double>(nFrames) * phaseIncrement);
+}
+
+} // namespace
+
+double renderSine(float* dst, const size_t nFrames, const double phase, const double phaseIncrement) noexcept
+{
+	return render(nFrames, phase, phaseIncrement, [dst](const size_t offset, const float* chunk, const size_t n) {
+		std::memcpy(dst + offset, chunk, n * sizeof(float));
+	});
+}
+
+double generateTone(float* interleavedBuffer, const size_t nFrames, const size_t nChannels, const size_t channelIndex, const double phase, const double phaseIncrement) noexcept
+{
+	if (nChannels == 1 && channelIndex == 0)
+		return renderSine(interleavedBuffer, nFrames, phase, phaseIncrement);
+
+	std::memset(interleavedBuffer, 0, nFrames * nChannels * sizeof(float));
+	if (channelIndex >= nChannels)
+		return wrapPhase(phase + static_cast<double>(nFrames) * phaseIncrement);
+
+	float* channel = interleavedBuffer + channelIndex;
+	return render(nFrames, phase, phaseIncrement, [channel, nChannels](const size_t offset, const float* chunk, const size_t n) {
+		float* dst = channel + offset * nChannels;
+		for (size_t i = 0; i < n; ++i)
+			dst[i * nChannels] = chunk[i];
+	});
+}
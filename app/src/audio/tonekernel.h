@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stddef.h>
+
+// Vectorized sine oscillator (SSE2 / AVX2 / NEON with a scalar fallback).
+// The sine is computed with a complex rotation recurrence, re-seeded from the exact phase every chunk of frames to bound the accumulated error.
+
+// Renders nFrames of sin(phase + i * phaseIncrement) into a contiguous float buffer.
+// Returns the phase of the frame following the last rendered one, wrapped to [0; 2 * Pi).
+double renderSine(float* dst, size_t nFrames, double phase, double phaseIncrement) noexcept;
+
+// Same as above, but writes the tone into the channel channelIndex of an interleaved float buffer.
+// The whole buffer is zeroed in one pass first, the other channels are not touched afterwards.
+double generateTone(float* interleavedBuffer, size_t nFrames, size_t nChannels, size_t channelIndex, double phase, double phaseIncrement) noexcept;
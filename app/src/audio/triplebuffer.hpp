@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+
+// Publishes snapshots of a small struct from any number of writer threads to a single reader thread.
+// The reader is wait-free: it never takes a lock and never spins, it just picks up the most recently published snapshot.
+// Writers are serialized among themselves with a mutex that the reader never touches.
+template <typename T>
+class TripleBuffer
+{
+public:
+	explicit TripleBuffer(const T& initialValue = {})
+	{
+		_slots.fill(initialValue);
+		_latest = initialValue;
+	}
+
+	// Applies f to a copy of the latest value and publishes the result.
+	template <typename Modifier>
+	void modify(Modifier&& f)
+	{
+		std::lock_guard lock{ _writerMutex };
+		f(_latest);
+		_slots[_back] = _latest;
+		_back = _middle.exchange(_back | dirtyFlag, std::memory_order_acq_rel) & indexMask;
+	}
+
+	void write(const T& value)
+	{
+		modify([&value](T& v) { v = value; });
+	}
+
+	// Reader side, must only be called from one thread.
+	[[nodiscard]] const T& read() noexcept
+	{
+		if ((_middle.load(std::memory_order_relaxed) & dirtyFlag) != 0)
+			_front = _middle.exchange(_front, std::memory_order_acq_rel) & indexMask;
+
+		return _slots[_front];
+	}
+
+private:
+	static constexpr uint8_t indexMask = 0x3;
+	static constexpr uint8_t dirtyFlag = 0x4;
+
+	std::array<T, 3> _slots;
+
+	// Slot ownership: _back belongs to the writers, _front to the reader, _middle is the one being handed over.
+	alignas(64) std::atomic<uint8_t> _middle = 1;
+	alignas(64) uint8_t _front = 2;
+	alignas(64) uint8_t _back = 0;
+
+	std::mutex _writerMutex;
+	T _latest;
+};
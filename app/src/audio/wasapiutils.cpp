@@ -0,0 +1,150 @@
+#include "wasapiutils.h"
+
+#include "assert/advanced_assert.h"
+#include "system/win_utils.hpp"
+
+#include <wil/resource.h>
+
+#include <mmreg.h>
+#include <Windows.h>
+#include <Functiondiscoverykeys_devpkey.h>
+
+#include <array>
+
+using namespace wil;
+
+static std::vector<ChannelInfo> channelsFromMask(const DWORD mask)
+{
+	static constexpr auto channelInfo = std::to_array<std::pair<const char* /* channel name */, uint32_t>>({
+		{"Left", SPEAKER_FRONT_LEFT },
+		{"Right", SPEAKER_FRONT_RIGHT },
+		{"Center", SPEAKER_FRONT_CENTER },
+		{"LFE", SPEAKER_LOW_FREQUENCY },
+		{"Back Left", SPEAKER_BACK_LEFT },
+		{"Back Right", SPEAKER_BACK_RIGHT },
+		{"Wide Left", SPEAKER_FRONT_LEFT_OF_CENTER },
+		{"Wide Right", SPEAKER_FRONT_RIGHT_OF_CENTER },
+		{"Back Center", SPEAKER_BACK_CENTER },
+		{"Side Left", SPEAKER_SIDE_LEFT },
+		{"Side Right", SPEAKER_SIDE_RIGHT },
+		{"Top Center", SPEAKER_TOP_CENTER },
+		{"Top Front Left", SPEAKER_TOP_FRONT_LEFT },
+		{"Top Front Right", SPEAKER_TOP_FRONT_RIGHT },
+		{"Top Back Left", SPEAKER_TOP_BACK_LEFT },
+		{"Top Back Center", SPEAKER_TOP_BACK_CENTER },
+		{"Top Back Right", SPEAKER_TOP_BACK_RIGHT }
+	});
+
+	std::vector<ChannelInfo> channels;
+	size_t index = 0;
+	for (const auto& ch : channelInfo)
+	{
+		if ((mask & ch.second) != 0)
+			channels.emplace_back(ch.first, index++);
+	}
+
+	return channels;
+}
+
+com_ptr_nothrow<IMMDeviceEnumerator> createDeviceEnumerator()
+{
+	com_ptr_nothrow<IMMDeviceEnumerator> pDeviceEnumerator;
+	const HRESULT hr = ::CoCreateInstance(
+		__uuidof(MMDeviceEnumerator),
+		nullptr,
+		CLSCTX_ALL,
+		__uuidof(IMMDeviceEnumerator),
+		(void**)&pDeviceEnumerator);
+	assert_and_return_message_r(SUCCEEDED(hr), "CoCreateInstance failed: " + ErrorStringFromHRESULT(hr), {});
+
+	return pDeviceEnumerator;
+}
+
+com_ptr_nothrow<IMMDevice> findDevice(const std::wstring& deviceId)
+{
+	const auto pDeviceEnumerator = createDeviceEnumerator();
+	assert_and_return_r(pDeviceEnumerator, {});
+
+	com_ptr_nothrow<IMMDevice> pDevice;
+	const HRESULT hr = pDeviceEnumerator->GetDevice(deviceId.c_str(), &pDevice);
+	assert_and_return_message_r(SUCCEEDED(hr), "IMMDeviceEnumerator.GetDevice error: " + ErrorStringFromHRESULT(hr), {});
+
+	return pDevice;
+}
+
+com_ptr_nothrow<IAudioClient> activateAudioClient(IMMDevice* pDevice)
+{
+	assert_and_return_r(pDevice, {});
+
+	com_ptr_nothrow<IAudioClient> pAudioClient;
+	const HRESULT hr = pDevice->Activate(
+		__uuidof(IAudioClient),
+		CLSCTX_ALL,
+		nullptr,
+		(void**)&pAudioClient);
+	assert_and_return_message_r(SUCCEEDED(hr), "IMMDevice.Activate error: " + ErrorStringFromHRESULT(hr), {});
+
+	return pAudioClient;
+}
+
+AudioFormat toAudioFormat(const WAVEFORMATEX& format)
+{
+	AudioFormat fmt;
+
+	assert_and_return_r(format.wFormatTag == WAVE_FORMAT_EXTENSIBLE, {});
+
+	const WAVEFORMATEXTENSIBLE& formatEx = reinterpret_cast<const WAVEFORMATEXTENSIBLE&>(format);
+	fmt.channels = channelsFromMask(formatEx.dwChannelMask);
+	assert_r(fmt.channels.size() == format.nChannels);
+	if (formatEx.SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT)
+		fmt.sampleFormat = AudioFormat::Float;
+	else if (formatEx.SubFormat == KSDATAFORMAT_SUBTYPE_PCM)
+		fmt.sampleFormat = AudioFormat::PCM;
+	else
+		assert_unconditional_r("Unknown subformat!");
+
+	fmt.sampleRate = format.nSamplesPerSec;
+	fmt.bitsPerSample = format.wBitsPerSample;
+	fmt.validBitsPerSample = formatEx.Samples.wValidBitsPerSample;
+
+	return fmt;
+}
+
+std::vector<AudioDeviceInfo> audioEndpoints(const EDataFlow direction)
+{
+	const auto pDeviceEnumerator = createDeviceEnumerator();
+	assert_and_return_r(pDeviceEnumerator, {});
+
+	com_ptr_nothrow<IMMDeviceCollection> pDevices;
+	const HRESULT hr = pDeviceEnumerator->EnumAudioEndpoints(
+		direction,
+		DEVICE_STATE_ACTIVE,
+		&pDevices);
+	assert_and_return_message_r(SUCCEEDED(hr), "IMMDeviceEnumerator.EnumAudioEndpoints error: " + ErrorStringFromHRESULT(hr), {});
+
+	UINT n = 0;
+	pDevices->GetCount(&n);
+	std::vector<AudioDeviceInfo> devices;
+	devices.reserve(n);
+	for (UINT i = 0; i < n; ++i)
+	{
+		com_ptr_nothrow<IMMDevice> pDevice;
+		pDevices->Item(i, &pDevice);
+		if (!pDevice)
+			continue;
+
+		unique_cotaskmem_string deviceID;
+		pDevice->GetId(&deviceID);
+
+		com_ptr_nothrow<IPropertyStore> props;
+		pDevice->OpenPropertyStore(STGM_READ, &props);
+		if (!props)
+			continue;
+
+		wil::unique_prop_variant pv;
+		props->GetValue(PKEY_Device_FriendlyName, &pv);
+		devices.emplace_back(deviceID.get(), pv.pwszVal);
+	}
+
+	return devices;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "audioformat.h"
+
+#include <wil/com.h>
+
+#include <audioclient.h>
+#include <mmdeviceapi.h>
+
+#include <string>
+#include <vector>
+
+// Shared by the WASAPI output and capture backends.
+
+[[nodiscard]] wil::com_ptr_nothrow<IMMDeviceEnumerator> createDeviceEnumerator();
+// A direct lookup by the endpoint ID string, no enumeration needed.
+[[nodiscard]] wil::com_ptr_nothrow<IMMDevice> findDevice(const std::wstring& deviceId);
+[[nodiscard]] wil::com_ptr_nothrow<IAudioClient> activateAudioClient(IMMDevice* pDevice);
+
+// WAVE_FORMAT_EXTENSIBLE only, as returned by IAudioClient::GetMixFormat().
+[[nodiscard]] AudioFormat toAudioFormat(const WAVEFORMATEX& format);
+
+// The active render (eRender) or capture (eCapture) endpoints.
+[[nodiscard]] std::vector<AudioDeviceInfo> audioEndpoints(EDataFlow direction);
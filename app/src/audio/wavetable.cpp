@@ -0,0 +1,177 @@
+#include "wavetable.h"
+
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <utility>
+
+static_assert((Wavetable::tableSize & (Wavetable::tableSize - 1)) == 0, "The table size must be a power of 2");
+
+// The Fourier series coefficient of the k-th harmonic, the waveform being the sum of coefficient(k) * sin(2 * Pi * k * x).
+[[nodiscard]] static double coefficient(const Waveform waveform, const size_t k) noexcept
+{
+	constexpr double pi = std::numbers::pi;
+	const bool odd = (k & 1) != 0;
+
+	switch (waveform)
+	{
+	case Waveform::Square:
+		return odd ? 4.0 / (pi * static_cast<double>(k)) : 0.0;
+	case Waveform::Sawtooth:
+		// Rising from -1 to 1.
+		return -2.0 / (pi * static_cast<double>(k));
+	case Waveform::Triangle:
+		return odd ? ((k & 2) != 0 ? -1.0 : 1.0) * 8.0 / (pi * pi * static_cast<double>(k * k)) : 0.0;
+	default:
+		assert_unconditional_r("This waveform has no wavetable");
+		return 0.0;
+	}
+}
+
+[[nodiscard]] static constexpr size_t harmonicsAtLevel(const size_t level) noexcept
+{
+	return std::min(size_t{ 1 } << level, Wavetable::tableSize / 2 - 1);
+}
+
+std::optional<Waveform> waveformFromName(const std::string_view name) noexcept
+{
+	static constexpr std::array<std::pair<std::string_view, Waveform>, 5> names {{
+		{ "sine", Waveform::Sine },
+		{ "square", Waveform::Square },
+		{ "sawtooth", Waveform::Sawtooth },
+		{ "triangle", Waveform::Triangle },
+		{ "pulse", Waveform::Pulse }
+	}};
+
+	for (const auto& [waveformName, waveform] : names)
+	{
+		if (name == waveformName)
+			return waveform;
+	}
+
+	return {};
+}
+
+Wavetable::Wavetable(const Waveform waveform)
+{
+	constexpr size_t N = tableSize;
+
+	// sin(2 * Pi * k * n / N) is sinTable[k * n mod N], so every harmonic is a lookup and a multiply-add per entry.
+	std::vector<double> sinTable(N);
+	for (size_t n = 0; n < N; ++n)
+		sinTable[n] = std::sin(2.0 * std::numbers::pi * static_cast<double>(n) / static_cast<double>(N));
+
+	// Each level adds the next octave of harmonics to the previous one.
+	std::vector<double> partialSum(N, 0.0);
+	std::vector<std::vector<double>> levels;
+	levels.reserve(nLevels);
+	for (size_t level = 0, k = 1; level < nLevels; ++level)
+	{
+		for (; k <= harmonicsAtLevel(level); ++k)
+		{
+			const double a = coefficient(waveform, k);
+			if (a == 0.0)
+				continue;
+
+			for (size_t n = 0; n < N; ++n)
+				partialSum[n] += a * sinTable[(k * n) & (N - 1)];
+		}
+
+		levels.push_back(partialSum);
+	}
+
+	double peak = 0.0;
+	for (const double v : levels.back())
+		peak = std::max(peak, std::abs(v));
+	const double scale = peak > 1.0 ? 1.0 / peak : 1.0;
+
+	_levels.resize(nLevels * (N + 1));
+	for (size_t level = 0; level < nLevels; ++level)
+	{
+		float* table = _levels.data() + level * (N + 1);
+		for (size_t n = 0; n < N; ++n)
+			table[n] = static_cast<float>(levels[level][n] * scale);
+		table[N] = table[0];
+	}
+}
+
+const Wavetable& Wavetable::get(const Waveform waveform)
+{
+	switch (waveform)
+	{
+	case Waveform::Square:
+	{
+		static const Wavetable square{ Waveform::Square };
+		return square;
+	}
+	case Waveform::Triangle:
+	{
+		static const Wavetable triangle{ Waveform::Triangle };
+		return triangle;
+	}
+	default:
+	{
+		assert_r(waveform == Waveform::Sawtooth || waveform == Waveform::Pulse);
+		static const Wavetable sawtooth{ Waveform::Sawtooth };
+		return sawtooth;
+	}
+	}
+}
+
+const float* Wavetable::table(const double cyclesPerSample) const noexcept
+{
+	// The highest harmonic that stays below Nyquist.
+	const double maxHarmonic = cyclesPerSample > 0.0 ? 0.5 / cyclesPerSample : static_cast<double>(tableSize);
+
+	size_t level = nLevels - 1;
+	if (maxHarmonic < static_cast<double>(harmonicsAtLevel(nLevels - 1)))
+		level = maxHarmonic < 2.0 ? 0 : std::min(static_cast<size_t>(std::ilogb(maxHarmonic)), nLevels - 2);
+
+	return _levels.data() + level * (tableSize + 1);
+}
+
+[[nodiscard]] static inline float lookup(const float* table, const double phase) noexcept
+{
+	const double position = phase * static_cast<double>(Wavetable::tableSize);
+	const auto index = static_cast<size_t>(position);
+	const auto fraction = static_cast<float>(position - static_cast<double>(index));
+	return table[index] + fraction * (table[index + 1] - table[index]);
+}
+
+double renderWavetable(float* dst, const size_t nFrames, double phase, const double cyclesPerSample, const Waveform waveform, const float pulseWidth) noexcept
+{
+	assert_debug_only(waveform != Waveform::Sine);
+
+	const float* table = Wavetable::get(waveform).table(std::abs(cyclesPerSample));
+	phase -= std::floor(phase);
+
+	if (waveform == Waveform::Pulse)
+	{
+		// Half the difference of two sawtooth waves pulseWidth apart: 1 - d for the first d of the period, -d for the rest.
+		const double width = std::clamp(static_cast<double>(pulseWidth), 0.0, 1.0);
+		for (size_t i = 0; i < nFrames; ++i)
+		{
+			double delayedPhase = phase - width;
+			delayedPhase += delayedPhase < 0.0 ? 1.0 : 0.0;
+			dst[i] = 0.5f * (lookup(table, delayedPhase) - lookup(table, phase));
+
+			phase += cyclesPerSample;
+			phase -= phase >= 1.0 ? 1.0 : 0.0;
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < nFrames; ++i)
+		{
+			dst[i] = lookup(table, phase);
+
+			phase += cyclesPerSample;
+			phase -= phase >= 1.0 ? 1.0 : 0.0;
+		}
+	}
+
+	return phase;
+}
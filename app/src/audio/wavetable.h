@@ -0,0 +1,41 @@
+#pragma once
+
+#include <optional>
+#include <stddef.h>
+#include <string_view>
+#include <vector>
+
+enum class Waveform { Sine, Square, Sawtooth, Triangle, Pulse };
+
+// "sine", "square", "sawtooth", "triangle" or "pulse", as used by the text formats (control protocol, sequences).
+[[nodiscard]] std::optional<Waveform> waveformFromName(std::string_view name) noexcept;
+
+// Band-limited single-cycle tables of one waveform, one per octave of harmonic count (a mipmap):
+// level L holds the harmonics 1 to 2^L (the last level - as many as the table size allows).
+// A tone picks the richest level whose top harmonic is still below Nyquist, so nothing folds back.
+// All the levels are scaled by the same factor that keeps the richest one (Gibbs overshoot included) within [-1; 1].
+class Wavetable
+{
+public:
+	static constexpr size_t tableSize = 4096;
+	static constexpr size_t nLevels = 12;
+
+	// The tables are built on the first request for each waveform and kept for the lifetime of the program; thread-safe.
+	// The first call takes a few milliseconds, so it should be made on a non-real-time thread (see CAudioEngine::setWaveform()).
+	// Only Square, Sawtooth and Triangle have tables; Sine is rendered directly, Pulse is derived from Sawtooth.
+	[[nodiscard]] static const Wavetable& get(Waveform waveform);
+
+	// The level for a tone advancing by cyclesPerSample of a period every sample. Has tableSize + 1 entries, the last one repeats the first.
+	[[nodiscard]] const float* table(double cyclesPerSample) const noexcept;
+
+private:
+	explicit Wavetable(Waveform waveform);
+
+private:
+	std::vector<float> _levels;
+};
+
+// Renders nFrames of a band-limited waveform (anything but Sine) into a contiguous buffer, linearly interpolating the table.
+// The phase is in periods, pulseWidth is the pulse duty cycle in (0; 1). The pulse is DC-free and spans [-pulseWidth; 1 - pulseWidth].
+// Returns the phase of the frame following the last rendered one, wrapped to [0; 1).
+double renderWavetable(float* dst, size_t nFrames, double phase, double cyclesPerSample, Waveform waveform, float pulseWidth) noexcept;
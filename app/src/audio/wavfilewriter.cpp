@@ -0,0 +1,148 @@
+#include "wavfilewriter.h"
+#include "assert/advanced_assert.h"
+
+#include <limits>
+
+namespace {
+
+enum : uint16_t {
+	WaveFormatPcm = 1,
+	WaveFormatIeeeFloat = 3,
+	WaveFormatExtensible = 0xFFFE
+};
+
+// KSDATAFORMAT_SUBTYPE_PCM / _IEEE_FLOAT are this GUID with the format tag in the first two bytes.
+constexpr uint8_t subFormatGuidTail[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+
+// The first n of the standard speaker positions (front left, front right, front center, LFE, back left, back right...),
+// except for the layouts that skip some: mono is front center, quad has no center or LFE, 7.1 uses the side speakers.
+[[nodiscard]] uint32_t channelMask(const size_t nChannels) noexcept
+{
+	switch (nChannels)
+	{
+	case 1:
+		return 0x4;
+	case 4:
+		return 0x33;
+	case 8:
+		return 0x63F;
+	default:
+		// 18 positions are defined; beyond that, the channels aren't assigned to speakers.
+		return nChannels <= 18 ? (uint32_t{ 1 } << nChannels) - 1 : 0;
+	}
+}
+
+struct HeaderBuilder {
+	void fourCC(const char (&id)[5]) { for (size_t i = 0; i < 4; ++i) bytes[size++] = static_cast<uint8_t>(id[i]); }
+	void u16(const uint16_t v) { for (size_t i = 0; i < 2; ++i) bytes[size++] = static_cast<uint8_t>(v >> (8 * i)); }
+	void u32(const uint32_t v) { for (size_t i = 0; i < 4; ++i) bytes[size++] = static_cast<uint8_t>(v >> (8 * i)); }
+	void u64(const uint64_t v) { for (size_t i = 0; i < 8; ++i) bytes[size++] = static_cast<uint8_t>(v >> (8 * i)); }
+	void raw(const uint8_t* data, const size_t n) { for (size_t i = 0; i < n; ++i) bytes[size++] = data[i]; }
+
+	uint8_t bytes[128] {};
+	size_t size = 0;
+};
+
+} // namespace
+
+WavFileWriter::~WavFileWriter()
+{
+	close();
+}
+
+bool WavFileWriter::open(const std::string& path, const AudioFormat& format)
+{
+	close();
+	assert_and_return_r(!format.channels.empty() && format.sampleRate > 0 && format.bitsPerSample % 8 == 0, false);
+
+	_file = std::fopen(path.c_str(), "wb");
+	assert_and_return_message_r(_file, "Failed to create " + path, false);
+
+	_format = format;
+	_framesWritten = 0;
+	return writeHeader();
+}
+
+bool WavFileWriter::write(const void* frames, const size_t nFrames)
+{
+	assert_and_return_r(_file, false);
+
+	const size_t frameSize = _format.channels.size() * _format.bitsPerSample / 8;
+	const bool success = std::fwrite(frames, frameSize, nFrames, _file) == nFrames;
+	_framesWritten += nFrames;
+	return success;
+}
+
+bool WavFileWriter::close()
+{
+	if (!_file)
+		return true;
+
+	// Patch the chunk sizes now that the data length is known.
+	const bool success = std::fseek(_file, 0, SEEK_SET) == 0 && writeHeader();
+	const bool closed = std::fclose(_file) == 0;
+	_file = nullptr;
+	return success && closed;
+}
+
+bool WavFileWriter::isOpen() const noexcept
+{
+	return _file != nullptr;
+}
+
+uint64_t WavFileWriter::framesWritten() const noexcept
+{
+	return _framesWritten;
+}
+
+bool WavFileWriter::writeHeader()
+{
+	const auto nChannels = static_cast<uint16_t>(_format.channels.size());
+	const uint16_t blockAlign = nChannels * (_format.bitsPerSample / 8);
+	const uint64_t dataSize = _framesWritten * blockAlign;
+	const uint16_t validBits = _format.validBitsPerSample != 0 ? _format.validBitsPerSample : _format.bitsPerSample;
+	const bool extensible = nChannels > 2 || _format.bitsPerSample > 16 || validBits != _format.bitsPerSample;
+	const uint16_t formatTag = _format.sampleFormat == AudioFormat::Float ? WaveFormatIeeeFloat : WaveFormatPcm;
+
+	// RIFF header + ds64/JUNK chunk + fmt chunk + data chunk header
+	constexpr uint32_t ds64Size = 28;
+	const uint32_t fmtSize = extensible ? 40 : 16;
+	const uint32_t headerSize = 12 + (8 + ds64Size) + (8 + fmtSize) + 8;
+	const uint64_t riffSize = headerSize - 8 + dataSize;
+	const bool rf64 = riffSize > std::numeric_limits<uint32_t>::max();
+
+	HeaderBuilder header;
+	header.fourCC(rf64 ? "RF64" : "RIFF");
+	header.u32(rf64 ? std::numeric_limits<uint32_t>::max() : static_cast<uint32_t>(riffSize));
+	header.fourCC("WAVE");
+
+	header.fourCC(rf64 ? "ds64" : "JUNK");
+	header.u32(ds64Size);
+	header.u64(rf64 ? riffSize : 0);
+	header.u64(rf64 ? dataSize : 0);
+	header.u64(rf64 ? _framesWritten : 0);
+	header.u32(0); // No table entries
+
+	header.fourCC("fmt ");
+	header.u32(fmtSize);
+	header.u16(extensible ? uint16_t{ WaveFormatExtensible } : formatTag);
+	header.u16(nChannels);
+	header.u32(_format.sampleRate);
+	header.u32(_format.sampleRate * blockAlign);
+	header.u16(blockAlign);
+	header.u16(_format.bitsPerSample);
+	if (extensible)
+	{
+		header.u16(22); // The size of the extension
+		header.u16(validBits);
+		header.u32(channelMask(nChannels));
+		header.u16(formatTag);
+		header.raw(subFormatGuidTail, sizeof(subFormatGuidTail));
+	}
+
+	header.fourCC("data");
+	header.u32(rf64 ? std::numeric_limits<uint32_t>::max() : static_cast<uint32_t>(dataSize));
+
+	assert_debug_only(header.size == headerSize);
+	return std::fwrite(header.bytes, 1, header.size, _file) == header.size;
+}
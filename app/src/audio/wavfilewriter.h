@@ -0,0 +1,35 @@
+#pragma once
+#include "audioformat.h"
+
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+
+// Streaming WAV writer: the header is written up front and patched with the final sizes on close().
+// Space for an RF64 'ds64' chunk is reserved as a 'JUNK' chunk, so a file that outgrows 4 GB is turned into RF64 on close().
+// More than 2 channels, more than 16 bits and containers with padding bits (24-in-32) are written as WAVE_FORMAT_EXTENSIBLE,
+// with the channel mask of the usual speaker layout for the channel count, as the plain format is ambiguous for those.
+class WavFileWriter
+{
+public:
+	WavFileWriter() = default;
+	WavFileWriter(const WavFileWriter&) = delete;
+	WavFileWriter& operator=(const WavFileWriter&) = delete;
+	~WavFileWriter();
+
+	bool open(const std::string& path, const AudioFormat& format);
+	// frames are interleaved samples in the format passed to open().
+	bool write(const void* frames, size_t nFrames);
+	bool close();
+
+	[[nodiscard]] bool isOpen() const noexcept;
+	[[nodiscard]] uint64_t framesWritten() const noexcept;
+
+private:
+	bool writeHeader();
+
+private:
+	std::FILE* _file = nullptr;
+	AudioFormat _format;
+	uint64_t _framesWritten = 0;
+};
@@ -1,3 +1,5 @@
+#include <array>
+
 #include <unknwn.h>
 #include <winrt/Windows.Foundation.h>
 #include <winrt/Windows.Media.Audio.h>
@@ -198,12 +200,14 @@ private:
 			auto output_bytes_per_sample = output_bits_per_sample >> 3;
 
 			unsigned int byte_count = output_sample_count * output_channel_count * output_bytes_per_sample;
-			AudioFrame frame(byte_count);
+			AudioFrame frame = NextPooledFrame(byte_count);
 
 			// grab the samples collected thus for from the microphone / input device
 			// get access to the output sample buffer
 			{
 				AudioBuffer buffer = frame.LockBuffer(AudioBufferAccessMode::Write);
+				// a recycled frame may be bigger than this quantum needs
+				buffer.Length(byte_count);
 				float* output_data = GetDataPtrFromBuffer(buffer);
 
 				GenerateSineWave(output_data, output_channel_count, output_sample_count, output_sample_rate);
@@ -225,6 +229,24 @@ private:
 		}
 	}
 
+	//////////////////////////////////////////////////////////////////////////
+	// AudioFrames are recycled round-robin instead of being allocated every quantum.
+	// The node is only ever fed one quantum ahead, so a frame comes round again long after the graph is done with it.
+	AudioFrame NextPooledFrame(unsigned int byte_count)
+	{
+		PooledFrame& pooled = m_frame_pool[m_next_pooled_frame];
+		m_next_pooled_frame = (m_next_pooled_frame + 1) % m_frame_pool.size();
+
+		// only allocates while warming up, or if the quantum grows
+		if (!pooled.frame || pooled.capacity < byte_count)
+		{
+			pooled.frame = AudioFrame(byte_count);
+			pooled.capacity = byte_count;
+		}
+
+		return pooled.frame;
+	}
+
 	//////////////////////////////////////////////////////////////////////////
 	float* GetDataPtrFromBuffer(AudioBuffer& buffer)
 	{
@@ -289,6 +311,14 @@ private:
 
 	event_token m_quantum_started_token;
 
+	struct PooledFrame
+	{
+		AudioFrame frame = nullptr;
+		unsigned int capacity = 0;
+	};
+	std::array<PooledFrame, 8> m_frame_pool;
+	size_t m_next_pooled_frame = 0;
+
 	int	m_input_channel_count = 1;
 
 
@@ -0,0 +1,93 @@
+#include "cbatchrenderer.h"
+#include "../audio/oscillator.h"
+#include "../audio/wavfilewriter.h"
+
+#include "assert/advanced_assert.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+static constexpr size_t chunkFrames = 64 * 1024;
+
+double CBatchRenderer::Stats::megabytesPerSecond() const noexcept
+{
+	return seconds > 0.0 ? static_cast<double>(bytesWritten) / (1024.0 * 1024.0) / seconds : 0.0;
+}
+
+CBatchRenderer::CBatchRenderer(const size_t nThreads) :
+	_nThreads{ nThreads > 0 ? nThreads : std::max(1u, std::thread::hardware_concurrency()) }
+{
+}
+
+CBatchRenderer::Stats CBatchRenderer::render(const std::vector<RenderJob>& jobs) const
+{
+	std::atomic<size_t> nextJob = 0;
+	std::atomic<size_t> succeeded = 0, failed = 0;
+	std::atomic<uint64_t> bytesWritten = 0;
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	const size_t nWorkers = std::min(_nThreads, jobs.size());
+	for (size_t i = 0; i < nWorkers; ++i)
+	{
+		workers.emplace_back([&] {
+			std::vector<float> buffer;
+			for (size_t jobIndex = nextJob++; jobIndex < jobs.size(); jobIndex = nextJob++)
+			{
+				uint64_t jobBytes = 0;
+				if (renderJob(jobs[jobIndex], buffer, jobBytes))
+					++succeeded;
+				else
+					++failed;
+
+				bytesWritten += jobBytes;
+			}
+		});
+	}
+
+	for (auto& worker : workers)
+		worker.join();
+
+	Stats stats;
+	stats.jobsSucceeded = succeeded;
+	stats.jobsFailed = failed;
+	stats.bytesWritten = bytesWritten;
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return stats;
+}
+
+bool CBatchRenderer::renderJob(const RenderJob& job, std::vector<float>& buffer, uint64_t& bytesWritten)
+{
+	AudioFormat format;
+	format.sampleRate = job.sampleRate;
+	format.sampleFormat = AudioFormat::Float;
+	format.bitsPerSample = 32;
+	for (size_t c = 0; c < job.nChannels; ++c)
+		format.channels.emplace_back("Channel " + std::to_string(c + 1), c);
+
+	WavFileWriter writer;
+	if (!writer.open(job.outputPath, format))
+		return false;
+
+	ToneOscillator oscillator;
+	oscillator.setSampleRate(job.sampleRate);
+
+	buffer.resize(chunkFrames * job.nChannels);
+
+	const auto totalFrames = static_cast<uint64_t>(job.seconds * job.sampleRate);
+	for (uint64_t framesDone = 0; framesDone < totalFrames;)
+	{
+		const auto n = static_cast<size_t>(std::min<uint64_t>(chunkFrames, totalFrames - framesDone));
+		oscillator.renderTone(buffer.data(), n, job.nChannels, job.channelIndex, job.hz);
+		assert_and_return_message_r(writer.write(buffer.data(), n), "Failed to write " + job.outputPath, false);
+
+		framesDone += n;
+		bytesWritten += n * job.nChannels * sizeof(float);
+	}
+
+	return writer.close();
+}
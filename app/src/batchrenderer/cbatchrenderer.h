@@ -0,0 +1,31 @@
+#pragma once
+#include "renderjob.h"
+
+#include <stdint.h>
+#include <vector>
+
+// Renders tone files on a pool of worker threads. Every worker streams its job to disk in fixed-size chunks,
+// so memory use depends on the thread count only, not on the file length.
+class CBatchRenderer
+{
+public:
+	struct Stats {
+		size_t jobsSucceeded = 0;
+		size_t jobsFailed = 0;
+		uint64_t bytesWritten = 0;
+		double seconds = 0.0;
+
+		[[nodiscard]] double megabytesPerSecond() const noexcept;
+	};
+
+	// 0 means one thread per hardware thread.
+	explicit CBatchRenderer(size_t nThreads = 0);
+
+	Stats render(const std::vector<RenderJob>& jobs) const;
+
+private:
+	static bool renderJob(const RenderJob& job, std::vector<float>& buffer, uint64_t& bytesWritten);
+
+private:
+	size_t _nThreads;
+};
@@ -0,0 +1,52 @@
+#include "cbatchrenderer.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+static void printUsage()
+{
+	std::cout << "Usage:\n"
+		"  ToneBatchRenderer <job list file> [thread count]\n"
+		"  ToneBatchRenderer --calibration-set <output dir> <channel count> <sample rate>[,<sample rate>...] <seconds> [thread count]\n";
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<RenderJob> jobs;
+	int threadCountArg = 2;
+
+	if (argc >= 6 && std::string{ argv[1] } == "--calibration-set")
+	{
+		std::vector<uint32_t> sampleRates;
+		std::istringstream rates{ argv[4] };
+		for (std::string rate; std::getline(rates, rate, ',');)
+			sampleRates.push_back(static_cast<uint32_t>(std::strtoul(rate.c_str(), nullptr, 10)));
+
+		jobs = calibrationJobSet(argv[2], std::strtoul(argv[3], nullptr, 10), sampleRates, std::strtod(argv[5], nullptr));
+		threadCountArg = 6;
+	}
+	else if (argc >= 2 && argv[1][0] != '-')
+		jobs = loadJobList(argv[1]);
+	else
+	{
+		printUsage();
+		return 1;
+	}
+
+	if (jobs.empty())
+	{
+		std::cerr << "Nothing to render." << std::endl;
+		return 1;
+	}
+
+	const size_t nThreads = argc > threadCountArg ? std::strtoul(argv[threadCountArg], nullptr, 10) : 0;
+	const auto stats = CBatchRenderer{ nThreads }.render(jobs);
+
+	std::cout << stats.jobsSucceeded << " files rendered, " << stats.jobsFailed << " failed; "
+		<< stats.bytesWritten / (1024 * 1024) << " MB in " << stats.seconds << " s ("
+		<< stats.megabytesPerSecond() << " MB/s)" << std::endl;
+
+	return stats.jobsFailed == 0 ? 0 : 2;
+}
@@ -0,0 +1,60 @@
+#include "renderjob.h"
+
+#include "assert/advanced_assert.h"
+
+#include <fstream>
+#include <sstream>
+
+std::vector<RenderJob> loadJobList(const std::string& jobListPath)
+{
+	std::ifstream file{ jobListPath };
+	assert_and_return_message_r(file.is_open(), "Failed to open " + jobListPath, {});
+
+	std::vector<RenderJob> jobs;
+	std::string line;
+	for (size_t lineNumber = 1; std::getline(file, line); ++lineNumber)
+	{
+		if (line.empty() || line.front() == '#' || line.find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+
+		RenderJob job;
+		std::istringstream fields{ line };
+		fields >> job.outputPath >> job.sampleRate >> job.nChannels >> job.channelIndex >> job.hz >> job.seconds;
+		assert_and_return_message_r(fields && job.channelIndex < job.nChannels && job.sampleRate > 0 && job.seconds > 0.0,
+			jobListPath + ": invalid job on line " + std::to_string(lineNumber), {});
+
+		jobs.push_back(std::move(job));
+	}
+
+	return jobs;
+}
+
+std::vector<RenderJob> calibrationJobSet(const std::string& outputDir, const size_t nChannels, const std::vector<uint32_t>& sampleRates, const double seconds)
+{
+	// The audio band, 20 Hz to 20 kHz. The 12.5 and 16 Hz bands are left out on purpose: they're infrasound, which most
+	// playback chains attenuate heavily, so their levels are no use for calibrating them.
+	static constexpr double thirdOctaveFrequencies[] {
+		20.0, 25.0, 31.5, 40.0, 50.0, 63.0, 80.0, 100.0, 125.0, 160.0, 200.0,
+		250.0, 315.0, 400.0, 500.0, 630.0, 800.0, 1000.0, 1250.0, 1600.0, 2000.0,
+		2500.0, 3150.0, 4000.0, 5000.0, 6300.0, 8000.0, 10000.0, 12500.0, 16000.0, 20000.0
+	};
+
+	std::vector<RenderJob> jobs;
+	for (const uint32_t sampleRate : sampleRates)
+	{
+		for (size_t channel = 0; channel < nChannels; ++channel)
+		{
+			for (const double hz : thirdOctaveFrequencies)
+			{
+				if (hz >= sampleRate / 2.0)
+					break;
+
+				std::ostringstream path;
+				path << outputDir << '/' << sampleRate << "_ch" << (channel + 1) << '_' << hz << "Hz.wav";
+				jobs.push_back({ path.str(), sampleRate, nChannels, channel, hz, seconds });
+			}
+		}
+	}
+
+	return jobs;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct RenderJob {
+	std::string outputPath;
+	uint32_t sampleRate = 48000;
+	size_t nChannels = 2;
+	size_t channelIndex = 0;
+	double hz = 1000.0;
+	double seconds = 1.0;
+};
+
+// Parses a job list: one job per line, "<output path> <sample rate> <channel count> <channel index> <frequency Hz> <seconds>".
+// Empty lines and lines starting with '#' are skipped. Returns an empty list on a syntax error.
+[[nodiscard]] std::vector<RenderJob> loadJobList(const std::string& jobListPath);
+
+// Every channel x every ISO 266 1/3-octave frequency from 20 Hz to 20 kHz below Nyquist x every sample rate.
+[[nodiscard]] std::vector<RenderJob> calibrationJobSet(const std::string& outputDir, size_t nChannels, const std::vector<uint32_t>& sampleRates, double seconds);
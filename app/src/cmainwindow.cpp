@@ -1,15 +1,32 @@
 #include "cmainwindow.h"
+#include "audio/allocationcounter.h"
 
 #include "assert/advanced_assert.h"
 #include "compiler/compiler_warnings_control.h"
 
+#include <algorithm>
+#include <cmath>
+
 DISABLE_COMPILER_WARNINGS
 #include "ui_cmainwindow.h"
 
 #include <QDebug>
-#include <QLineSeries>
+#include <QDir>
+#include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QStandardPaths>
 RESTORE_COMPILER_WARNINGS
 
+// cbWaveform item data: a Waveform, noiseItemId + NoiseParams::Type or sweepItemId + SweepParams::Shape.
+static constexpr int noiseItemId = 100;
+static constexpr int sweepItemId = 200;
+
+static float dbfsToGain(double dbfs)
+{
+	return static_cast<float>(std::pow(10.0, dbfs / 20.0));
+}
+
 CMainWindow::CMainWindow(QWidget *parent) :
 	QMainWindow(parent),
 	ui(new Ui::CMainWindow)
@@ -18,9 +35,7 @@ CMainWindow::CMainWindow(QWidget *parent) :
 
 	connect(ui->cbSources, (void (QComboBox::*)(int)) & QComboBox::currentIndexChanged, this, &CMainWindow::newDeviceSelected);
 
-	// Scan all the available audio output devices and add all the appropriate ones to the combobox.
-	for (const auto& info : _audio.devices())
-		ui->cbSources->addItem(QString::fromStdWString(info.friendlyName), QString::fromStdWString(info.id));
+	fillDeviceList();
 
 	// Find and select the AVR if there is one.
 	for (int i = 0; i < ui->cbSources->count(); ++i)
@@ -32,18 +47,74 @@ CMainWindow::CMainWindow(QWidget *parent) :
 		}
 	}
 
+	// These two arrive on the backend's threads.
+	_audio.setDeviceChangeCallback([this] {
+		QMetaObject::invokeMethod(this, &CMainWindow::fillDeviceList, Qt::QueuedConnection);
+	});
+
+	_audio.setPlaybackErrorCallback([this] {
+		QMetaObject::invokeMethod(this, &CMainWindow::recoverPlayback, Qt::QueuedConnection);
+	});
+
+	ui->cbWaveform->addItem("Sine", static_cast<int>(Waveform::Sine));
+	ui->cbWaveform->addItem("Square", static_cast<int>(Waveform::Square));
+	ui->cbWaveform->addItem("Sawtooth", static_cast<int>(Waveform::Sawtooth));
+	ui->cbWaveform->addItem("Triangle", static_cast<int>(Waveform::Triangle));
+	ui->cbWaveform->addItem("Pulse 25%", static_cast<int>(Waveform::Pulse));
+	ui->cbWaveform->addItem("White noise", noiseItemId + NoiseParams::White);
+	ui->cbWaveform->addItem("Pink noise", noiseItemId + NoiseParams::Pink);
+	ui->cbWaveform->addItem("Log sweep 20 Hz - 20 kHz", sweepItemId + SweepParams::Logarithmic);
+	ui->cbWaveform->addItem("Linear sweep 20 Hz - 20 kHz", sweepItemId + SweepParams::Linear);
+
 	_audio.setChannelIndex(ui->cbChannel->currentData().toUInt());
 	_audio.setFrequency(static_cast<float>(ui->sbToneFrequency->value()));
-
-	ui->btnPlay->setEnabled(ui->cbSources->count() > 0);
+	_audio.setGain(dbfsToGain(ui->sbGain->value()));
+	_analyzer.setChannelIndex(ui->cbChannel->currentData().toUInt());
+	updateAnalyzerFundamental();
 
 	// Handle parameter changes on the fly.
 	connect(ui->cbChannel, (void (QComboBox::*)(int)) & QComboBox::currentIndexChanged, this, [this]() {
 		_audio.setChannelIndex(ui->cbChannel->currentData().toUInt());
+		_analyzer.setChannelIndex(ui->cbChannel->currentData().toUInt());
+	});
+
+	connect(ui->cbWaveform, (void (QComboBox::*)(int)) & QComboBox::currentIndexChanged, this, [this]() {
+		const int id = ui->cbWaveform->currentData().toInt();
+		const bool tone = id < noiseItemId;
+		ui->sbToneFrequency->setEnabled(tone);
+		_sequence.reset();
+
+		if (id >= sweepItemId)
+		{
+			SweepParams sweep;
+			sweep.shape = static_cast<SweepParams::Shape>(id - sweepItemId);
+			sweep.repeat = true;
+			_audio.startSweep(sweep);
+		}
+		else if (!tone)
+		{
+			NoiseParams params;
+			params.type = static_cast<NoiseParams::Type>(id - noiseItemId);
+			_audio.startNoise(params);
+		}
+		else
+		{
+			_audio.setWaveform(static_cast<Waveform>(id), 0.25f);
+			// Back to the tone in case noise was playing.
+			_audio.setFrequency(static_cast<float>(ui->sbToneFrequency->value()));
+		}
+
+		updateAnalyzerFundamental();
 	});
 
 	connect(ui->sbToneFrequency, (void (QSpinBox::*)(int))&QSpinBox::valueChanged, this, [this](int value) {
 		_audio.setFrequency(static_cast<float>(value));
+		_sequence.reset();
+		updateAnalyzerFundamental();
+	});
+
+	connect(ui->sbGain, (void (QDoubleSpinBox::*)(double))&QDoubleSpinBox::valueChanged, this, [this](double value) {
+		_audio.setGain(dbfsToGain(value));
 	});
 
 	// Play
@@ -56,11 +127,22 @@ CMainWindow::CMainWindow(QWidget *parent) :
 	ui->btnStopAudio->setText({});
 	connect(ui->btnStopAudio, &QPushButton::clicked, this, &CMainWindow::stopPlayback);
 
+	connect(ui->btnExportStats, &QPushButton::clicked, this, &CMainWindow::exportRenderStats);
+	connect(ui->btnRunSequence, &QPushButton::clicked, this, &CMainWindow::runSequence);
+
+	connect(ui->cbAnalyzeInput, &QCheckBox::toggled, this, &CMainWindow::startAnalyzer);
+	connect(ui->cbCaptureDevices, (void (QComboBox::*)(int)) & QComboBox::currentIndexChanged, this, &CMainWindow::startAnalyzer);
+	connect(&_analyzerTimer, &QTimer::timeout, this, &CMainWindow::updateAnalyzerReading);
+
 	setupChart();
+	connect(&_chartUpdateTimer, &QTimer::timeout, this, &CMainWindow::updateRenderStats);
 }
 
 CMainWindow::~CMainWindow()
 {
+	_audio.setDeviceChangeCallback({});
+	_audio.stopPlayback();
+	_analyzer.stop();
 	delete ui;
 }
 
@@ -72,89 +154,287 @@ void CMainWindow::setupChart()
 	ui->chartWidget->setChart(&_chart);
 	ui->chartWidget->setRenderHint(QPainter::Antialiasing);
 
-	connect(&_chartUpdateTimer, &QTimer::timeout, this, [this] {
-		ui->chartWidget->setUpdatesEnabled(false);
-		if (auto oldSeries = _chart.series(); !oldSeries.empty())
-		{
-			for (auto* s : oldSeries)
-				s->deleteLater();
+	// The axes and the per-channel series are persistent, only their points are replaced on every update.
+	_axisX = new QValueAxis;
+	_axisY = new QValueAxis;
+	_axisY->setRange(-1.0, +1.0);
+	_chart.addAxis(_axisX, Qt::AlignBottom);
+	_chart.addAxis(_axisY, Qt::AlignLeft);
 
-			_chart.removeAllSeries();
-		}
+	connect(&_chartUpdateTimer, &QTimer::timeout, this, [this] {
+		const uint64_t allocationsBefore = AllocationCounter::threadAllocations();
 
-		const auto samples = _audio.currentSamplesBuffer();
+		// Show the most recent 10 ms of the output.
+		const auto nPixels = static_cast<size_t>(std::max(_chart.plotArea().width(), 1.0));
+		if (!_waveformEnvelope.update(_audio, _audio.format().sampleRate / 100, nPixels))
+			return;
 
-		for (size_t c = 0; c < samples.height(); ++c)
+		const size_t nChannels = _waveformEnvelope.channels();
+		if (_channelSeries.size() != nChannels)
 		{
-			auto* series = new QLineSeries;
-			//seriesForChannel.emplace_back(series);
-
-			for (size_t i = 0, n = samples.width(); i < n; ++i)
+			_chart.removeAllSeries();
+			_channelSeries.clear();
+			for (size_t c = 0; c < nChannels; ++c)
 			{
-				series->append(static_cast<qreal>(i), samples[c][i]);
+				auto* series = new QLineSeries;
+				_chart.addSeries(series);
+				series->attachAxis(_axisX);
+				series->attachAxis(_axisY);
+				_channelSeries.push_back(series);
 			}
 
-			_chart.addSeries(series);
+			_envelopePoints.resize(2 * nChannels);
 		}
 
-		_chart.createDefaultAxes();
-		_chart.axisY()->setRange(-1.0, +1.0);
-		_chart.axisX()->setRange(0, samples.width());
+		// A series keeps referencing the points it's been given, so the envelope is copied into the other buffer of the channel's pair
+		// rather than one the series would make it copy on write.
+		_envelopeBufferIndex ^= 1;
+		for (size_t c = 0; c < nChannels; ++c)
+		{
+			const auto& envelope = _waveformEnvelope.points(c);
+			auto& points = _envelopePoints[2 * c + _envelopeBufferIndex];
+			points.resize(static_cast<int>(envelope.size()));
+			for (size_t i = 0; i < envelope.size(); ++i)
+				points[static_cast<int>(i)] = QPointF(envelope[i].x, envelope[i].y);
+		}
+
+		// Once the shape has settled, everything up to here reuses the buffers of the previous updates. ToneTests checks the same
+		// for WaveformEnvelope on its own; this covers the copy into the chart's buffers as well.
+		assert_message_r(_waveformEnvelope.steadyUpdates() < 2 || AllocationCounter::threadAllocations() == allocationsBefore, "The chart update has allocated");
+
+		ui->chartWidget->setUpdatesEnabled(false);
+		for (size_t c = 0; c < nChannels; ++c)
+			_channelSeries[c]->replace(_envelopePoints[2 * c + _envelopeBufferIndex]);
+
+		_axisX->setRange(0, static_cast<qreal>(_waveformEnvelope.frames()));
 		ui->chartWidget->setUpdatesEnabled(true);
+
+		if (const auto misses = _audio.deadlineMisses(); misses > 0)
+			ui->statusbar->showMessage(QString("Deadline misses: %1 of %2 callbacks").arg(misses).arg(_audio.renderCallbacks()));
+		else if (const auto overruns = _audio.monitorOverruns(); overruns > 0)
+			ui->statusbar->showMessage(QString("Monitor overruns: %1 (%2 frames dropped)").arg(overruns).arg(_audio.monitorDroppedFrames()));
 	});
 }
 
-void CMainWindow::newDeviceSelected()
+void CMainWindow::fillDeviceList()
 {
-	_audio.stopPlayback();
+	fillCaptureDeviceList();
 
-	const auto info = selectedDeviceInfo();
-	displayDeviceInfo(info);
+	const auto selectedId = ui->cbSources->currentData().toString();
+
+	{
+		const QSignalBlocker blocker{ ui->cbSources };
+		ui->cbSources->clear();
+		// Scan all the available audio output devices and add all the appropriate ones to the combobox.
+		for (const auto& info : _audio.devices())
+			ui->cbSources->addItem(QString::fromStdWString(info.friendlyName), QString::fromStdWString(info.id));
+
+		if (const int index = ui->cbSources->findData(selectedId); index >= 0)
+			ui->cbSources->setCurrentIndex(index);
+	}
 
+	ui->btnPlay->setEnabled(ui->cbSources->count() > 0);
+	if (ui->cbSources->count() == 0)
+	{
+		stopPlayback();
+		return;
+	}
+
+	// Don't interrupt the playback because some other device has come or gone.
+	if (ui->cbSources->currentData().toString() == selectedId)
+	{
+		if (sameSampleLayout(_audio.mixFormat(selectedId.toStdWString()), _selectedDeviceFormat))
+			return;
+
+		// The device is still there, but its format has changed.
+		stopPlayback();
+	}
+
+	newDeviceSelected();
+}
+
+void CMainWindow::newDeviceSelected()
+{
+	const auto info = selectedDeviceInfo();
 	const auto fmt = _audio.mixFormat(info.id);
+	_selectedDeviceFormat = fmt;
+
+	// Carry on playing on the new device.
+	if (_audio.isPlaying())
+	{
+		if (const auto gapMs = _audio.switchDevice(info.id))
+			ui->statusbar->showMessage(QString{"Switched to %1, gap: %2 ms"}.arg(QString::fromStdWString(info.friendlyName)).arg(*gapMs, 0, 'f', 2));
+		else
+			stopPlayback();
+	}
+
+	displayDeviceInfo(fmt);
+	if (_audio.isPlaying())
+		displayStreamInfo();
+
 	ui->sbToneFrequency->setMaximum(fmt.sampleRate / 2);
 
-	ui->cbChannel->clear();
-	for (const auto& ch: fmt.channels)
-		ui->cbChannel->addItem(QString::fromStdString(ch.name), ch.index);
-	ui->cbChannel->setCurrentIndex(0);
+	// Keep the same channel playing if the new device has it.
+	{
+		const QSignalBlocker blocker{ ui->cbChannel };
+		const auto channel = ui->cbChannel->currentData();
+		ui->cbChannel->clear();
+		for (const auto& ch: fmt.channels)
+			ui->cbChannel->addItem(QString::fromStdString(ch.name), ch.index);
+		ui->cbChannel->setCurrentIndex(std::max(ui->cbChannel->findData(channel), 0));
+	}
+
+	_audio.setChannelIndex(ui->cbChannel->currentData().toUInt());
+	_analyzer.setChannelIndex(ui->cbChannel->currentData().toUInt());
 }
 
-void CMainWindow::displayDeviceInfo(const CAudioOutputWasapi::DeviceInfo& info)
+void CMainWindow::fillCaptureDeviceList()
 {
-	const auto fmt = _audio.mixFormat(info.id);
+	const auto selectedId = ui->cbCaptureDevices->currentData().toString();
 
+	{
+		const QSignalBlocker blocker{ ui->cbCaptureDevices };
+		ui->cbCaptureDevices->clear();
+		for (const auto& info : _analyzer.devices())
+			ui->cbCaptureDevices->addItem(QString::fromStdWString(info.friendlyName), QString::fromStdWString(info.id));
+
+		if (const int index = ui->cbCaptureDevices->findData(selectedId); index >= 0)
+			ui->cbCaptureDevices->setCurrentIndex(index);
+	}
+
+	ui->cbAnalyzeInput->setEnabled(ui->cbCaptureDevices->count() > 0);
+	// The device being analysed has gone.
+	if (_analyzer.isRunning() && ui->cbCaptureDevices->currentData().toString() != selectedId)
+		startAnalyzer();
+}
+
+void CMainWindow::displayDeviceInfo(const AudioFormat& fmt)
+{
 	QString infoText = "Channel count: " + QString::number(fmt.channels.size()) + '\n';
 	infoText += "Sample rate: " + QString::number(fmt.sampleRate) + '\n';
-	infoText += "Sample size: " + QString::number(fmt.bitsPerSample) + '\n';
+	infoText += "Sample size: " + QString::number(fmt.bitsPerSample);
+	if (fmt.validBitsPerSample != 0 && fmt.validBitsPerSample != fmt.bitsPerSample)
+		infoText += " (" + QString::number(fmt.validBitsPerSample) + " valid)";
+	infoText += '\n';
 	infoText += "Sample type: " + QString{fmt.sampleFormat == AudioFormat::PCM ? "PCM" : "float"} + '\n';
 
 	ui->infoText->setPlainText(infoText);
 }
 
+void CMainWindow::displayStreamInfo()
+{
+	const auto& fmt = _audio.format();
+	const auto latency = _audio.latencyInfo();
+
+	QString infoText = QString{"\nStream (%1 mode): %2 Hz, %3 bit %4\n"}
+		.arg(latency.exclusive ? "exclusive" : "shared")
+		.arg(fmt.sampleRate)
+		.arg(fmt.bitsPerSample)
+		.arg(fmt.sampleFormat == AudioFormat::PCM ? "PCM" : "float");
+	infoText += QString{"Buffer: %1 frames (%2 ms)\n"}.arg(latency.bufferFrames).arg(latency.bufferMs, 0, 'f', 2);
+	infoText += QString{"Period: %1 frames (%2 ms)\n"}.arg(latency.periodFrames).arg(latency.periodMs, 0, 'f', 2);
+	infoText += QString{"Output latency: %1 ms\n"}.arg(latency.outputLatencyMs, 0, 'f', 2);
+	infoText += QString{"Render thread: %1 priority%2"}
+		.arg(latency.realtimePriority ? "real-time" : "normal")
+		.arg(_audio.isMemoryLocked() ? ", memory locked" : "");
+
+	ui->infoText->appendPlainText(infoText);
+}
 
-CAudioOutputWasapi::DeviceInfo CMainWindow::selectedDeviceInfo()
+void CMainWindow::updateRenderStats()
 {
-	if (ui->cbSources->currentIndex() < 0)
-		return {};
+	_audio.collectRenderStats(_renderStats);
+
+	const auto ms = [](uint64_t ns) {
+		return QString::number(static_cast<double>(ns) / 1e6, 'f', 3);
+	};
+
+	const auto& duration = _renderStats.callbackDuration();
+	const auto& jitter = _renderStats.wakeupJitter();
+	QString text = QString{"Callback: p50 %1 / p99 %2 / max %3 ms, peak load %4%   Wakeup jitter: p99 %5 / max %6 ms   Underruns: %7"}
+		.arg(ms(duration.percentile(0.5)), ms(duration.percentile(0.99)), ms(duration.max()))
+		.arg(_renderStats.peakLoad() * 100.0, 0, 'f', 1)
+		.arg(ms(jitter.percentile(0.99)), ms(jitter.max()))
+		.arg(_renderStats.underruns());
+	if (_sequence)
+		text += _sequence->finished() ? QString{"   Sequence finished"} : QString{"   Sequence: line %1"}.arg(_sequence->currentLine());
+
+	ui->lblRenderStats->setText(text);
+}
 
-	const auto selectedId = ui->cbSources->currentData().toString().toStdWString();
-	for (auto&& deviceInfo : _audio.devices())
+void CMainWindow::updateAnalyzerFundamental()
+{
+	const bool tone = ui->cbWaveform->currentData().toInt() < noiseItemId;
+	_analyzer.setFundamental(tone ? static_cast<double>(ui->sbToneFrequency->value()) : 0.0);
+}
+
+void CMainWindow::updateAnalyzerReading()
+{
+	const auto m = _analyzer.measurement();
+	if (m.frames == 0)
 	{
-		if (deviceInfo.id == selectedId)
-			return deviceInfo;
+		ui->lblAnalyzer->setText("Waiting for input...");
+		return;
 	}
 
-	return {};
+	QString text = QString{"%1 Hz: %2 dBFS   THD+N: %3 dB (%4%)   Total: %5 dBFS"}
+		.arg(m.fundamentalHz, 0, 'f', 1)
+		.arg(m.levelDbfs, 0, 'f', 2)
+		.arg(m.thdNDb, 0, 'f', 1)
+		.arg(m.thdNPercent, 0, 'f', 4)
+		.arg(m.totalDbfs, 0, 'f', 2);
+	if (const auto overruns = _analyzer.overruns(); overruns > 0)
+		text += QString{"   Input overruns: %1"}.arg(overruns);
+
+	ui->lblAnalyzer->setText(text);
+}
+
+void CMainWindow::glitchDetected(const GlitchEvent& event)
+{
+	ui->infoText->appendPlainText("Glitch at " + QString::fromStdString(toString(event, _audio.format().sampleRate)));
+	ui->statusbar->showMessage(QString{"Glitches detected: %1"}.arg(_audio.glitchCount()));
+}
+
+
+AudioDeviceInfo CMainWindow::selectedDeviceInfo()
+{
+	if (ui->cbSources->currentIndex() < 0)
+		return {};
+
+	return _audio.device(ui->cbSources->currentData().toString().toStdWString()).value_or(AudioDeviceInfo{});
 }
 
 void CMainWindow::play()
 {
 	const auto deviceInfo = selectedDeviceInfo();
-	auto fmt = _audio.mixFormat(deviceInfo.id);
-	assert_r(fmt.sampleFormat == AudioFormat::Float);
+	const auto fmt = _audio.mixFormat(deviceInfo.id);
+	assert_r(SampleWriter::sampleType(fmt) != SampleWriter::SampleType::Unsupported);
 	assert_and_return_r(ui->cbChannel->currentIndex() >= 0, );
-	_audio.playTone(ui->cbSources->currentData().toString().toStdWString());
+	StreamOptions options;
+	options.exclusive = ui->cbExclusive->isChecked();
+	options.minimumPeriod = ui->cbMinimumPeriod->isChecked();
+	options.realtimePriority = ui->cbRealtime->isChecked();
+	options.lockMemory = ui->cbLockMemory->isChecked();
+	_audio.setStreamOptions(options);
+	_audio.setDitherEnabled(ui->cbDither->isChecked());
+	_renderStats.reset();
+
+	if (ui->cbDetectGlitches->isChecked())
+	{
+		const QString logDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+		QDir{}.mkpath(logDir);
+		_audio.setGlitchDetection(true, QDir{ logDir }.filePath("glitches.log").toStdString(), [this](const GlitchEvent& event) {
+			QMetaObject::invokeMethod(this, [this, event] { glitchDetected(event); }, Qt::QueuedConnection);
+		});
+	}
+	else
+		_audio.setGlitchDetection(false);
+
+	if (!_audio.playTone(ui->cbSources->currentData().toString().toStdWString()))
+		return;
+
+	displayDeviceInfo(fmt);
+	displayStreamInfo();
 
 	_chartUpdateTimer.start(100);
 }
@@ -162,5 +442,91 @@ void CMainWindow::play()
 void CMainWindow::stopPlayback()
 {
 	_chartUpdateTimer.stop();
+	if (!_audio.isPlaying())
+		return;
+
 	_audio.stopPlayback();
+	ui->statusbar->showMessage(QString{"Stopped in %1 ms"}.arg(_audio.lastStopLatencyMs(), 0, 'f', 2));
+}
+
+void CMainWindow::recoverPlayback()
+{
+	// Stopped in the meantime.
+	if (!_audio.isPlaying())
+		return;
+
+	// Don't keep restarting a device that fails right away.
+	const auto now = std::chrono::steady_clock::now();
+	const bool bRetry = now - _lastRecoveryTime > std::chrono::seconds{ 1 };
+	_lastRecoveryTime = now;
+
+	if (bRetry && _audio.recoverPlayback())
+	{
+		ui->statusbar->showMessage("The output stream has failed and has been restarted");
+		displayDeviceInfo(_selectedDeviceFormat);
+		displayStreamInfo();
+		return;
+	}
+
+	stopPlayback();
+	ui->statusbar->showMessage("The output stream has failed");
+}
+
+void CMainWindow::exportRenderStats()
+{
+	const QString path = QFileDialog::getSaveFileName(this, "Export render stats", "render_stats.json", "JSON (*.json);;CSV (*.csv)");
+	if (path.isEmpty())
+		return;
+
+	_audio.collectRenderStats(_renderStats);
+	const std::string text = path.endsWith(".csv", Qt::CaseInsensitive) ? _renderStats.toCsv() : _renderStats.toJson();
+
+	QFile file{ path };
+	const auto size = static_cast<qint64>(text.size());
+	if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(text.data(), size) != size)
+	{
+		ui->statusbar->showMessage("Failed to write " + path);
+		return;
+	}
+
+	ui->statusbar->showMessage("Render stats saved to " + path);
+}
+
+void CMainWindow::runSequence()
+{
+	const QString path = QFileDialog::getOpenFileName(this, "Play a sequence", {}, "Sequences (*.txt *.seq);;All files (*)");
+	if (path.isEmpty())
+		return;
+
+	std::string error;
+	auto sequence = Sequence::load(path.toStdString(), error);
+	if (!sequence)
+	{
+		ui->statusbar->showMessage(QString{"%1: %2"}.arg(QFileInfo{ path }.fileName(), QString::fromStdString(error)));
+		return;
+	}
+
+	_sequence = std::move(sequence);
+	_audio.startSequence(_sequence);
+	ui->statusbar->showMessage(QString{"Sequence of %1 s"}.arg(_sequence->seconds(), 0, 'f', 1));
+	if (!_audio.isPlaying())
+		play();
+}
+
+void CMainWindow::startAnalyzer()
+{
+	_analyzerTimer.stop();
+	_analyzer.stop();
+	ui->lblAnalyzer->clear();
+	if (!ui->cbAnalyzeInput->isChecked() || ui->cbCaptureDevices->currentIndex() < 0)
+		return;
+
+	if (!_analyzer.start(ui->cbCaptureDevices->currentData().toString().toStdWString()))
+	{
+		ui->statusbar->showMessage("Failed to start capturing from " + ui->cbCaptureDevices->currentText());
+		return;
+	}
+
+	// The measurement is updated 10 - 12 times a second.
+	_analyzerTimer.start(50);
 }
@@ -1,13 +1,22 @@
 #pragma once
-#include "audio/caudiooutputwasapi.h"
+#include "audio/caudioengine.h"
+#include "audio/ccaptureanalyzer.h"
+#include "waveformenvelope.h"
 #include "compiler/compiler_warnings_control.h"
 
 DISABLE_COMPILER_WARNINGS
 #include <QMainWindow>
 #include <QChart>
+#include <QLineSeries>
 #include <QTimer>
+#include <QValueAxis>
+#include <QVector>
 RESTORE_COMPILER_WARNINGS
 
+#include <chrono>
+#include <memory>
+#include <vector>
+
 QT_CHARTS_USE_NAMESPACE
 
 namespace Ui {
@@ -23,21 +32,60 @@ public:
 private:
 	void setupChart();
 
+	// (Re)fills the device combobox, keeping the current selection if that device is still there.
+	void fillDeviceList();
 	void newDeviceSelected();
+	void fillCaptureDeviceList();
 
-	void displayDeviceInfo(const CAudioOutputWasapi::DeviceInfo& info);
-	CAudioOutputWasapi::DeviceInfo selectedDeviceInfo();
+	void displayDeviceInfo(const AudioFormat& fmt);
+	void displayStreamInfo();
+	// Collects the render callback records and shows the percentiles and glitch counters.
+	void updateRenderStats();
+	// The tone being played is what the input analyzer measures; 0 (the strongest component) for noise.
+	void updateAnalyzerFundamental();
+	void updateAnalyzerReading();
+	AudioDeviceInfo selectedDeviceInfo();
 
 // Slots
 	void play();
 	void stopPlayback();
+	// The stream has failed on the render thread.
+	void recoverPlayback();
+	void glitchDetected(const GlitchEvent& event);
+	void exportRenderStats();
+	// Compiles a sequence file and plays it, starting the playback if need be.
+	void runSequence();
+	// (Re)starts or stops the input analyzer as cbAnalyzeInput and cbCaptureDevices say.
+	void startAnalyzer();
 
 private:
 	Ui::CMainWindow *ui;
 
-	CAudioOutputWasapi _audio;
+	CAudioEngine _audio{ createDefaultAudioBackend() };
+	// The mix format of the device selected in cbSources, as displayed.
+	AudioFormat _selectedDeviceFormat{};
 
 	QChart _chart;
+	QValueAxis* _axisX = nullptr;
+	QValueAxis* _axisY = nullptr;
+	std::vector<QLineSeries*> _channelSeries;
+
+	WaveformEnvelope _waveformEnvelope;
+	// _waveformEnvelope's points for the series, two per channel, used in turns.
+	std::vector<QVector<QPointF>> _envelopePoints;
+	size_t _envelopeBufferIndex = 0;
 
 	QTimer _chartUpdateTimer;
+
+	CCaptureAnalyzer _analyzer{ createDefaultAudioCapture() };
+	// Runs while the analyzer does, with or without the playback.
+	QTimer _analyzerTimer;
+
+	// Since the last play().
+	RenderStats _renderStats;
+
+	std::chrono::steady_clock::time_point _lastRecoveryTime;
+
+	// The sequence being played, for the progress display; reset by any other signal.
+	std::shared_ptr<Sequence> _sequence;
 };
@@ -0,0 +1,475 @@
+#include "ccontrolserver.h"
+
+#include "assert/advanced_assert.h"
+
+#if defined _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+// How often the applied change reports are collected while no requests come in.
+static constexpr long pollIntervalUs = 10000;
+// A client sending more than this without a line break is disconnected.
+static constexpr size_t maxRequestLength = 64 * 1024;
+
+#if defined _WIN32
+static constexpr intptr_t invalidSocket = static_cast<intptr_t>(INVALID_SOCKET);
+
+static void closeSocket(const intptr_t s)
+{
+	::closesocket(static_cast<SOCKET>(s));
+}
+#else
+static constexpr intptr_t invalidSocket = -1;
+
+static void closeSocket(const intptr_t s)
+{
+	::close(static_cast<int>(s));
+}
+#endif
+
+static int64_t steadyTimeNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Device names are wide strings: UTF-16 on Windows, UTF-32 elsewhere.
+static std::string toUtf8(const std::wstring& str)
+{
+	std::string result;
+	for (size_t i = 0; i < str.size(); ++i)
+	{
+		auto codePoint = static_cast<uint32_t>(str[i]);
+		if (codePoint >= 0xD800 && codePoint < 0xDC00 && i + 1 < str.size())
+			codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (static_cast<uint32_t>(str[++i]) - 0xDC00);
+
+		if (codePoint < 0x80)
+			result.push_back(static_cast<char>(codePoint));
+		else if (codePoint < 0x800)
+		{
+			result.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+			result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		else if (codePoint < 0x10000)
+		{
+			result.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+			result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		else
+		{
+			result.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+			result.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+			result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+	}
+
+	return result;
+}
+
+CControlServer::CControlServer(CAudioEngine& engine) :
+	_engine{ engine }
+{
+#if defined _WIN32
+	WSADATA wsaData;
+	assert_r(::WSAStartup(MAKEWORD(2, 2), &wsaData) == 0);
+#endif
+}
+
+CControlServer::~CControlServer()
+{
+	while (!_clients.empty())
+		closeClient(_clients.size() - 1);
+
+	if (_listenSocket != invalidSocket)
+		closeSocket(_listenSocket);
+
+#if !defined _WIN32
+	if (!_socketPath.empty())
+		::unlink(_socketPath.c_str());
+#else
+	::WSACleanup();
+#endif
+}
+
+bool CControlServer::listen(const std::string& endpoint)
+{
+	assert_and_return_r(_listenSocket == invalidSocket, false);
+	assert_and_return_message_r(!endpoint.empty(), "No endpoint to listen on", false);
+
+	const bool bTcp = endpoint.find_first_not_of("0123456789") == std::string::npos;
+	if (bTcp)
+	{
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(static_cast<uint16_t>(std::strtoul(endpoint.c_str(), nullptr, 10)));
+		// Local clients only: the protocol has no authentication.
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		_listenSocket = static_cast<Socket>(::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+		assert_and_return_message_r(_listenSocket != invalidSocket, "Failed to create a TCP socket", false);
+
+		const int reuse = 1;
+		::setsockopt(_listenSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+		if (::bind(_listenSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+		{
+			closeSocket(_listenSocket);
+			_listenSocket = invalidSocket;
+			assert_unconditional_r("Failed to bind to 127.0.0.1:" + endpoint);
+			return false;
+		}
+	}
+	else
+	{
+#if defined _WIN32
+		assert_unconditional_r("Unix domain sockets are not supported on Windows, use a TCP port");
+		return false;
+#else
+		sockaddr_un address{};
+		address.sun_family = AF_UNIX;
+		assert_and_return_message_r(endpoint.size() < sizeof(address.sun_path), "Socket path too long: " + endpoint, false);
+		std::memcpy(address.sun_path, endpoint.c_str(), endpoint.size() + 1);
+
+		_listenSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		assert_and_return_message_r(_listenSocket != invalidSocket, "Failed to create a Unix domain socket", false);
+
+		// A stale socket file left by a server that hasn't exited cleanly.
+		::unlink(endpoint.c_str());
+		if (::bind(static_cast<int>(_listenSocket), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+		{
+			closeSocket(_listenSocket);
+			_listenSocket = invalidSocket;
+			assert_unconditional_r("Failed to bind to " + endpoint);
+			return false;
+		}
+
+		_socketPath = endpoint;
+#endif
+	}
+
+	assert_and_return_message_r(::listen(_listenSocket, SOMAXCONN) == 0, "listen() failed", false);
+	return true;
+}
+
+void CControlServer::run()
+{
+	assert_and_return_r(_listenSocket != invalidSocket, );
+
+	std::array<char, 4096> buffer;
+	while (!_bQuit)
+	{
+		fd_set readable;
+		FD_ZERO(&readable);
+		FD_SET(_listenSocket, &readable);
+		Socket maxSocket = _listenSocket;
+		for (const Client& client : _clients)
+		{
+			FD_SET(client.socket, &readable);
+			maxSocket = std::max(maxSocket, client.socket);
+		}
+
+		timeval timeout{ 0, pollIntervalUs };
+		const int nReady = ::select(static_cast<int>(maxSocket + 1), &readable, nullptr, nullptr, &timeout);
+		collectAppliedChanges();
+		if (nReady <= 0)
+			continue;
+
+		if (FD_ISSET(_listenSocket, &readable))
+		{
+			const auto socket = static_cast<Socket>(::accept(_listenSocket, nullptr, nullptr));
+			if (socket != invalidSocket)
+				_clients.push_back({ socket, {} });
+		}
+
+		for (size_t i = 0; i < _clients.size() && !_bQuit; )
+		{
+			if (!FD_ISSET(_clients[i].socket, &readable))
+			{
+				++i;
+				continue;
+			}
+
+			const auto nBytes = ::recv(_clients[i].socket, buffer.data(), static_cast<int>(buffer.size()), 0);
+			if (nBytes <= 0)
+			{
+				closeClient(i);
+				continue;
+			}
+
+			Client& client = _clients[i];
+			client.pending.append(buffer.data(), static_cast<size_t>(nBytes));
+			for (size_t lineEnd = client.pending.find('\n'); lineEnd != std::string::npos && !_bQuit; lineEnd = client.pending.find('\n'))
+			{
+				const std::string reply = execute(client.pending.substr(0, lineEnd)) + '\n';
+				client.pending.erase(0, lineEnd + 1);
+				// Blocking: the client is expected to read the reply before sending more.
+				::send(client.socket, reply.data(), static_cast<int>(reply.size()), 0);
+			}
+
+			if (client.pending.size() > maxRequestLength)
+			{
+				const std::string reply = "ERR request too long\n";
+				::send(client.socket, reply.data(), static_cast<int>(reply.size()), 0);
+				closeClient(i);
+				continue;
+			}
+
+			++i;
+		}
+	}
+}
+
+std::string CControlServer::execute(const std::string& request)
+{
+	const int64_t receivedNs = steadyTimeNs();
+
+	std::vector<ControlCommand> commands;
+	std::string error;
+	if (!parseRequest(request, commands, error))
+		return "ERR " + error;
+
+	// Enumerating the devices builds a new list every time; only the requests that need it pay for that.
+	const bool bNeedDevices = std::any_of(commands.cbegin(), commands.cend(), [](const ControlCommand& command) {
+		return command.type == ControlCommand::Play || command.type == ControlCommand::Devices;
+	});
+	const auto devices = bNeedDevices ? _engine.devices() : std::vector<AudioDeviceInfo>{};
+	error = check(commands, devices);
+	if (!error.empty())
+		return "ERR " + error;
+
+	// Compiled up front so that a bad file fails the whole request.
+	std::vector<std::shared_ptr<Sequence>> sequences;
+	for (const ControlCommand& command : commands)
+	{
+		if (command.type != ControlCommand::Sequence)
+			continue;
+
+		auto sequence = Sequence::load(command.filePath, error);
+		if (!sequence)
+			return "ERR " + error;
+
+		sequences.push_back(std::move(sequence));
+	}
+
+	// The relative frames count from the position at the start of the request, or from that right after its last play or stop.
+	bool bPlaying = _engine.isPlaying();
+	uint64_t position = _engine.playbackPosition();
+
+	std::ostringstream reply;
+	reply << "OK";
+	std::ostringstream deviceLines;
+	size_t nSequencesStarted = 0;
+	for (size_t i = 0; i < commands.size(); ++i)
+	{
+		const ControlCommand& command = commands[i];
+		switch (command.type)
+		{
+		case ControlCommand::Change:
+		{
+			ScheduledChange change = command.change;
+			if (command.timing == ControlCommand::AfterFrames)
+				change.frame += position;
+			change.id = _nextChangeId++;
+
+			_changes.push_back(change);
+			// Only the immediate ones: the rest are delayed on purpose.
+			if (bPlaying && command.timing == ControlCommand::Now)
+				_changeTimes[change.id] = receivedNs;
+			break;
+		}
+		case ControlCommand::Sweep:
+			// Same as for a sequence.
+			flushChanges();
+			_engine.startSweep(command.sweep);
+			break;
+		case ControlCommand::Oscillators:
+			flushChanges();
+			_engine.setOscillators(command.oscillators);
+			break;
+		case ControlCommand::Sequence:
+			// The changes made before it must not override it.
+			flushChanges();
+			_sequence = sequences[nSequencesStarted++];
+			_engine.startSequence(_sequence);
+			reply << " sequence_seconds=" << _sequence->seconds();
+			break;
+		case ControlCommand::Dither:
+			_engine.setDitherEnabled(command.dither);
+			break;
+		case ControlCommand::Play:
+			flushChanges();
+			_changeTimes.clear();
+			if (!_engine.playTone(devices[command.deviceIndex].id))
+				return "ERR command " + std::to_string(i + 1) + ": failed to start the playback";
+
+			bPlaying = true;
+			position = _engine.playbackPosition();
+			break;
+		case ControlCommand::Stop:
+			flushChanges();
+			_engine.stopPlayback();
+			_changeTimes.clear();
+			bPlaying = false;
+			position = 0;
+			break;
+		case ControlCommand::Position:
+			reply << " position=" << _engine.playbackPosition() << " rate=" << _engine.format().sampleRate;
+			break;
+		case ControlCommand::Status:
+		{
+			const bool bPlayingNow = _engine.isPlaying();
+			reply << " playing=" << (bPlayingNow ? 1 : 0) << " position=" << _engine.playbackPosition();
+			if (bPlayingNow)
+			{
+				reply << " rate=" << _engine.format().sampleRate << " channels=" << _engine.format().channels.size()
+					<< " output_latency_ms=" << _engine.latencyInfo().outputLatencyMs;
+			}
+
+			reply << " underruns=" << _engine.underruns() << " deadline_misses=" << _engine.deadlineMisses();
+			if (_sequence)
+				reply << " sequence_line=" << _sequence->currentLine() << " sequence_finished=" << (_sequence->finished() ? 1 : 0);
+			break;
+		}
+		case ControlCommand::Latency:
+			collectAppliedChanges();
+			reply << " late=" << _lateChanges << " count=" << _latency.count();
+			if (_latency.count() > 0)
+			{
+				reply << " last_ms=" << _lastLatencyUs / 1000.0 << " min_ms=" << _latency.min() / 1000.0
+					<< " p50_ms=" << _latency.percentile(0.5) / 1000.0 << " p99_ms=" << _latency.percentile(0.99) / 1000.0
+					<< " max_ms=" << _latency.max() / 1000.0;
+			}
+			break;
+		case ControlCommand::ResetLatency:
+			_latency.reset();
+			_lastLatencyUs = 0;
+			_lateChanges = 0;
+			break;
+		case ControlCommand::Devices:
+			reply << " devices=" << devices.size();
+			for (size_t i = 0; i < devices.size(); ++i)
+				deviceLines << '\n' << i << ' ' << toUtf8(devices[i].friendlyName);
+			break;
+		case ControlCommand::Quit:
+			_engine.stopPlayback();
+			_bQuit = true;
+			break;
+		}
+	}
+
+	flushChanges();
+
+	return reply.str() + deviceLines.str();
+}
+
+std::string CControlServer::check(const std::vector<ControlCommand>& commands, const std::vector<AudioDeviceInfo>& devices) const
+{
+	bool bPlaying = _engine.isPlaying();
+	// The channel count is only known for the stream that is already running.
+	bool bCurrentStream = bPlaying;
+	for (size_t i = 0; i < commands.size(); ++i)
+	{
+		const ControlCommand& command = commands[i];
+		const std::string prefix = "command " + std::to_string(i + 1) + ": ";
+		if (command.type == ControlCommand::Play)
+		{
+			if (bPlaying)
+				return prefix + "already playing";
+			if (command.deviceIndex >= devices.size())
+				return prefix + "no device #" + std::to_string(command.deviceIndex);
+
+			bPlaying = true;
+		}
+		else if (command.type == ControlCommand::Stop)
+		{
+			bPlaying = false;
+			bCurrentStream = false;
+		}
+		else if (command.type == ControlCommand::Change && command.change.parameter == ScheduledChange::Channel && bCurrentStream
+			&& command.change.value >= static_cast<double>(_engine.format().channels.size()))
+		{
+			return prefix + "the device has " + std::to_string(_engine.format().channels.size()) + " channels";
+		}
+		else if (command.type == ControlCommand::Oscillators && bCurrentStream)
+		{
+			const size_t nChannels = _engine.format().channels.size();
+			if (std::any_of(command.oscillators.cbegin(), command.oscillators.cend(), [nChannels](const OscillatorBank::Oscillator& o) { return o.channelIndex >= nChannels; }))
+				return prefix + "the device has " + std::to_string(nChannels) + " channels";
+		}
+	}
+
+	// The engine only frees room while this thread waits, so a request that fits now can't fail halfway through for lack of it.
+	// The new generators are handed over with a change each.
+	const size_t nChanges = static_cast<size_t>(std::count_if(commands.cbegin(), commands.cend(), [](const ControlCommand& command) {
+		return command.type == ControlCommand::Change || command.type == ControlCommand::Sweep
+			|| command.type == ControlCommand::Oscillators || command.type == ControlCommand::Sequence;
+	}));
+	if (nChanges > _engine.schedulableChanges())
+		return "too many changes pending";
+
+	return {};
+}
+
+void CControlServer::flushChanges()
+{
+	if (_changes.empty())
+		return;
+
+	// Immediate changes are due at frame 0, i.e. right away; the order of the changes due at the same frame is kept.
+	std::stable_sort(_changes.begin(), _changes.end(), [](const ScheduledChange& l, const ScheduledChange& r) { return l.frame < r.frame; });
+	// check() has made sure there's room.
+	if (!_engine.scheduleChanges(_changes.data(), _changes.size()))
+	{
+		assert_unconditional_r("The engine has rejected " + std::to_string(_changes.size()) + " changes");
+		for (const ScheduledChange& change : _changes)
+			_changeTimes.erase(change.id);
+	}
+
+	_changes.clear();
+}
+
+void CControlServer::collectAppliedChanges()
+{
+	const auto outputLatencyNs = static_cast<int64_t>(_engine.latencyInfo().outputLatencyMs * 1e6);
+	std::array<AppliedChange, 64> applied;
+	while (const size_t n = _engine.appliedChanges(applied.data(), applied.size()))
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			const auto it = _changeTimes.find(applied[i].id);
+			if (it == _changeTimes.end())
+			{
+				// Scheduled for a frame that had already been rendered by the time it reached the render thread.
+				if (applied[i].renderedFrame > applied[i].frame)
+					++_lateChanges;
+				continue;
+			}
+
+			const int64_t latencyNs = applied[i].timestampNs + outputLatencyNs - it->second;
+			_lastLatencyUs = static_cast<uint64_t>(std::max<int64_t>(latencyNs, 0) / 1000);
+			_latency.record(_lastLatencyUs);
+			_changeTimes.erase(it);
+		}
+	}
+}
+
+void CControlServer::closeClient(const size_t index)
+{
+	closeSocket(_clients[index].socket);
+	_clients.erase(_clients.begin() + static_cast<ptrdiff_t>(index));
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "controlprotocol.h"
+#include "../audio/caudioengine.h"
+#include "../audio/renderstats.h"
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Serves the control protocol (see controlprotocol.h) to local clients, on a Unix domain socket or on a TCP port bound to
+// the loopback interface (the only option on Windows). Any number of clients; requests are executed one at a time in the order they come in.
+// Every change to the tone is handed to the engine as a ScheduledChange, so a request's changes are applied in the same render callback
+// (or exactly at their frames), and the time from receiving a change to it becoming audible is measured from the engine's AppliedChange reports.
+class CControlServer final
+{
+public:
+	explicit CControlServer(CAudioEngine& engine);
+	~CControlServer();
+
+	// endpoint is a port number or a socket path.
+	bool listen(const std::string& endpoint);
+	// Serves the clients until one of them sends "quit".
+	void run();
+
+	// Executes one request line and returns the reply, without the line break. run() calls it for every line received.
+	[[nodiscard]] std::string execute(const std::string& request);
+
+private:
+	[[nodiscard]] std::string check(const std::vector<ControlCommand>& commands, const std::vector<AudioDeviceInfo>& devices) const;
+	// Hands the changes collected so far to the engine.
+	void flushChanges();
+	// Matches the engine's AppliedChange reports against the changes sent.
+	void collectAppliedChanges();
+
+	void closeClient(size_t index);
+
+private:
+	using Socket = intptr_t;
+
+	struct Client {
+		Socket socket;
+		// Received data short of a complete line, up to maxRequestLength.
+		std::string pending;
+	};
+
+	CAudioEngine& _engine;
+
+	Socket _listenSocket = -1;
+	std::string _socketPath;
+	std::vector<Client> _clients;
+	bool _bQuit = false;
+
+	std::vector<ScheduledChange> _changes;
+	uint32_t _nextChangeId = 1;
+	// steady_clock time of receipt of the immediate changes made during playback, by id.
+	std::unordered_map<uint32_t, int64_t> _changeTimes;
+	// Command-to-audible latency in us.
+	LatencyHistogram _latency;
+	uint64_t _lastLatencyUs = 0;
+	uint64_t _lateChanges = 0;
+
+	// The last one started, for "status".
+	std::shared_ptr<Sequence> _sequence;
+};
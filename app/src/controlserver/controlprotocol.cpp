@@ -0,0 +1,291 @@
+#include "controlprotocol.h"
+#include "../audio/wavetable.h"
+
+#include <cctype>
+#include <cmath>
+#include <sstream>
+
+// Each one costs about a nanosecond per frame on the render thread.
+static constexpr size_t maxMultitoneTones = 4096;
+
+// Reads "freq <Hz>", "gain <dBFS>", "channel <index>" or "waveform <name>" starting with the word already read.
+static bool parseChange(const std::string& word, std::istringstream& fields, ScheduledChange& change, std::string& error)
+{
+	if (word == "freq")
+	{
+		change.parameter = ScheduledChange::Frequency;
+		if (!(fields >> change.value) || !std::isfinite(change.value) || change.value <= 0.0)
+		{
+			error = "freq takes a frequency in Hz";
+			return false;
+		}
+	}
+	else if (word == "gain")
+	{
+		double db = 0.0;
+		change.parameter = ScheduledChange::Gain;
+		if (!(fields >> db) || !std::isfinite(db))
+		{
+			error = "gain takes a level in dBFS";
+			return false;
+		}
+
+		change.value = std::pow(10.0, db / 20.0);
+	}
+	else if (word == "channel")
+	{
+		size_t channel = 0;
+		change.parameter = ScheduledChange::Channel;
+		if (!(fields >> channel))
+		{
+			error = "channel takes a channel index";
+			return false;
+		}
+
+		change.value = static_cast<double>(channel);
+	}
+	else if (word == "waveform")
+	{
+		std::string name;
+		fields >> name;
+		change.parameter = ScheduledChange::Waveform;
+		const auto waveform = waveformFromName(name);
+		if (!waveform)
+		{
+			error = "unknown waveform '" + name + "'";
+			return false;
+		}
+
+		change.value = static_cast<double>(*waveform);
+	}
+	else
+	{
+		error = "unknown command '" + word + "'";
+		return false;
+	}
+
+	return true;
+}
+
+// Reads "<Hz>:<channel>[:<dBFS>]".
+static bool parseOscillator(const std::string& text, OscillatorBank::Oscillator& oscillator)
+{
+	std::istringstream fields{ text };
+	double hz = 0.0, db = 0.0;
+	char separator = 0;
+	if (!(fields >> hz >> separator >> oscillator.channelIndex) || separator != ':' || !std::isfinite(hz) || hz <= 0.0)
+		return false;
+
+	if (fields.peek() == ':')
+	{
+		fields.get();
+		if (!(fields >> db) || !std::isfinite(db))
+			return false;
+	}
+
+	oscillator.hz = static_cast<float>(hz);
+	oscillator.gain = static_cast<float>(std::pow(10.0, db / 20.0));
+	return fields.peek() == std::char_traits<char>::eof();
+}
+
+static bool parseCommand(const std::string& text, ControlCommand& command, std::string& error)
+{
+	std::istringstream fields{ text };
+	std::string word;
+	if (!(fields >> word))
+	{
+		error = "empty command";
+		return false;
+	}
+
+	if (word == "play")
+	{
+		command.type = ControlCommand::Play;
+		if (!(fields >> std::ws).eof() && !(fields >> command.deviceIndex))
+		{
+			error = "play takes a device index";
+			return false;
+		}
+	}
+	else if (word == "stop")
+		command.type = ControlCommand::Stop;
+	else if (word == "position")
+		command.type = ControlCommand::Position;
+	else if (word == "status")
+		command.type = ControlCommand::Status;
+	else if (word == "devices")
+		command.type = ControlCommand::Devices;
+	else if (word == "quit")
+		command.type = ControlCommand::Quit;
+	else if (word == "latency")
+	{
+		std::string argument;
+		fields >> argument;
+		if (!argument.empty() && argument != "reset")
+		{
+			error = "latency takes no argument other than 'reset'";
+			return false;
+		}
+
+		command.type = argument.empty() ? ControlCommand::Latency : ControlCommand::ResetLatency;
+	}
+	else if (word == "sweep")
+	{
+		command.type = ControlCommand::Sweep;
+		SweepParams& sweep = command.sweep;
+		if (!(fields >> sweep.f0 >> sweep.f1 >> sweep.seconds) || !std::isfinite(sweep.f0) || !std::isfinite(sweep.f1) || !std::isfinite(sweep.seconds)
+			|| sweep.f0 <= 0.0 || sweep.f1 <= 0.0 || sweep.seconds <= 0.0)
+		{
+			error = "sweep takes two frequencies in Hz and a duration in seconds";
+			return false;
+		}
+
+		for (std::string option; fields >> option;)
+		{
+			if (option == "lin")
+				sweep.shape = SweepParams::Linear;
+			else if (option == "log")
+				sweep.shape = SweepParams::Logarithmic;
+			else if (option == "repeat")
+				sweep.repeat = true;
+			else
+			{
+				error = "unexpected '" + option + "'";
+				return false;
+			}
+		}
+	}
+	else if (word == "oscillators")
+	{
+		command.type = ControlCommand::Oscillators;
+		for (std::string text; fields >> text;)
+		{
+			OscillatorBank::Oscillator oscillator;
+			if (!parseOscillator(text, oscillator))
+			{
+				error = "invalid oscillator '" + text + "', expected <Hz>:<channel>[:<dBFS>]";
+				return false;
+			}
+
+			command.oscillators.push_back(oscillator);
+		}
+
+		if (command.oscillators.empty())
+		{
+			error = "oscillators takes at least one <Hz>:<channel>[:<dBFS>]";
+			return false;
+		}
+	}
+	else if (word == "multitone")
+	{
+		command.type = ControlCommand::Oscillators;
+		double f0 = 0.0, f1 = 0.0, peakDb = 0.0;
+		size_t nTones = 0, channel = 0;
+		if (!(fields >> f0 >> f1 >> nTones >> channel) || !std::isfinite(f0) || !std::isfinite(f1) || f0 <= 0.0 || f1 <= 0.0
+			|| nTones == 0 || nTones > maxMultitoneTones)
+		{
+			error = "multitone takes two frequencies in Hz, a tone count of up to " + std::to_string(maxMultitoneTones) + " and a channel index";
+			return false;
+		}
+
+		if (!(fields >> std::ws).eof() && (!(fields >> peakDb) || !std::isfinite(peakDb)))
+		{
+			error = "the multitone peak is a level in dBFS";
+			return false;
+		}
+
+		command.oscillators = OscillatorBank::multitone(f0, f1, nTones, channel, static_cast<float>(std::pow(10.0, peakDb / 20.0)));
+	}
+	else if (word == "dither")
+	{
+		command.type = ControlCommand::Dither;
+		std::string state;
+		fields >> state;
+		if (state != "on" && state != "off")
+		{
+			error = "dither takes on or off";
+			return false;
+		}
+
+		command.dither = state == "on";
+	}
+	else if (word == "sequence")
+	{
+		command.type = ControlCommand::Sequence;
+		// The rest of the command, spaces and all.
+		std::getline(fields >> std::ws, command.filePath);
+		command.filePath.erase(command.filePath.find_last_not_of(" \t\r") + 1);
+		if (command.filePath.empty())
+		{
+			error = "sequence takes a file path";
+			return false;
+		}
+	}
+	else if (word == "at")
+	{
+		command.type = ControlCommand::Change;
+		command.timing = (fields >> std::ws).peek() == '+' ? ControlCommand::AfterFrames : ControlCommand::AtFrame;
+		if (command.timing == ControlCommand::AfterFrames)
+			fields.get();
+
+		// The stream would take a sign as well, wrapping a negative number around to a frame that never comes.
+		std::string changeWord;
+		if (!std::isdigit(fields.peek()) || !(fields >> command.change.frame >> changeWord))
+		{
+			error = "at takes a frame number and a command";
+			return false;
+		}
+
+		if (changeWord != "freq" && changeWord != "gain" && changeWord != "channel" && changeWord != "waveform")
+		{
+			error = "only freq, gain, channel and waveform can be scheduled";
+			return false;
+		}
+
+		if (!parseChange(changeWord, fields, command.change, error))
+			return false;
+	}
+	else
+	{
+		command.type = ControlCommand::Change;
+		if (!parseChange(word, fields, command.change, error))
+			return false;
+	}
+
+	if (fields >> word)
+	{
+		error = "unexpected '" + word + "'";
+		return false;
+	}
+
+	return true;
+}
+
+bool parseRequest(const std::string& line, std::vector<ControlCommand>& commands, std::string& error)
+{
+	commands.clear();
+
+	std::istringstream request{ line };
+	for (std::string text; std::getline(request, text, ';');)
+	{
+		if (text.find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+
+		ControlCommand command;
+		if (!parseCommand(text, command, error))
+		{
+			error = "command " + std::to_string(commands.size() + 1) + ": " + error;
+			return false;
+		}
+
+		commands.push_back(command);
+	}
+
+	if (commands.empty())
+	{
+		error = "empty request";
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "../audio/oscillator.h"
+#include "../audio/oscillatorbank.h"
+#include "../audio/scheduledchange.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// The control server's line protocol. A request is one line of commands separated by ';', all of which are parsed and checked
+// before any is executed; the reply is one line, "OK" followed by the commands' results as space-separated key=value fields,
+// or "ERR <message>" if nothing has been executed. The one error that only shows while executing is a device failing to start:
+// "ERR command <n>: failed to start the playback", the commands before the n-th (counting from 1) having been executed.
+//
+//   play [device index]            Starts the playback on a device from the "devices" list, the first one by default.
+//                                  An error if already playing.
+//   stop
+//   freq <Hz>                      Switches to a constant tone at the next render callback.
+//   gain <dBFS>
+//   channel <index>
+//   waveform sine|square|sawtooth|triangle|pulse
+//   sweep <f0> <f1> <seconds> [lin|log] [repeat]
+//                                  A logarithmic (by default) or linear sweep from f0 to f1 Hz, holding f1 at the end unless "repeat"
+//                                  is given. Runs until the next freq, sweep, oscillators, multitone or sequence command.
+//   oscillators <Hz>:<channel>[:<dBFS>] ...
+//                                  Any number of simultaneous sine tones (see OscillatorBank), e.g. "oscillators 440:0 1000:1:-6 1500:1:-6".
+//                                  Play until the next freq, sweep, oscillators, multitone or sequence command.
+//   multitone <f0> <f1> <count> <channel> [<peak dBFS>]
+//                                  count log-spaced sines from f0 to f1 Hz on one channel with a peak of at most <peak dBFS> (0 by default).
+//   sequence <file path>           Compiles a sequence file (see Sequence) and plays it from its first step.
+//   at <frame> <freq|gain|channel|waveform command>
+//                                  The change takes effect exactly at that frame since "play"; "at +<frames> ..." counts
+//                                  from the current playback position (after a "play" in the same request: the position right after it).
+//   dither on|off                  TPDF dither for devices that take integer samples, on by default. Takes effect from the next "play".
+//   position                       position=<frames rendered> rate=<sample rate>
+//   status                         playing, position, rate, channels, output latency and underrun / deadline miss counts,
+//                                  and the progress of the last sequence started.
+//   latency [reset]                The command-to-audible latency of the immediate changes made during playback (count, last, min,
+//                                  p50, p99, max), and how many "at" changes have come too late for their frame.
+//   devices                        devices=<count>, followed by one line per device: "<index> <name>".
+//   quit                           Stops the playback and the server.
+//
+// Example: "freq 1000; channel 0; play; at +48000 freq 2000; at +48000 channel 3".
+struct ControlCommand {
+	enum Type { Play, Stop, Change, Sweep, Oscillators, Sequence, Dither, Position, Status, Latency, ResetLatency, Devices, Quit };
+	enum Timing { Now, AtFrame, AfterFrames };
+
+	Type type = Status;
+
+	// Change only. change.frame is the frame for AtFrame, the number of frames from the current position for AfterFrames.
+	ScheduledChange change;
+	Timing timing = Now;
+
+	// Play only.
+	size_t deviceIndex = 0;
+	// Sweep only.
+	SweepParams sweep;
+	// Oscillators only, multitone included.
+	std::vector<OscillatorBank::Oscillator> oscillators;
+	// Sequence only.
+	std::string filePath;
+	// Dither only.
+	bool dither = true;
+};
+
+// Returns false, with the message in error, on a syntax error.
+[[nodiscard]] bool parseRequest(const std::string& line, std::vector<ControlCommand>& commands, std::string& error);
@@ -0,0 +1,85 @@
+#include "ccontrolserver.h"
+#include "assert/advanced_assert.h"
+#include "system/win_utils.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+static void printUsage()
+{
+	std::cout << "Usage:\n"
+		"  ToneControlServer [--exclusive] [--min-period] [--cpu <index>] [--lock-memory] [--ramp <shape> <ms>] <TCP port | Unix socket path>\n"
+		"--ramp sets the gain ramps' shape (linear, equal-power or raised-cosine, the default) and length (10 ms by default).\n"
+		"The server only accepts local connections; see controlprotocol.h for the commands.\n";
+}
+
+static bool parseRampShape(const std::string& name, RampShape& shape)
+{
+	if (name == "linear")
+		shape = RampShape::Linear;
+	else if (name == "equal-power")
+		shape = RampShape::EqualPower;
+	else if (name == "raised-cosine")
+		shape = RampShape::RaisedCosine;
+	else
+		return false;
+
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	AdvancedAssert::setLoggingFunc([](const char* msg) {
+		std::cerr << msg << std::endl;
+	});
+
+	StreamOptions options;
+	RampShape rampShape = RampShape::RaisedCosine;
+	double rampMs = 10.0;
+	std::string endpoint;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg{ argv[i] };
+		if (arg == "--exclusive")
+			options.exclusive = true;
+		else if (arg == "--min-period")
+			options.minimumPeriod = true;
+		else if (arg == "--lock-memory")
+			options.lockMemory = true;
+		else if (arg == "--cpu" && i + 1 < argc)
+			options.cpuAffinity = std::atoi(argv[++i]);
+		else if (arg == "--ramp" && i + 2 < argc && parseRampShape(argv[i + 1], rampShape))
+		{
+			rampMs = std::atof(argv[i + 2]);
+			i += 2;
+		}
+		else if (arg[0] != '-' && endpoint.empty())
+			endpoint = arg;
+		else
+		{
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (endpoint.empty())
+	{
+		printUsage();
+		return 1;
+	}
+
+	CO_INIT_HELPER(COINIT_MULTITHREADED);
+
+	CAudioEngine engine{ createDefaultAudioBackend() };
+	engine.setStreamOptions(options);
+	engine.setGainRamp(rampShape, rampMs / 1000.0);
+
+	CControlServer server{ engine };
+	if (!server.listen(endpoint))
+		return 2;
+
+	std::cout << "Listening on " << endpoint << std::endl;
+	server.run();
+	return 0;
+}
@@ -0,0 +1,243 @@
+#include "testframework.h"
+#include "../audio/allocationcounter.h"
+#include "../audio/caudiobackendwavfile.h"
+#include "../audio/caudioengine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t sampleRate = 48000;
+constexpr size_t nChannels = 2;
+
+// The float samples of the data chunk of a WAV file written by WavFileWriter.
+[[nodiscard]] std::vector<float> readWavSamples(const std::string& path)
+{
+	std::ifstream file{ path, std::ios::binary };
+	const std::vector<char> bytes{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+
+	const char dataId[] = "data";
+	const auto data = std::search(bytes.begin(), bytes.end(), dataId, dataId + 4);
+	if (data == bytes.end())
+		return {};
+
+	// The chunk size follows the id.
+	std::vector<float> samples(static_cast<size_t>(bytes.end() - data - 8) / sizeof(float));
+	std::memcpy(samples.data(), &*(data + 8), samples.size() * sizeof(float));
+	return samples;
+}
+
+// Plays nFrames through the WAV file backend after setup() has been called on the stopped engine, and returns the interleaved output.
+[[nodiscard]] std::vector<float> render(const std::function<void(CAudioEngine&)>& setup, const uint64_t nFrames)
+{
+	const auto path = (std::filesystem::temp_directory_path() / "ToneTests_audioengine.wav").string();
+	{
+		auto backend = std::make_unique<CAudioBackendWavFile>(path, sampleRate, nChannels, nFrames);
+		auto* wavFile = backend.get();
+		CAudioEngine engine{ std::move(backend) };
+		setup(engine);
+
+		CHECK(engine.playTone(engine.devices().front().id));
+		wavFile->waitUntilFinished();
+		engine.stopPlayback();
+	}
+
+	auto samples = readWavSamples(path);
+	std::filesystem::remove(path);
+	CHECK(samples.size() == nFrames * nChannels);
+	return samples;
+}
+
+[[nodiscard]] std::vector<float> channel(const std::vector<float>& interleaved, const size_t c, const size_t firstFrame = 0)
+{
+	std::vector<float> samples;
+	for (size_t i = firstFrame * nChannels + c; i < interleaved.size(); i += nChannels)
+		samples.push_back(interleaved[i]);
+	return samples;
+}
+
+// From the number of upward zero crossings.
+[[nodiscard]] double frequency(const std::vector<float>& samples)
+{
+	size_t nCrossings = 0, first = 0, last = 0;
+	for (size_t i = 1; i < samples.size(); ++i)
+	{
+		if (samples[i - 1] < 0.0f && samples[i] >= 0.0f)
+		{
+			if (nCrossings++ == 0)
+				first = i;
+			last = i;
+		}
+	}
+
+	return nCrossings > 1 ? static_cast<double>(nCrossings - 1) * sampleRate / static_cast<double>(last - first) : 0.0;
+}
+
+[[nodiscard]] float peak(const std::vector<float>& samples)
+{
+	float result = 0.0f;
+	for (const float s : samples)
+		result = std::max(result, std::abs(s));
+	return result;
+}
+
+}
+
+// Nothing drains the change queue while stopped; the setters must neither fill it up nor lose the latest values.
+TEST_CASE(engineAppliesChangesWhileStopped)
+{
+	const auto output = render([](CAudioEngine& engine) {
+		for (int i = 0; i < 5000; ++i)
+		{
+			engine.setFrequency(100.0f + static_cast<float>(i));
+			engine.setGain(i % 2 == 0 ? 0.25f : 0.5f);
+			engine.setChannelIndex(static_cast<size_t>(i % 2));
+		}
+	}, sampleRate);
+
+	// The last values: 5099 Hz at 0.5 on channel 1. The first 10 ms are the fade-in.
+	const auto tone = channel(output, 1, sampleRate / 100);
+	CHECK_MESSAGE(std::abs(frequency(tone) - 5099.0) < 2.0, std::to_string(frequency(tone)) + " Hz");
+	CHECK_MESSAGE(std::abs(peak(tone) - 0.5f) < 0.01f, std::to_string(peak(tone)));
+	CHECK(peak(channel(output, 0)) == 0.0f);
+}
+
+// Sample-exact, whatever order the changes have been queued in; those due at the same frame are applied in the order they were queued.
+TEST_CASE(engineAppliesScheduledChangesAtTheirFrames)
+{
+	const auto output = render([](CAudioEngine& engine) {
+		engine.setFrequency(1000.0f);
+		const std::vector<ScheduledChange> changes {
+			{ 36000, 0.0, ScheduledChange::Gain, 0 },
+			{ 24000, 2000.0, ScheduledChange::Frequency, 0 },
+			{ 24000, 3000.0, ScheduledChange::Frequency, 0 },
+		};
+		CHECK(engine.scheduleChanges(changes.data(), changes.size()));
+	}, sampleRate);
+
+	const auto tone = channel(output, 0);
+	const std::vector<float> before(tone.begin() + sampleRate / 100, tone.begin() + 24000), after(tone.begin() + 24000, tone.begin() + 36000);
+	CHECK_MESSAGE(std::abs(frequency(before) - 1000.0) < 5.0, std::to_string(frequency(before)) + " Hz");
+	CHECK_MESSAGE(std::abs(frequency(after) - 3000.0) < 5.0, std::to_string(frequency(after)) + " Hz");
+	// The gain ramp down starts at frame 36000 exactly.
+	CHECK(tone[36000] != 0.0f);
+	CHECK(peak(std::vector<float>(tone.begin() + 36000 + sampleRate / 100, tone.end())) == 0.0f);
+}
+
+// A schedule of thousands of future changes is rejected once it's full, but never blocks the setters.
+TEST_CASE(engineKeepsRoomForImmediateChanges)
+{
+	const auto output = render([](CAudioEngine& engine) {
+		size_t nScheduled = 0;
+		for (ScheduledChange change{ 1'000'000'000, 500.0, ScheduledChange::Frequency, 0 }; engine.scheduleChanges(&change, 1); ++change.frame)
+			++nScheduled;
+
+		CHECK_MESSAGE(nScheduled >= 2048, std::to_string(nScheduled));
+		const ScheduledChange change{ 0, 500.0, ScheduledChange::Frequency, 0 };
+		CHECK(!engine.scheduleChanges(&change, 1));
+
+		for (int i = 0; i < 1000; ++i)
+			engine.setFrequency(2000.0f + static_cast<float>(i));
+	}, sampleRate);
+
+	const auto tone = channel(output, 0, sampleRate / 100);
+	CHECK_MESSAGE(std::abs(frequency(tone) - 2999.0) < 2.0, std::to_string(frequency(tone)) + " Hz");
+}
+
+// Every step starts on its exact frame, counted from the start of the stream.
+TEST_CASE(engineRendersSequenceStepsOnTheirFrames)
+{
+	std::string error;
+	// 480, 240, 480 and 240 frames; the tone's phase isn't at a zero crossing at any of the boundaries.
+	const std::shared_ptr<Sequence> sequence = Sequence::compile("tone 1234 10ms\nsilence 5ms\ntone 1234 10ms ch 1\nsilence 5ms\n", error);
+	CHECK_MESSAGE(sequence, error);
+	if (!sequence)
+		return;
+
+	const auto output = render([&](CAudioEngine& engine) { engine.startSequence(sequence); }, 4096);
+	const auto left = channel(output, 0), right = channel(output, 1);
+	const auto silent = [](const std::vector<float>& samples, const size_t begin, const size_t end) {
+		return std::all_of(samples.begin() + static_cast<ptrdiff_t>(begin), samples.begin() + static_cast<ptrdiff_t>(end), [](const float s) { return s == 0.0f; });
+	};
+
+	CHECK(left[479] != 0.0f);
+	CHECK(silent(left, 480, left.size()));
+	CHECK(silent(right, 0, 720));
+	CHECK(right[720] != 0.0f && right[1199] != 0.0f);
+	CHECK(silent(right, 1200, right.size()));
+	CHECK(sequence->finished());
+}
+
+// Every generator, with the glitch monitor on and parameter changes coming in, for a few dozen callbacks: once warmed up, the render
+// callback must not touch the heap. Only meaningful with AUDIO_COUNT_ALLOCATIONS, which ToneTests.pro always defines.
+TEST_CASE(renderCallbackDoesNotAllocate)
+{
+	CHECK_MESSAGE(AllocationCounter::isEnabled(), "built without AUDIO_COUNT_ALLOCATIONS");
+
+	std::string error;
+	// The sequence goes first, while no wavetable has been requested through setWaveform() yet. The silence takes it past the warm-up.
+	const std::shared_ptr<Sequence> sequence = Sequence::compile(
+		"silence 250ms\n"
+		"repeat\n"
+		"  tone 1000 50ms waveform square\n"
+		"  tone 1000 50ms waveform sawtooth ch 1\n"
+		"  tone 1000 50ms waveform triangle ch all\n"
+		"  tone 1000 50ms waveform pulse\n"
+		"  sweep 20 20000 100ms log ch all\n"
+		"  noise pink 50ms ch all\n"
+		"  noise band 500 2000 50ms\n"
+		"  silence 10ms\n"
+		"end\n", error);
+	CHECK_MESSAGE(sequence, error);
+
+	struct Generator {
+		std::string name;
+		std::function<void(CAudioEngine&)> start;
+		// Frequency changes would switch the other generators to a tone.
+		bool tone;
+	};
+	const std::vector<Generator> generators {
+		{ "sequence", [&](CAudioEngine& engine) { engine.startSequence(sequence); }, false },
+		{ "sine", [](CAudioEngine& engine) { engine.setWaveform(Waveform::Sine); }, true },
+		{ "square", [](CAudioEngine& engine) { engine.setWaveform(Waveform::Square); }, true },
+		{ "sawtooth", [](CAudioEngine& engine) { engine.setWaveform(Waveform::Sawtooth); }, true },
+		{ "triangle", [](CAudioEngine& engine) { engine.setWaveform(Waveform::Triangle); }, true },
+		{ "pulse", [](CAudioEngine& engine) { engine.setWaveform(Waveform::Pulse, 0.2f); }, true },
+		{ "sweep", [](CAudioEngine& engine) { engine.startSweep({ 20.0, 20000.0, 0.5, SweepParams::Logarithmic, true }); }, false },
+		{ "oscillators", [](CAudioEngine& engine) { engine.setOscillators({ { 100.0f, 0.25f, 0 }, { 1000.0f, 0.25f, 1 }, { 10000.0f, 0.25f, 1 } }); }, false },
+		{ "white noise", [](CAudioEngine& engine) { engine.startNoise({ NoiseParams::White }, true); }, false },
+		{ "band-limited noise", [](CAudioEngine& engine) { engine.startNoise({ NoiseParams::BandLimited }); }, false },
+	};
+
+	for (const Generator& generator : generators)
+	{
+		const uint64_t allocationsBefore = AllocationCounter::guardedAllocations();
+		(void)render([&](CAudioEngine& engine) {
+			engine.setGlitchDetection(true);
+			generator.start(engine);
+
+			// Splitting the callbacks, and moving the signal from channel to channel.
+			std::vector<ScheduledChange> changes;
+			for (uint64_t frame = 10000; frame < 30 * 4096; frame += 10000)
+			{
+				changes.push_back({ frame, frame % 20000 == 0 ? 0.5 : 0.25, ScheduledChange::Gain, 0 });
+				changes.push_back({ frame + 5000, static_cast<double>(frame / 10000 % 2), ScheduledChange::Channel, 0 });
+				if (generator.tone)
+					changes.push_back({ frame + 2500, 1000.0 + static_cast<double>(frame) / 100.0, ScheduledChange::Frequency, 0 });
+			}
+
+			CHECK(engine.scheduleChanges(changes.data(), changes.size()));
+		}, 32 * 4096);
+
+		const uint64_t allocations = AllocationCounter::guardedAllocations() - allocationsBefore;
+		CHECK_MESSAGE(allocations == 0, generator.name + ": " + std::to_string(allocations) + " allocations in the render callback");
+	}
+}
@@ -0,0 +1,129 @@
+#include "testframework.h"
+#include "../audio/caudiobackendnull.h"
+#include "../controlserver/ccontrolserver.h"
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Waits up to a second for the render thread to report the change tagged id.
+[[nodiscard]] std::optional<AppliedChange> waitForAppliedChange(CAudioEngine& engine, const uint32_t id)
+{
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{ 1 };
+	while (std::chrono::steady_clock::now() < deadline)
+	{
+		AppliedChange applied;
+		while (engine.appliedChanges(&applied, 1) == 1)
+		{
+			if (applied.id == id)
+				return applied;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds{ 5 });
+	}
+
+	return {};
+}
+
+[[nodiscard]] bool startsWith(const std::string& s, const char* prefix)
+{
+	return s.rfind(prefix, 0) == 0;
+}
+
+}
+
+TEST_CASE(controlProtocolRejectsNegativeFrames)
+{
+	std::vector<ControlCommand> commands;
+	std::string error;
+	for (const char* request : { "at -5 freq 1000", "at +-5 freq 1000", "at ++5 freq 1000", "at - 5 freq 1000" })
+	{
+		CHECK_MESSAGE(!parseRequest(request, commands, error), request);
+		CHECK_MESSAGE(error == "command 1: at takes a frame number and a command", request + std::string{ ": " } + error);
+	}
+
+	CHECK(parseRequest("at 5 freq 1000; at +5 freq 1000", commands, error));
+	CHECK(commands.size() == 2 && commands[0].change.frame == 5 && commands[1].timing == ControlCommand::AfterFrames);
+}
+
+// "play; at +N ..." after a stop must count from the new stream's start, not from where the previous one had stopped.
+TEST_CASE(controlServerRelativeFramesAfterRestart)
+{
+	CAudioEngine engine{ std::make_unique<CAudioBackendNull>(48000, 2, 480) };
+	CControlServer server{ engine };
+
+	// The server numbers its changes from 1.
+	uint32_t changeId = 1;
+	CHECK(startsWith(server.execute("play"), "OK"));
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 200 });
+	CHECK(startsWith(server.execute("stop"), "OK"));
+	CHECK(engine.playbackPosition() == 0);
+	CHECK(server.execute("position") == "OK position=0 rate=48000");
+
+	CHECK(startsWith(server.execute("play; at +2400 freq 2000"), "OK"));
+	auto applied = waitForAppliedChange(engine, changeId++);
+	CHECK(applied.has_value());
+	if (applied)
+	{
+		// play returns once the stream is running, a few periods in at most.
+		CHECK_MESSAGE(applied->frame >= 2400 && applied->frame < 2400 + 9600, std::to_string(applied->frame));
+		CHECK(applied->renderedFrame == applied->frame);
+	}
+
+	// The same within one request.
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 100 });
+	CHECK(startsWith(server.execute("stop; play; at +2400 freq 3000"), "OK"));
+	applied = waitForAppliedChange(engine, changeId++);
+	CHECK(applied.has_value());
+	if (applied)
+	{
+		CHECK_MESSAGE(applied->frame >= 2400 && applied->frame < 2400 + 9600, std::to_string(applied->frame));
+		CHECK(applied->renderedFrame == applied->frame);
+	}
+
+	CHECK(startsWith(server.execute("quit"), "OK"));
+	CHECK(!engine.isPlaying());
+}
+
+// Nothing renders while stopped, so the server's immediate changes must not pile up in the engine's queue.
+TEST_CASE(controlServerChangesWhileStopped)
+{
+	CAudioEngine engine{ std::make_unique<CAudioBackendNull>(48000, 2, 480) };
+	CControlServer server{ engine };
+
+	for (int i = 0; i < 5000; ++i)
+	{
+		const std::string reply = server.execute("freq " + std::to_string(100 + i));
+		CHECK_MESSAGE(startsWith(reply, "OK"), std::to_string(i) + ": " + reply);
+		if (!startsWith(reply, "OK"))
+			break;
+	}
+
+	CHECK(startsWith(server.execute("quit"), "OK"));
+}
+
+// A request that wouldn't fit in the engine's schedule is rejected as a whole, before its first command has run.
+TEST_CASE(controlServerRejectsRequestsOverTheScheduleCapacity)
+{
+	CAudioEngine engine{ std::make_unique<CAudioBackendNull>(48000, 2, 480) };
+	CControlServer server{ engine };
+	CHECK(startsWith(server.execute("play"), "OK"));
+
+	std::string request = "stop";
+	for (size_t i = 0; i <= engine.schedulableChanges(); ++i)
+		request += "; at 1000000000 freq 100";
+
+	CHECK(server.execute(request) == "ERR too many changes pending");
+	CHECK(engine.isPlaying());
+
+	// One fewer fits.
+	request.erase(request.rfind(';'));
+	CHECK(startsWith(server.execute(request), "OK"));
+	CHECK(!engine.isPlaying());
+
+	CHECK(startsWith(server.execute("quit"), "OK"));
+}
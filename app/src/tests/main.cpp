@@ -0,0 +1,14 @@
+#include "testframework.h"
+
+#include "assert/advanced_assert.h"
+
+// Usage: ToneTests [--bench] [name filter]
+int main(int argc, char* argv[])
+{
+	// An assertion failing anywhere in the code under test fails the test that has triggered it.
+	AdvancedAssert::setLoggingFunc([](const char* message) {
+		Test::fail(message);
+	});
+
+	return Test::run(argc, argv) == 0 ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+#include "testframework.h"
+#include "../audio/fft.h"
+#include "../audio/noise.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t sampleRate = 48000;
+
+[[nodiscard]] std::vector<float> render(const NoiseParams& params, const size_t nFrames, const size_t nChannels = 1, const size_t channelIndex = 0)
+{
+	NoiseGenerator generator;
+	generator.prepare(sampleRate, nChannels);
+	generator.setParams(params);
+
+	std::vector<float> buffer(nFrames * nChannels);
+	// In uneven pieces, the output must not depend on the buffer size.
+	for (size_t offset = 0, n = 1; offset < nFrames; offset += n, n = n * 3 + 1)
+	{
+		n = std::min(n, nFrames - offset);
+		generator.render(buffer.data() + offset * nChannels, n, nChannels, channelIndex);
+	}
+
+	return buffer;
+}
+
+[[nodiscard]] std::vector<float> channel(const std::vector<float>& interleaved, const size_t nChannels, const size_t c)
+{
+	std::vector<float> samples(interleaved.size() / nChannels);
+	for (size_t i = 0; i < samples.size(); ++i)
+		samples[i] = interleaved[i * nChannels + c];
+	return samples;
+}
+
+[[nodiscard]] double rms(const std::vector<float>& samples)
+{
+	double sum = 0.0;
+	for (const float s : samples)
+		sum += static_cast<double>(s) * s;
+	return std::sqrt(sum / static_cast<double>(samples.size()));
+}
+
+[[nodiscard]] double correlation(const std::vector<float>& a, const std::vector<float>& b)
+{
+	double ab = 0.0, aa = 0.0, bb = 0.0;
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		ab += static_cast<double>(a[i]) * b[i];
+		aa += static_cast<double>(a[i]) * a[i];
+		bb += static_cast<double>(b[i]) * b[i];
+	}
+
+	return ab / std::sqrt(aa * bb);
+}
+
+// Welch's method: the average power spectrum of Hann-windowed, half-overlapping blocks.
+[[nodiscard]] std::vector<double> powerSpectrum(const std::vector<float>& samples, const size_t fftSize = 4096)
+{
+	RealFft fft{ fftSize };
+	std::vector<float> window(fftSize), block(fftSize), re(fftSize / 2 + 1), im(fftSize / 2 + 1);
+	for (size_t i = 0; i < fftSize; ++i)
+		window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * std::numbers::pi * static_cast<double>(i) / fftSize));
+
+	std::vector<double> power(fftSize / 2 + 1, 0.0);
+	size_t nBlocks = 0;
+	for (size_t offset = 0; offset + fftSize <= samples.size(); offset += fftSize / 2, ++nBlocks)
+	{
+		for (size_t i = 0; i < fftSize; ++i)
+			block[i] = samples[offset + i] * window[i];
+
+		fft.transform(block.data(), re.data(), im.data());
+		for (size_t k = 0; k < power.size(); ++k)
+			power[k] += static_cast<double>(re[k]) * re[k] + static_cast<double>(im[k]) * im[k];
+	}
+
+	for (double& p : power)
+		p /= static_cast<double>(nBlocks);
+	return power;
+}
+
+// The average power per bin from lowHz to highHz, in dB.
+[[nodiscard]] double bandLevelDb(const std::vector<double>& power, const double lowHz, const double highHz)
+{
+	const double binHz = static_cast<double>(sampleRate) / (2.0 * static_cast<double>(power.size() - 1));
+	const auto first = static_cast<size_t>(std::ceil(lowHz / binHz)), last = static_cast<size_t>(std::floor(highHz / binHz));
+
+	double sum = 0.0;
+	for (size_t k = first; k <= last; ++k)
+		sum += power[k];
+	return 10.0 * std::log10(sum / static_cast<double>(last - first + 1));
+}
+
+// The least-squares slope of the octave band levels from 100 Hz to 12.8 kHz, in dB per octave.
+[[nodiscard]] double spectralSlopeDbPerOctave(const std::vector<float>& samples)
+{
+	const auto power = powerSpectrum(samples);
+
+	std::vector<double> x, y;
+	for (double hz = 100.0; hz < 12800.0; hz *= 2.0)
+	{
+		x.push_back(std::log2(hz));
+		y.push_back(bandLevelDb(power, hz, 2.0 * hz));
+	}
+
+	const auto n = static_cast<double>(x.size());
+	double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+	for (size_t i = 0; i < x.size(); ++i)
+	{
+		sx += x[i];
+		sy += y[i];
+		sxx += x[i] * x[i];
+		sxy += x[i] * y[i];
+	}
+
+	return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+}
+
+}
+
+TEST_CASE(noiseIsReproducibleFromTheSeed)
+{
+	for (const auto type : { NoiseParams::White, NoiseParams::Pink, NoiseParams::BandLimited })
+	{
+		NoiseParams params;
+		params.type = type;
+		params.seed = 12345;
+		const auto a = render(params, 10000, 3, NoiseGenerator::allChannels);
+		CHECK(a == render(params, 10000, 3, NoiseGenerator::allChannels));
+
+		params.seed = 12346;
+		CHECK(a != render(params, 10000, 3, NoiseGenerator::allChannels));
+
+		// setParams() restarts the streams.
+		params.seed = 12345;
+		NoiseGenerator generator;
+		generator.prepare(sampleRate, 3);
+		generator.setParams(params);
+		std::vector<float> b(a.size());
+		generator.render(b.data(), 5000, 3, NoiseGenerator::allChannels);
+		generator.setParams(params);
+		generator.render(b.data(), 10000, 3, NoiseGenerator::allChannels);
+		CHECK(a == b);
+	}
+}
+
+TEST_CASE(noiseChannelsAreIndependent)
+{
+	constexpr size_t nChannels = 12, nFrames = 100000;
+	NoiseParams params;
+	params.type = NoiseParams::White;
+	const auto all = render(params, nFrames, nChannels, NoiseGenerator::allChannels);
+
+	for (size_t a = 0; a < nChannels; ++a)
+	{
+		for (size_t b = a + 1; b < nChannels; ++b)
+		{
+			// The standard deviation of the estimate is 1 / sqrt(nFrames), about 0.003.
+			const double r = correlation(channel(all, nChannels, a), channel(all, nChannels, b));
+			CHECK_MESSAGE(std::abs(r) < 0.015, "channels " + std::to_string(a) + " and " + std::to_string(b) + ": " + std::to_string(r));
+		}
+	}
+
+	// A single channel is the same stream as in the all-channels render; the others are silent.
+	const auto single = render(params, nFrames, nChannels, 5);
+	CHECK(channel(single, nChannels, 5) == channel(all, nChannels, 5));
+	CHECK(rms(channel(single, nChannels, 4)) == 0.0);
+}
+
+TEST_CASE(noiseLevels)
+{
+	constexpr size_t nFrames = 1 << 20;
+	NoiseParams params;
+	params.gain = 0.5f;
+
+	params.type = NoiseParams::White;
+	const auto white = render(params, nFrames);
+	CHECK(std::abs(rms(white) - 0.5 / std::sqrt(3.0)) < 0.005);
+	CHECK(*std::max_element(white.begin(), white.end()) <= 0.5f && *std::min_element(white.begin(), white.end()) >= -0.5f);
+
+	// The same RMS as the white noise.
+	params.type = NoiseParams::Pink;
+	CHECK(std::abs(rms(render(params, nFrames)) - 0.5 / std::sqrt(3.0)) < 0.01);
+}
+
+TEST_CASE(noiseSpectralSlope)
+{
+	constexpr size_t nFrames = 1 << 21;
+	NoiseParams params;
+
+	params.type = NoiseParams::White;
+	const double whiteSlope = spectralSlopeDbPerOctave(render(params, nFrames));
+	CHECK_MESSAGE(std::abs(whiteSlope) < 0.25, std::to_string(whiteSlope) + " dB / octave");
+
+	params.type = NoiseParams::Pink;
+	const double pinkSlope = spectralSlopeDbPerOctave(render(params, nFrames));
+	CHECK_MESSAGE(std::abs(pinkSlope + 3.01) < 0.5, std::to_string(pinkSlope) + " dB / octave");
+}
+
+TEST_CASE(noiseBandLimits)
+{
+	NoiseParams params;
+	params.type = NoiseParams::BandLimited;
+	params.lowHz = 500.0;
+	params.highHz = 2000.0;
+	const auto power = powerSpectrum(render(params, 1 << 20));
+
+	const double passband = bandLevelDb(power, 700.0, 1400.0);
+	// 2nd order filters: 12 dB / octave, so two octaves out is at least 24 dB down (minus the window's leakage).
+	CHECK(passband - bandLevelDb(power, 50.0, 125.0) > 20.0);
+	CHECK(passband - bandLevelDb(power, 8000.0, 16000.0) > 20.0);
+	// The -3 dB points are at the cutoffs.
+	CHECK(std::abs(passband - bandLevelDb(power, 490.0, 510.0) - 3.0) < 1.5);
+	CHECK(std::abs(passband - bandLevelDb(power, 1960.0, 2040.0) - 3.0) < 1.5);
+}
+
+BENCHMARK(noiseThroughput)
+{
+	// 12 channels at 192 kHz is the target load.
+	constexpr size_t nChannels = 12, nFrames = 1920;
+	std::vector<float> buffer(nFrames * nChannels);
+
+	NoiseGenerator generator;
+	generator.prepare(192000, nChannels);
+
+	for (const auto type : { NoiseParams::White, NoiseParams::Pink, NoiseParams::BandLimited })
+	{
+		NoiseParams params;
+		params.type = type;
+		generator.setParams(params);
+
+		const double seconds = Test::measure([&] {
+			generator.render(buffer.data(), nFrames, nChannels, NoiseGenerator::allChannels);
+			Test::doNotOptimize(buffer.data());
+		});
+
+		const char* name = type == NoiseParams::White ? "white" : type == NoiseParams::Pink ? "pink" : "band-limited";
+		Test::report(std::string{ name } + ", per sample", seconds * 1e9 / (nFrames * nChannels), "ns");
+		// nFrames is 10 ms at 192 kHz.
+		Test::report(std::string{ name } + ", 12 channels at 192 kHz, share of real time", seconds / 0.01 * 100.0, "%");
+	}
+
+	// The reference point: std::mt19937 and a uniform distribution.
+	std::mt19937 mt{ 1 };
+	std::uniform_real_distribution<float> uniform{ -1.0f, 1.0f };
+	const double seconds = Test::measure([&] {
+		for (float& sample : buffer)
+			sample = uniform(mt);
+		Test::doNotOptimize(buffer.data());
+	});
+	Test::report("std::mt19937, per sample", seconds * 1e9 / (nFrames * nChannels), "ns");
+}
@@ -0,0 +1,142 @@
+#include "testframework.h"
+#include "../audio/oscillatorbank.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t sampleRate = 48000;
+
+// The exact sum of the oscillators of every channel, frames [firstFrame; firstFrame + nFrames).
+[[nodiscard]] std::vector<float> reference(const std::vector<OscillatorBank::Oscillator>& oscillators, const size_t firstFrame, const size_t nFrames, const size_t nChannels)
+{
+	std::vector<double> sum(nFrames * nChannels, 0.0);
+	for (const auto& o : oscillators)
+	{
+		if (o.channelIndex >= nChannels)
+			continue;
+
+		const double increment = 2.0 * std::numbers::pi * static_cast<double>(o.hz) / sampleRate;
+		for (size_t i = 0; i < nFrames; ++i)
+			sum[i * nChannels + o.channelIndex] += o.gain * std::sin(o.phase + static_cast<double>(firstFrame + i) * increment);
+	}
+
+	return { sum.begin(), sum.end() };
+}
+
+[[nodiscard]] double maxDifference(const std::vector<float>& a, const std::vector<float>& b)
+{
+	double difference = 0.0;
+	for (size_t i = 0; i < std::min(a.size(), b.size()); ++i)
+		difference = std::max(difference, static_cast<double>(std::abs(a[i] - b[i])));
+	return difference;
+}
+
+[[nodiscard]] float peak(const std::vector<float>& samples)
+{
+	float result = 0.0f;
+	for (const float s : samples)
+		result = std::max(result, std::abs(s));
+	return result;
+}
+
+}
+
+TEST_CASE(oscillatorBankPerChannelTones)
+{
+	const std::vector<float> hz{ 100.0f, 1000.0f, 5000.0f, 12345.0f };
+	const std::vector<float> gain{ 1.0f, 0.5f, 0.25f, 0.125f };
+	const auto oscillators = OscillatorBank::perChannelTones(hz, gain);
+	CHECK(oscillators.size() == 4);
+
+	OscillatorBank bank{ oscillators };
+	CHECK(bank.size() == 4);
+
+	constexpr size_t nFrames = 4800, nChannels = 4;
+	std::vector<float> buffer(nFrames * nChannels);
+	bank.render(buffer.data(), nFrames, nChannels, sampleRate);
+	CHECK(maxDifference(buffer, reference(oscillators, 0, nFrames, nChannels)) < 1e-4);
+}
+
+TEST_CASE(oscillatorBankSumsEveryChannelGroupAcrossCalls)
+{
+	// Group sizes that aren't multiples of the vector width, unsorted, an empty channel in between and one beyond the device's channels.
+	const std::vector<OscillatorBank::Oscillator> oscillators{
+		{ 440.0f, 0.2f, 1, 0.0 }, { 880.0f, 0.1f, 3, 1.0 }, { 660.0f, 0.2f, 1, 2.0 }, { 7000.0f, 0.1f, 1, -1.0 },
+		{ 50.0f, 0.2f, 1, 0.5 }, { 20000.0f, 0.1f, 1, 3.0 }, { 1000.0f, 1.0f, 7, 0.0 }, { 3000.0f, 0.3f, 0, 0.0 },
+	};
+
+	OscillatorBank bank{ oscillators };
+	CHECK(bank.size() == oscillators.size());
+
+	constexpr size_t nChannels = 4;
+	size_t frame = 0;
+	for (const size_t nFrames : { 1, 255, 256, 257, 1000, 4801 })
+	{
+		std::vector<float> buffer(nFrames * nChannels, 1.0f);
+		bank.render(buffer.data(), nFrames, nChannels, sampleRate);
+		CHECK_MESSAGE(maxDifference(buffer, reference(oscillators, frame, nFrames, nChannels)) < 1e-4, "at frame " + std::to_string(frame));
+
+		for (size_t i = 0; i < nFrames; ++i)
+			CHECK(buffer[i * nChannels + 2] == 0.0f);
+		frame += nFrames;
+	}
+
+	// Back to the start.
+	bank.resetPhases();
+	std::vector<float> buffer(1000 * nChannels);
+	bank.render(buffer.data(), 1000, nChannels, sampleRate);
+	CHECK(maxDifference(buffer, reference(oscillators, 0, 1000, nChannels)) < 1e-4);
+}
+
+TEST_CASE(oscillatorBankMultitoneCrestFactor)
+{
+	constexpr size_t nTones = 32, nFrames = 48000;
+	constexpr float peakGain = 0.9f;
+	const auto tones = OscillatorBank::multitone(20.0, 20000.0, nTones, 0, peakGain);
+	CHECK(tones.size() == nTones);
+	CHECK(std::abs(tones.front().hz - 20.0f) < 1e-3f && std::abs(tones.back().hz - 20000.0f) < 1e-1f);
+	// Log-spaced: a constant ratio between neighbours.
+	CHECK(std::abs(tones[1].hz / tones[0].hz - tones[31].hz / tones[30].hz) < 1e-3f);
+
+	std::vector<float> buffer(nFrames);
+	OscillatorBank{ tones }.render(buffer.data(), nFrames, 1, sampleRate);
+	CHECK(peak(buffer) <= peakGain + 1e-4f);
+
+	// Cosines starting in phase add up to the full peakGain at frame 0; the Schroeder phases must keep the peak well below that.
+	auto inPhase = tones;
+	for (auto& tone : inPhase)
+		tone.phase = std::numbers::pi / 2.0;
+	std::vector<float> inPhaseBuffer(nFrames);
+	OscillatorBank{ inPhase }.render(inPhaseBuffer.data(), nFrames, 1, sampleRate);
+
+	CHECK_MESSAGE(peak(buffer) < 0.7f * peak(inPhaseBuffer), std::to_string(peak(buffer)) + " vs " + std::to_string(peak(inPhaseBuffer)));
+}
+
+BENCHMARK(oscillatorBankScaling)
+{
+	constexpr size_t nFrames = 4800, nChannels = 8;
+	std::vector<float> buffer(nFrames * nChannels);
+
+	for (size_t nOscillators = 1; nOscillators <= 1024; nOscillators *= 4)
+	{
+		// Spread across the channels, the way a multichannel install would use it.
+		std::vector<OscillatorBank::Oscillator> oscillators;
+		for (size_t i = 0; i < nOscillators; ++i)
+			oscillators.push_back({ 100.0f + 17.0f * static_cast<float>(i), 1.0f / static_cast<float>(nOscillators), i % nChannels, 0.0 });
+
+		OscillatorBank bank{ oscillators };
+		const double seconds = Test::measure([&] {
+			bank.render(buffer.data(), nFrames, nChannels, sampleRate);
+			Test::doNotOptimize(buffer.data());
+		});
+
+		const auto name = std::to_string(nOscillators) + " oscillator(s)";
+		Test::report(name + ", per frame", seconds * 1e9 / nFrames, "ns");
+		Test::report(name + ", per oscillator per frame", seconds * 1e9 / nFrames / static_cast<double>(nOscillators), "ns");
+	}
+}
@@ -0,0 +1,196 @@
+#include "testframework.h"
+#include "../audio/samplewriter.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+[[nodiscard]] AudioFormat pcmFormat(const uint16_t bits, const uint16_t validBits = 0)
+{
+	AudioFormat format;
+	format.sampleFormat = AudioFormat::PCM;
+	format.bitsPerSample = bits;
+	format.validBitsPerSample = validBits;
+	return format;
+}
+
+[[nodiscard]] AudioFormat floatFormat()
+{
+	AudioFormat format;
+	format.sampleFormat = AudioFormat::Float;
+	format.bitsPerSample = 32;
+	return format;
+}
+
+// Half a step, full scale, beyond full scale (clipped) and below one LSB of every integer format.
+const std::vector<float> goldenInput{ 0.0f, 0.5f, -0.5f, 1.0f, -1.0f, 1.5f, -1.5f, 1e-6f };
+
+[[nodiscard]] std::vector<uint8_t> write(SampleWriter& writer, const std::vector<float>& input)
+{
+	std::vector<uint8_t> output(input.size() * writer.bytesPerSample());
+	writer.write(output.data(), input.data(), input.size());
+	return output;
+}
+
+// Little-endian, bytesPerSample bytes of every value.
+template <typename T>
+[[nodiscard]] std::vector<uint8_t> littleEndian(const std::vector<T>& values, const size_t bytesPerSample)
+{
+	std::vector<uint8_t> bytes;
+	for (const T value : values)
+	{
+		for (size_t b = 0; b < bytesPerSample; ++b)
+			bytes.push_back(static_cast<uint8_t>(static_cast<uint64_t>(static_cast<int64_t>(value)) >> (8 * b)));
+	}
+
+	return bytes;
+}
+
+struct ErrorStats {
+	double mean = 0.0;
+	double variance = 0.0;
+	int32_t min = 0, max = 0;
+};
+
+// Quantizes a constant signal of the given level in LSBs with int16 TPDF dither and measures the total error in LSBs.
+[[nodiscard]] ErrorStats ditheredInt16Error(const double levelLsb, const size_t nSamples)
+{
+	SampleWriter writer{ pcmFormat(16), true };
+	const std::vector<float> input(nSamples, static_cast<float>(levelLsb / 32767.0));
+	std::vector<int16_t> output(nSamples);
+	writer.write(output.data(), input.data(), nSamples);
+
+	const double exactLevel = static_cast<double>(input[0]) * 32767.0;
+	ErrorStats stats{ 0.0, 0.0, output[0], output[0] };
+	double sum = 0.0, sumOfSquares = 0.0;
+	for (const int16_t sample : output)
+	{
+		const double error = sample - exactLevel;
+		sum += error;
+		sumOfSquares += error * error;
+		stats.min = std::min<int32_t>(stats.min, sample);
+		stats.max = std::max<int32_t>(stats.max, sample);
+	}
+
+	stats.mean = sum / static_cast<double>(nSamples);
+	stats.variance = sumOfSquares / static_cast<double>(nSamples) - stats.mean * stats.mean;
+	return stats;
+}
+
+}
+
+TEST_CASE(sampleWriterPicksTheKernelForTheFormat)
+{
+	CHECK(SampleWriter::sampleType(floatFormat()) == SampleWriter::SampleType::Float32);
+	CHECK(SampleWriter::sampleType(pcmFormat(16)) == SampleWriter::SampleType::Int16);
+	CHECK(SampleWriter::sampleType(pcmFormat(24)) == SampleWriter::SampleType::Int24);
+	CHECK(SampleWriter::sampleType(pcmFormat(32, 24)) == SampleWriter::SampleType::Int24In32);
+	CHECK(SampleWriter::sampleType(pcmFormat(32)) == SampleWriter::SampleType::Int32);
+	CHECK(SampleWriter::sampleType(pcmFormat(32, 32)) == SampleWriter::SampleType::Int32);
+	CHECK(SampleWriter::sampleType(pcmFormat(8)) == SampleWriter::SampleType::Unsupported);
+
+	auto float64 = floatFormat();
+	float64.bitsPerSample = 64;
+	CHECK(!SampleWriter{ float64 }.isValid());
+	CHECK(SampleWriter{ floatFormat() }.isFloat32());
+}
+
+TEST_CASE(sampleWriterGoldenFloat32)
+{
+	// Float output is never dithered.
+	SampleWriter writer{ floatFormat(), true };
+	CHECK(writer.bytesPerSample() == 4);
+
+	std::vector<uint8_t> expected(goldenInput.size() * 4);
+	std::memcpy(expected.data(), goldenInput.data(), expected.size());
+	CHECK(write(writer, goldenInput) == expected);
+}
+
+TEST_CASE(sampleWriterGoldenInt16)
+{
+	SampleWriter writer{ pcmFormat(16) };
+	CHECK(writer.bytesPerSample() == 2);
+	// Round to nearest, ties to even: 16383.5 -> 16384.
+	const std::vector<int32_t> expected{ 0, 16384, -16384, 32767, -32767, 32767, -32768, 0 };
+	CHECK(write(writer, goldenInput) == littleEndian(expected, 2));
+}
+
+TEST_CASE(sampleWriterGoldenInt24)
+{
+	SampleWriter writer{ pcmFormat(24) };
+	CHECK(writer.bytesPerSample() == 3);
+	const std::vector<uint8_t> expected{
+		0x00, 0x00, 0x00,
+		0x00, 0x00, 0x40,
+		0x00, 0x00, 0xC0,
+		0xFF, 0xFF, 0x7F,
+		0x01, 0x00, 0x80,
+		0xFF, 0xFF, 0x7F,
+		0x00, 0x00, 0x80,
+		0x08, 0x00, 0x00,
+	};
+	CHECK(write(writer, goldenInput) == expected);
+}
+
+TEST_CASE(sampleWriterGoldenInt24In32)
+{
+	SampleWriter writer{ pcmFormat(32, 24) };
+	CHECK(writer.bytesPerSample() == 4);
+	// The 24-bit values in the top three bytes, the low byte zero.
+	const std::vector<int64_t> expected{ 0, 0x40000000, -0x40000000, 0x7FFFFF00, -0x7FFFFF00, 0x7FFFFF00, -0x80000000ll, 0x800 };
+	CHECK(write(writer, goldenInput) == littleEndian(expected, 4));
+}
+
+TEST_CASE(sampleWriterGoldenInt32)
+{
+	SampleWriter writer{ pcmFormat(32) };
+	CHECK(writer.bytesPerSample() == 4);
+	const std::vector<int64_t> expected{ 0, 1073741824, -1073741824, 2147483647, -2147483647, 2147483647, -2147483648ll, 2147 };
+	CHECK(write(writer, goldenInput) == littleEndian(expected, 4));
+}
+
+TEST_CASE(sampleWriterDitherIsOffUnlessRequested)
+{
+	SampleWriter writer{ pcmFormat(16) };
+	const std::vector<float> input(1000, static_cast<float>(0.25 / 32767.0));
+	const auto output = write(writer, input);
+	CHECK(output == std::vector<uint8_t>(output.size(), 0));
+}
+
+// TPDF dither of +-1 LSB makes the quantization error independent of the signal: its mean is 0 at any level, even below one LSB,
+// and its power is 1/6 LSB^2 (the dither) + 1/12 LSB^2 (the rounding) = 1/4 LSB^2 regardless of the level.
+TEST_CASE(sampleWriterDitherStatistics)
+{
+	constexpr size_t nSamples = 400000;
+	for (const double levelLsb : { 0.0, 0.25, 0.5, 0.75, -0.3, 1000.5 })
+	{
+		const auto stats = ditheredInt16Error(levelLsb, nSamples);
+		const auto level = std::to_string(levelLsb) + " LSB";
+		CHECK_MESSAGE(std::abs(stats.mean) < 0.01, level + ", mean error " + std::to_string(stats.mean));
+		CHECK_MESSAGE(std::abs(stats.variance - 0.25) < 0.01, level + ", error variance " + std::to_string(stats.variance));
+		// The dither spans 2 LSB, so does the output.
+		CHECK_MESSAGE(stats.max - stats.min <= 2, level);
+	}
+}
+
+TEST_CASE(sampleWriterDitherIsWhite)
+{
+	// Adjacent dither values must be uncorrelated, otherwise the noise isn't flat.
+	constexpr size_t nSamples = 400000;
+	SampleWriter writer{ pcmFormat(16), true };
+	const std::vector<float> input(nSamples, 0.0f);
+	std::vector<int16_t> output(nSamples);
+	writer.write(output.data(), input.data(), nSamples);
+
+	double sumOfProducts = 0.0, sumOfSquares = 0.0;
+	for (size_t i = 1; i < nSamples; ++i)
+	{
+		sumOfProducts += static_cast<double>(output[i]) * output[i - 1];
+		sumOfSquares += static_cast<double>(output[i]) * output[i];
+	}
+
+	const double lag1Correlation = sumOfProducts / sumOfSquares;
+	CHECK_MESSAGE(std::abs(lag1Correlation) < 0.01, std::to_string(lag1Correlation));
+}
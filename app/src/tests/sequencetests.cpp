@@ -0,0 +1,151 @@
+#include "testframework.h"
+#include "../audio/sequence.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t sampleRate = 48000;
+
+// Renders the sequence frame by frame and counts the frames spent on each source line, until it finishes or maxFrames have been rendered.
+[[nodiscard]] std::map<uint32_t, uint64_t> framesPerLine(Sequence& sequence, const uint64_t maxFrames)
+{
+	ToneOscillator oscillator;
+	oscillator.setSampleRate(sampleRate);
+	NoiseGenerator noise;
+	noise.prepare(sampleRate, 1);
+
+	std::map<uint32_t, uint64_t> frames;
+	float sample = 0.0f;
+	for (uint64_t i = 0; i < maxFrames; ++i)
+	{
+		sequence.render(&sample, 1, 1, sampleRate, oscillator, noise);
+		if (sequence.finished())
+			break;
+
+		++frames[sequence.currentLine()];
+	}
+
+	return frames;
+}
+
+// nFrames of the sequence on nChannels, interleaved.
+[[nodiscard]] std::vector<float> render(Sequence& sequence, const size_t nFrames, const size_t nChannels)
+{
+	ToneOscillator oscillator;
+	oscillator.setSampleRate(sampleRate);
+	NoiseGenerator noise;
+	noise.prepare(sampleRate, nChannels);
+
+	std::vector<float> samples(nFrames * nChannels);
+	sequence.render(samples.data(), nFrames, nChannels, sampleRate, oscillator, noise);
+	return samples;
+}
+
+}
+
+TEST_CASE(sequenceCompileErrorsCarryLineNumbers)
+{
+	const std::vector<std::pair<std::string, std::string>> cases {
+		{ "tone 1000 1s\n\nbeep 1000 1s\n", "line 3: unknown step 'beep'" },
+		{ "tone 1000\n", "line 1: tone takes a frequency and a duration" },
+		{ "silence 2\nsilence 2 ch\n", "line 2: ch takes a value" },
+		{ "tone 1000 1s ch 0,x\n", "line 1: invalid channel list '0,x'" },
+		{ "tone 1000 1s\nrepeat 2\n# nothing\nend\n", "line 4: empty loop" },
+		{ "repeat 2\n  tone 1000 1s\n", "line 1: repeat without end" },
+		// The innermost loop that is still open.
+		{ "repeat\n  tone 1000 1s\n  repeat 3\n    tone 500 1s\n", "line 3: repeat without end" },
+		{ "tone 1000 1s\nend\n", "line 2: end without repeat" },
+		{ "repeat 0\n  tone 1000 1s\nend\n", "line 1: repeat takes a positive count, or none for an endless loop" },
+		{ "repeat x\n  tone 1000 1s\nend\n", "line 1: repeat takes a positive count, or none for an endless loop" },
+		{ "# comments only\n\n", "the sequence is empty" },
+	};
+
+	for (const auto& [source, expectedError] : cases)
+	{
+		std::string error;
+		CHECK_MESSAGE(!Sequence::compile(source, error), source);
+		CHECK_MESSAGE(error == expectedError, error + " instead of " + expectedError);
+	}
+}
+
+TEST_CASE(sequenceLoopsRunTheirCount)
+{
+	std::string error;
+	const auto sequence = Sequence::compile(
+		"repeat 3\n"
+		"  tone 1000 10ms\n"
+		"  repeat 2\n"
+		"    silence 5ms\n"
+		"  end\n"
+		"end\n"
+		"tone 500 1ms\n", error);
+	CHECK_MESSAGE(sequence, error);
+	if (!sequence)
+		return;
+
+	CHECK(std::abs(sequence->seconds() - 0.061) < 1e-9);
+	const auto frames = framesPerLine(*sequence, sampleRate);
+	CHECK(sequence->finished());
+	CHECK(frames.size() == 3);
+	CHECK_MESSAGE(frames.count(2) && frames.at(2) == 3 * 480, std::to_string(frames.count(2) ? frames.at(2) : 0));
+	CHECK_MESSAGE(frames.count(4) && frames.at(4) == 3 * 2 * 240, std::to_string(frames.count(4) ? frames.at(4) : 0));
+	CHECK_MESSAGE(frames.count(7) && frames.at(7) == 48, std::to_string(frames.count(7) ? frames.at(7) : 0));
+
+	// Starts over from the first pass.
+	sequence->rewind();
+	CHECK(framesPerLine(*sequence, sampleRate) == frames);
+}
+
+TEST_CASE(sequenceEndlessLoopNeverFinishes)
+{
+	std::string error;
+	const auto sequence = Sequence::compile("tone 1000 1ms\nrepeat\n  tone 500 1ms\n  silence 1ms\nend\n", error);
+	CHECK_MESSAGE(sequence, error);
+	if (!sequence)
+		return;
+
+	// One pass.
+	CHECK(std::abs(sequence->seconds() - 0.003) < 1e-9);
+	const auto frames = framesPerLine(*sequence, sampleRate);
+	CHECK(!sequence->finished());
+	CHECK(frames.count(1) && frames.at(1) == 48);
+	CHECK(frames.count(3) && frames.count(4) && frames.at(3) + frames.at(4) == sampleRate - 48);
+}
+
+TEST_CASE(sequenceChannelMasks)
+{
+	std::string error;
+	const auto sequence = Sequence::compile("tone 1000 10ms ch all\ntone 1000 10ms ch 1,3 gain -6\nnoise white 10ms ch all\n", error);
+	CHECK_MESSAGE(sequence, error);
+	if (!sequence)
+		return;
+
+	constexpr size_t nChannels = 4, stepFrames = 480;
+	const auto samples = render(*sequence, 3 * stepFrames, nChannels);
+	const auto at = [&](const size_t frame, const size_t channel) { return samples[frame * nChannels + channel]; };
+
+	float peak = 0.0f;
+	bool bCopies = true, bOthersSilent = true, bNoiseIndependent = false;
+	for (size_t frame = 0; frame < stepFrames; ++frame)
+	{
+		// "ch all" on a tone: the same samples on every channel.
+		peak = std::max(peak, std::abs(at(frame, 0)));
+		for (size_t c = 1; c < nChannels; ++c)
+			bCopies &= at(frame, c) == at(frame, 0);
+
+		// "ch 1,3": copies on those two only.
+		bCopies &= at(stepFrames + frame, 3) == at(stepFrames + frame, 1);
+		bOthersSilent &= at(stepFrames + frame, 0) == 0.0f && at(stepFrames + frame, 2) == 0.0f;
+
+		// "ch all" on noise: an independent stream per channel.
+		bNoiseIndependent |= at(2 * stepFrames + frame, 0) != at(2 * stepFrames + frame, 1);
+	}
+
+	CHECK(peak > 0.99f);
+	CHECK(bCopies);
+	CHECK(bOthersSilent);
+	CHECK(bNoiseIndependent);
+}
@@ -0,0 +1,94 @@
+#include "testframework.h"
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct TestEntry {
+	const char* name;
+	Test::Function function;
+	bool benchmark;
+};
+
+// Function-local so that it is constructed before the first registration, whatever the static initialization order.
+std::vector<TestEntry>& registry()
+{
+	static std::vector<TestEntry> tests;
+	return tests;
+}
+
+// Also reported from the threads of the code under test.
+std::atomic<size_t> failuresInCurrentTest = 0;
+std::mutex failureOutputMutex;
+
+}
+
+// External linkage, so the store can't be proven dead.
+const void* volatile benchmarkSink = nullptr;
+
+namespace Test {
+
+Registration::Registration(const char* name, Function function, bool benchmark)
+{
+	registry().push_back({ name, function, benchmark });
+}
+
+void fail(const char* file, int line, const std::string& message)
+{
+	++failuresInCurrentTest;
+	const std::lock_guard lock{ failureOutputMutex };
+	std::cerr << "    " << file << ':' << line << ": check failed: " << message << '\n';
+}
+
+void fail(const std::string& message)
+{
+	++failuresInCurrentTest;
+	const std::lock_guard lock{ failureOutputMutex };
+	std::cerr << "    failed: " << message << '\n';
+}
+
+void report(const std::string& name, double value, const char* unit)
+{
+	std::cout << "    " << name << ": " << value << ' ' << unit << '\n';
+}
+
+int run(int argc, char* argv[])
+{
+	bool benchmarks = false;
+	const char* filter = "";
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--bench") == 0)
+			benchmarks = true;
+		else
+			filter = argv[i];
+	}
+
+	int nFailed = 0, nRun = 0;
+	for (const auto& test : registry())
+	{
+		if (test.benchmark != benchmarks || std::strstr(test.name, filter) == nullptr)
+			continue;
+
+		std::cout << test.name << std::endl;
+		failuresInCurrentTest = 0;
+		test.function();
+		++nRun;
+		if (failuresInCurrentTest != 0)
+			++nFailed;
+	}
+
+	std::cout << nRun - nFailed << " of " << nRun << (benchmarks ? " benchmarks" : " tests") << " passed." << std::endl;
+	return nFailed;
+}
+
+void doNotOptimize(const void* p) noexcept
+{
+	benchmarkSink = p;
+}
+
+}
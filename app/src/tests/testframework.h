@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+// A minimal self-registering test harness, so that the tests don't pull in a third-party framework.
+// Tests run by default; benchmarks only with --bench, since their numbers are meaningless in a debug build.
+
+namespace Test {
+
+using Function = void (*)();
+
+struct Registration {
+	Registration(const char* name, Function function, bool benchmark = false);
+};
+
+void fail(const char* file, int line, const std::string& message);
+// For the failures reported by the code under test, e. g. its assertions. Both are thread-safe.
+void fail(const std::string& message);
+// Prints one benchmark result line.
+void report(const std::string& name, double value, const char* unit);
+
+// Runs the tests (or the benchmarks) whose name contains the filter; returns the number of failed tests.
+[[nodiscard]] int run(int argc, char* argv[]);
+
+// Keeps the optimizer from discarding a benchmark result.
+void doNotOptimize(const void* p) noexcept;
+
+// Calls f repeatedly for at least minSeconds and returns the average time per call in seconds.
+template <typename F>
+[[nodiscard]] double measure(F&& f, const double minSeconds = 0.5)
+{
+	using Clock = std::chrono::steady_clock;
+	f(); // Warm-up.
+
+	size_t nCalls = 0;
+	const auto start = Clock::now();
+	std::chrono::duration<double> elapsed{};
+	do
+	{
+		f();
+		++nCalls;
+		elapsed = Clock::now() - start;
+	} while (elapsed.count() < minSeconds);
+
+	return elapsed.count() / static_cast<double>(nCalls);
+}
+
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static const Test::Registration name##Registration{ #name, &name }; \
+	static void name()
+
+#define BENCHMARK(name) \
+	static void name(); \
+	static const Test::Registration name##Registration{ #name, &name, true }; \
+	static void name()
+
+#define CHECK(condition) \
+	do { if (!(condition)) Test::fail(__FILE__, __LINE__, #condition); } while (false)
+
+#define CHECK_MESSAGE(condition, message) \
+	do { if (!(condition)) Test::fail(__FILE__, __LINE__, std::string{ #condition } + ": " + (message)); } while (false)
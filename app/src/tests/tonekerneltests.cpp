@@ -0,0 +1,132 @@
+#include "testframework.h"
+#include "../audio/tonekernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <stdint.h>
+#include <vector>
+
+namespace {
+
+constexpr double twoPi = 2.0 * std::numbers::pi;
+
+[[nodiscard]] double maxErrorVsStdSin(const std::vector<float>& rendered, const double phase, const double phaseIncrement, const size_t nChannels = 1, const size_t channelIndex = 0)
+{
+	double maxError = 0.0;
+	const size_t nFrames = rendered.size() / nChannels;
+	for (size_t i = 0; i < nFrames; ++i)
+	{
+		const double expected = std::sin(phase + static_cast<double>(i) * phaseIncrement);
+		maxError = std::max(maxError, std::abs(expected - rendered[i * nChannels + channelIndex]));
+	}
+
+	return maxError;
+}
+
+// The render loop generateTone has replaced, as it was, kept as the benchmark baseline: single precision, the phase computed
+// from the absolute sample index, one memcpy per sample.
+void naiveGenerateTone(uint8_t* pData, const uint32_t nBufferFrames, const size_t nChannelsTotal, const float omega, const size_t channelIndex, const uint64_t samplesPlayedSoFar)
+{
+	for (uint64_t i = 0; i < nBufferFrames; ++i)
+	{
+		for (size_t c = 0; c < nChannelsTotal; ++c)
+		{
+			float sample = 0;
+			if (c == channelIndex)
+				sample = 1.0f * std::sin(omega * (i + samplesPlayedSoFar));
+
+			std::memcpy(pData + (i * nChannelsTotal + c) * sizeof(sample), &sample, sizeof(sample));
+		}
+	}
+}
+
+}
+
+TEST_CASE(toneKernelMatchesStdSin)
+{
+	// Long enough for many re-seeding chunks, at frequencies from a few Hz to near Nyquist.
+	for (const double hz : { 1.0, 440.0, 1000.0, 15000.0, 23900.0 })
+	{
+		const double phaseIncrement = twoPi * hz / 48000.0;
+		std::vector<float> rendered(48000 + 13);
+		renderSine(rendered.data(), rendered.size(), 0.3, phaseIncrement);
+
+		// -100 dB.
+		CHECK_MESSAGE(maxErrorVsStdSin(rendered, 0.3, phaseIncrement) < 1e-5, std::to_string(hz) + " Hz");
+	}
+}
+
+TEST_CASE(toneKernelPhaseIsContinuousAcrossCalls)
+{
+	const double phaseIncrement = twoPi * 997.0 / 44100.0;
+	std::vector<float> whole(10000), pieces(10000);
+	renderSine(whole.data(), whole.size(), 0.0, phaseIncrement);
+
+	double phase = 0.0;
+	size_t offset = 0;
+	for (const size_t n : { 1, 7, 256, 257, 1000, 3333 })
+	{
+		phase = renderSine(pieces.data() + offset, n, phase, phaseIncrement);
+		CHECK(phase >= 0.0 && phase < twoPi);
+		offset += n;
+	}
+	renderSine(pieces.data() + offset, pieces.size() - offset, phase, phaseIncrement);
+
+	double maxDifference = 0.0;
+	for (size_t i = 0; i < whole.size(); ++i)
+		maxDifference = std::max(maxDifference, static_cast<double>(std::abs(whole[i] - pieces[i])));
+	CHECK(maxDifference < 1e-5);
+}
+
+TEST_CASE(generateToneWritesOnlyTheTargetChannel)
+{
+	constexpr size_t nChannels = 6, nFrames = 1001;
+	const double phaseIncrement = twoPi * 1000.0 / 48000.0;
+	for (const size_t channelIndex : { size_t{ 0 }, size_t{ 3 }, nChannels - 1, nChannels })
+	{
+		std::vector<float> buffer(nFrames * nChannels, 123.0f);
+		generateTone(buffer.data(), nFrames, nChannels, channelIndex, 0.0, phaseIncrement);
+
+		for (size_t c = 0; c < nChannels; ++c)
+		{
+			if (c == channelIndex)
+				CHECK(maxErrorVsStdSin(buffer, 0.0, phaseIncrement, nChannels, c) < 1e-5);
+			else
+			{
+				bool silent = true;
+				for (size_t i = 0; i < nFrames; ++i)
+					silent = silent && buffer[i * nChannels + c] == 0.0f;
+				CHECK_MESSAGE(silent, "channel " + std::to_string(c) + " of target " + std::to_string(channelIndex));
+			}
+		}
+	}
+}
+
+BENCHMARK(toneKernelThroughput)
+{
+	constexpr size_t nFrames = 4800;
+	const double phaseIncrement = twoPi * 1000.0 / 48000.0;
+	const float omega = 2.0f * std::numbers::pi_v<float> * 1000.0f / 48000.0f;
+	// A minute into the playback.
+	constexpr uint64_t samplesPlayedSoFar = 60 * 48000;
+
+	for (const size_t nChannels : { 1, 2, 8 })
+	{
+		std::vector<float> buffer(nFrames * nChannels);
+		const double kernel = Test::measure([&] {
+			generateTone(buffer.data(), nFrames, nChannels, nChannels - 1, 0.1, phaseIncrement);
+			Test::doNotOptimize(buffer.data());
+		});
+		const double naive = Test::measure([&] {
+			naiveGenerateTone(reinterpret_cast<uint8_t*>(buffer.data()), nFrames, nChannels, omega, nChannels - 1, samplesPlayedSoFar);
+			Test::doNotOptimize(buffer.data());
+		});
+
+		const auto name = std::to_string(nChannels) + " channel(s)";
+		Test::report(name + ", generateTone", kernel * 1e9 / nFrames, "ns/frame");
+		Test::report(name + ", the old float std::sin loop", naive * 1e9 / nFrames, "ns/frame");
+		Test::report(name + ", speed-up", naive / kernel, "x");
+	}
+}
@@ -0,0 +1,130 @@
+#include "testframework.h"
+#include "../audio/triplebuffer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Every field is derived from the sequence number, so a torn snapshot is detectable.
+struct Snapshot {
+	uint64_t sequence = 0;
+	double hz = 0.0;
+	uint64_t check = ~uint64_t{ 0 };
+	uint32_t writer = 0;
+};
+
+[[nodiscard]] Snapshot makeSnapshot(const uint64_t sequence, const uint32_t writer) noexcept
+{
+	return { sequence, 20.0 + static_cast<double>(sequence % 20000), ~sequence, writer };
+}
+
+[[nodiscard]] bool isConsistent(const Snapshot& s) noexcept
+{
+	return s.check == ~s.sequence && s.hz == 20.0 + static_cast<double>(s.sequence % 20000);
+}
+
+struct StressResult {
+	uint64_t tornReads = 0;
+	uint64_t sequenceRegressions = 0;
+	uint64_t reads = 0;
+	std::chrono::nanoseconds worstReadLatency{ 0 };
+	uint64_t lastPublished = 0;
+	Snapshot lastRead;
+};
+
+// nWriters threads publish as fast as they can while the calling thread plays the render loop.
+[[nodiscard]] StressResult hammer(const size_t nWriters, const std::chrono::milliseconds duration)
+{
+	TripleBuffer<Snapshot> buffer{ makeSnapshot(0, 0) };
+	std::atomic<uint64_t> nextSequence{ 1 };
+	std::atomic_bool stop{ false };
+
+	std::vector<std::thread> writers;
+	for (uint32_t w = 0; w < nWriters; ++w)
+	{
+		writers.emplace_back([&, w] {
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				// modify() rather than write() so that the sequence numbers are published in order.
+				buffer.modify([&](Snapshot& s) {
+					s = makeSnapshot(nextSequence.fetch_add(1, std::memory_order_relaxed), w);
+				});
+			}
+		});
+	}
+
+	StressResult result;
+	uint64_t lastSequence = 0;
+	const auto end = std::chrono::steady_clock::now() + duration;
+	for (auto now = std::chrono::steady_clock::now(); now < end;)
+	{
+		const auto snapshot = buffer.read();
+		const auto after = std::chrono::steady_clock::now();
+		result.worstReadLatency = std::max(result.worstReadLatency, std::chrono::duration_cast<std::chrono::nanoseconds>(after - now));
+		now = after;
+
+		++result.reads;
+		if (!isConsistent(snapshot))
+			++result.tornReads;
+		if (snapshot.sequence < lastSequence)
+			++result.sequenceRegressions;
+		lastSequence = snapshot.sequence;
+	}
+
+	stop = true;
+	for (auto& writer : writers)
+		writer.join();
+
+	result.lastPublished = nextSequence.load() - 1;
+	result.lastRead = buffer.read();
+	return result;
+}
+
+}
+
+TEST_CASE(tripleBufferReaderSeesLatestValue)
+{
+	TripleBuffer<Snapshot> buffer{ makeSnapshot(0, 0) };
+	CHECK(buffer.read().sequence == 0);
+
+	for (uint64_t i = 1; i <= 10; ++i)
+	{
+		buffer.write(makeSnapshot(i, 0));
+		CHECK(buffer.read().sequence == i);
+		// Reading again without a new write returns the same snapshot.
+		CHECK(buffer.read().sequence == i);
+	}
+
+	// Several writes between reads: only the newest one is seen.
+	buffer.write(makeSnapshot(100, 0));
+	buffer.write(makeSnapshot(101, 0));
+	buffer.modify([](Snapshot& s) { s = makeSnapshot(s.sequence + 1, 0); });
+	CHECK(buffer.read().sequence == 102);
+}
+
+TEST_CASE(tripleBufferConcurrentWritersNeverTearSnapshots)
+{
+	const auto result = hammer(4, std::chrono::milliseconds{ 300 });
+	CHECK(result.reads > 0);
+	CHECK(result.tornReads == 0);
+	CHECK(result.sequenceRegressions == 0);
+	// After the writers are done, the reader must see the very last publication.
+	CHECK(result.lastRead.sequence == result.lastPublished);
+}
+
+// The reader never waits for the writers, so with fewer cores than threads the worst case is just the scheduler preempting the reader.
+BENCHMARK(tripleBufferReadLatencyUnderContention)
+{
+	for (const size_t nWriters : { 1, 4, 8 })
+	{
+		const auto result = hammer(nWriters, std::chrono::seconds{ 1 });
+		const auto name = std::to_string(nWriters) + " writer thread(s)";
+		Test::report(name + ", reads", static_cast<double>(result.reads), "");
+		Test::report(name + ", worst-case read latency", static_cast<double>(result.worstReadLatency.count()) / 1000.0, "us");
+		CHECK(result.tornReads == 0);
+	}
+}
@@ -0,0 +1,65 @@
+#include "testframework.h"
+#include "../audio/allocationcounter.h"
+#include "../audio/caudiobackendnull.h"
+#include "../waveformenvelope.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE(minMaxEnvelopeKeepsTheExtremesInOrder)
+{
+	std::vector<EnvelopePoint> points;
+
+	// Short enough to be copied point for point.
+	const float few[] { 0.5f, -0.25f, 1.0f };
+	buildMinMaxEnvelope(few, 3, 2, points);
+	CHECK(points.size() == 3 && points[1].x == 1.0 && points[1].y == -0.25);
+
+	// Two pixels of four samples each: the max comes first in the first one, the min first in the second.
+	const float many[] { 0.0f, 0.9f, -0.8f, 0.1f, 0.2f, -0.7f, 0.3f, 0.6f };
+	buildMinMaxEnvelope(many, 8, 2, points);
+	CHECK(points.size() == 4);
+	CHECK(points[0].x == 1.0 && points[0].y == 0.9f && points[1].x == 2.0 && points[1].y == -0.8f);
+	CHECK(points[2].x == 5.0 && points[2].y == -0.7f && points[3].x == 7.0 && points[3].y == 0.6f);
+}
+
+// The chart update once its shape has settled, as the GUI timer runs it.
+TEST_CASE(waveformEnvelopeSteadyUpdatesDoNotAllocate)
+{
+	CHECK_MESSAGE(AllocationCounter::isEnabled(), "built without AUDIO_COUNT_ALLOCATIONS");
+
+	CAudioEngine engine{ std::make_unique<CAudioBackendNull>(48000, 2, 480) };
+	CHECK(engine.playTone(engine.devices().front().id));
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 50 });
+
+	WaveformEnvelope envelope;
+	for (const size_t nPixels : { 200, 1000 })
+	{
+		size_t nSteadyUpdates = 0;
+		for (int i = 0; i < 20; ++i)
+		{
+			const uint64_t allocationsBefore = AllocationCounter::threadAllocations();
+			const bool bUpdated = envelope.update(engine, 480, nPixels);
+			const uint64_t allocations = AllocationCounter::threadAllocations() - allocationsBefore;
+			CHECK(bUpdated);
+
+			if (envelope.steadyUpdates() >= 2)
+			{
+				++nSteadyUpdates;
+				CHECK_MESSAGE(allocations == 0, std::to_string(nPixels) + " pixels, update " + std::to_string(i) + ": " + std::to_string(allocations) + " allocations");
+			}
+
+			// Longer than a period of the null backend, so that there is new output every time.
+			std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+		}
+
+		CHECK(nSteadyUpdates >= 15);
+		CHECK(envelope.channels() == 2 && envelope.frames() == 480);
+		// Decimated to 2 points per pixel, or copied as is when there are fewer samples than that.
+		CHECK(envelope.points(0).size() == std::min<size_t>(2 * nPixels, 480));
+	}
+
+	engine.stopPlayback();
+}
@@ -0,0 +1,111 @@
+#include "testframework.h"
+#include "../audio/wavfilewriter.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+[[nodiscard]] AudioFormat format(const size_t nChannels, const uint16_t bits, const uint16_t validBits = 0, const bool isFloat = false)
+{
+	AudioFormat f;
+	for (size_t c = 0; c < nChannels; ++c)
+		f.channels.push_back({ "Channel " + std::to_string(c), c });
+	f.sampleRate = 48000;
+	f.sampleFormat = isFloat ? AudioFormat::Float : AudioFormat::PCM;
+	f.bitsPerSample = bits;
+	f.validBitsPerSample = validBits;
+	return f;
+}
+
+// Writes 10 frames of zeros and returns the whole file.
+[[nodiscard]] std::vector<uint8_t> writeFile(const AudioFormat& f)
+{
+	const auto path = (std::filesystem::temp_directory_path() / "ToneTests_wavfilewriter.wav").string();
+	{
+		WavFileWriter writer;
+		CHECK(writer.open(path, f));
+		const std::vector<uint8_t> frames(10 * f.channels.size() * f.bitsPerSample / 8, 0);
+		CHECK(writer.write(frames.data(), 10));
+		CHECK(writer.close());
+	}
+
+	std::ifstream file{ path, std::ios::binary };
+	std::vector<uint8_t> bytes{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+	file.close();
+	std::filesystem::remove(path);
+	return bytes;
+}
+
+[[nodiscard]] uint32_t readU32(const std::vector<uint8_t>& bytes, const size_t offset)
+{
+	return bytes[offset] | (bytes[offset + 1] << 8) | (bytes[offset + 2] << 16) | (static_cast<uint32_t>(bytes[offset + 3]) << 24);
+}
+
+[[nodiscard]] uint16_t readU16(const std::vector<uint8_t>& bytes, const size_t offset)
+{
+	return static_cast<uint16_t>(bytes[offset] | (bytes[offset + 1] << 8));
+}
+
+// The fmt chunk follows the RIFF header and the 36-byte JUNK chunk.
+constexpr size_t fmtChunk = 12 + 36;
+constexpr size_t fmt = fmtChunk + 8;
+
+}
+
+TEST_CASE(wavFileWriterPlainFormat)
+{
+	const auto bytes = writeFile(format(2, 16));
+	CHECK(bytes.size() == fmt + 16 + 8 + 10 * 4);
+	CHECK(readU32(bytes, 4) == bytes.size() - 8);
+	CHECK(readU32(bytes, fmtChunk + 4) == 16);
+	CHECK(readU16(bytes, fmt) == 1); // PCM
+	CHECK(readU16(bytes, fmt + 2) == 2);
+	CHECK(readU16(bytes, fmt + 12) == 4);
+	CHECK(readU16(bytes, fmt + 14) == 16);
+	CHECK(readU32(bytes, fmt + 20) == 10 * 4); // The data chunk size
+}
+
+TEST_CASE(wavFileWriterExtensibleFormat)
+{
+	struct Case {
+		AudioFormat format;
+		uint16_t validBits;
+		uint32_t channelMask;
+		uint8_t subFormat;
+	};
+
+	const Case cases[] {
+		{ format(2, 24), 24, 0x3, 1 },
+		{ format(2, 32, 24), 24, 0x3, 1 },
+		{ format(1, 32, 0, true), 32, 0x4, 3 },
+		{ format(6, 16), 16, 0x3F, 1 },
+		{ format(8, 32, 0, true), 32, 0x63F, 3 },
+		{ format(12, 16), 16, 0xFFF, 1 },
+		{ format(24, 16), 16, 0, 1 },
+	};
+
+	const uint8_t guidTail[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+	for (const Case& c : cases)
+	{
+		const auto bytes = writeFile(c.format);
+		const size_t blockAlign = c.format.channels.size() * c.format.bitsPerSample / 8;
+		const auto name = std::to_string(c.format.channels.size()) + " x " + std::to_string(c.format.bitsPerSample);
+
+		CHECK_MESSAGE(bytes.size() == fmt + 40 + 8 + 10 * blockAlign, name);
+		CHECK_MESSAGE(readU32(bytes, fmtChunk + 4) == 40, name);
+		CHECK_MESSAGE(readU16(bytes, fmt) == 0xFFFE, name);
+		CHECK_MESSAGE(readU16(bytes, fmt + 12) == blockAlign, name);
+		CHECK_MESSAGE(readU16(bytes, fmt + 16) == 22, name);
+		CHECK_MESSAGE(readU16(bytes, fmt + 18) == c.validBits, name);
+		CHECK_MESSAGE(readU32(bytes, fmt + 20) == c.channelMask, name);
+		CHECK_MESSAGE(readU16(bytes, fmt + 24) == c.subFormat, name);
+		CHECK_MESSAGE(std::equal(std::begin(guidTail), std::end(guidTail), bytes.begin() + fmt + 26), name);
+		CHECK_MESSAGE(std::equal(bytes.begin() + fmt + 40, bytes.begin() + fmt + 44, "data"), name);
+		CHECK_MESSAGE(readU32(bytes, fmt + 44) == 10 * blockAlign, name);
+	}
+}
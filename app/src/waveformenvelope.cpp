@@ -0,0 +1,68 @@
+#include "waveformenvelope.h"
+
+#include <algorithm>
+
+void buildMinMaxEnvelope(const float* samples, const size_t nSamples, size_t nPixels, std::vector<EnvelopePoint>& points)
+{
+	nPixels = std::max<size_t>(nPixels, 1);
+
+	if (nSamples <= 2 * nPixels)
+	{
+		points.resize(nSamples);
+		for (size_t i = 0; i < nSamples; ++i)
+			points[i] = { static_cast<double>(i), samples[i] };
+
+		return;
+	}
+
+	points.resize(2 * nPixels);
+	for (size_t px = 0; px < nPixels; ++px)
+	{
+		const size_t begin = px * nSamples / nPixels;
+		const size_t end = (px + 1) * nSamples / nPixels;
+
+		const auto [minIt, maxIt] = std::minmax_element(samples + begin, samples + end);
+		// Keep the extremes in their order of occurrence so the trace doesn't zig-zag backwards.
+		const auto* first = std::min(minIt, maxIt);
+		const auto* second = std::max(minIt, maxIt);
+
+		points[2 * px] = { static_cast<double>(first - samples), *first };
+		points[2 * px + 1] = { static_cast<double>(second - samples), *second };
+	}
+}
+
+bool WaveformEnvelope::update(CAudioEngine& engine, const size_t maxFrames, const size_t nPixels)
+{
+	if (!engine.currentSamplesBuffer(_samples, maxFrames))
+		return false;
+
+	const Shape shape{ _samples.height(), _samples.width(), nPixels };
+	_steadyUpdates = shape == _shape ? _steadyUpdates + 1 : 0;
+	_shape = shape;
+
+	_points.resize(_samples.height());
+	for (size_t c = 0; c < _samples.height(); ++c)
+		buildMinMaxEnvelope(_samples[c], _samples.width(), nPixels, _points[c]);
+
+	return true;
+}
+
+size_t WaveformEnvelope::channels() const noexcept
+{
+	return _shape.channels;
+}
+
+size_t WaveformEnvelope::frames() const noexcept
+{
+	return _shape.frames;
+}
+
+const std::vector<EnvelopePoint>& WaveformEnvelope::points(const size_t channel) const noexcept
+{
+	return _points[channel];
+}
+
+size_t WaveformEnvelope::steadyUpdates() const noexcept
+{
+	return _steadyUpdates;
+}
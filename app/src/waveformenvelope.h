@@ -0,0 +1,46 @@
+#pragma once
+#include "audio/caudioengine.h"
+
+#include <stddef.h>
+#include <vector>
+
+struct EnvelopePoint {
+	// In sample index units.
+	double x = 0.0;
+	double y = 0.0;
+};
+
+// Decimates a waveform for plotting: every horizontal pixel gets the min and the max of the samples that fall into it,
+// so the point count depends on the plot width only. The X coordinates stay in sample index units.
+// Buffers too short to need decimation are copied point for point. The capacity of points is reused between calls.
+void buildMinMaxEnvelope(const float* samples, size_t nSamples, size_t nPixels, std::vector<EnvelopePoint>& points);
+
+// What the output waveform chart plots: the envelope of every channel of the most recent output. The buffers are reused, so once
+// the channel count, the frame count and the plot width have stayed the same for two updates, an update doesn't allocate.
+class WaveformEnvelope
+{
+public:
+	// Fetches up to maxFrames of the engine's latest output and rebuilds the envelopes for nPixels; false, changing nothing, if
+	// there's no output.
+	bool update(CAudioEngine& engine, size_t maxFrames, size_t nPixels);
+
+	[[nodiscard]] size_t channels() const noexcept;
+	[[nodiscard]] size_t frames() const noexcept;
+	[[nodiscard]] const std::vector<EnvelopePoint>& points(size_t channel) const noexcept;
+	// How many updates in a row have had the same shape as the one before them.
+	[[nodiscard]] size_t steadyUpdates() const noexcept;
+
+private:
+	vector2D<float> _samples;
+	std::vector<std::vector<EnvelopePoint>> _points;
+
+	struct Shape {
+		size_t channels = 0;
+		size_t frames = 0;
+		size_t pixels = 0;
+
+		bool operator==(const Shape&) const = default;
+	};
+	Shape _shape;
+	size_t _steadyUpdates = 0;
+};